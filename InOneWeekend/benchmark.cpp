@@ -0,0 +1,2542 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "bvh.hpp"
+#include "bvh_cache.hpp"
+#include "camera.hpp"
+#include "chunked_scene.hpp"
+#include "color.hpp"
+#include "environment_map.hpp"
+#include "fast_math.hpp"
+#include "framebuffer_file.hpp"
+#include "hittable.hpp"
+#include "hittable_list.hpp"
+#include "image_writer.hpp"
+#include "interval.hpp"
+#include "irradiance_cache.hpp"
+#include "light_list.hpp"
+#include "material.hpp"
+#include "perf_counters.hpp"
+#include "ray.hpp"
+#include "render_job.hpp"
+#include "scene_cache.hpp"
+#include "scene_editor.hpp"
+#include "scene_generator.hpp"
+#include "space_filling_curve.hpp"
+#include "sphere.hpp"
+#include "texture.hpp"
+#include "texture_cache.hpp"
+#include "texture_file.hpp"
+#include "thread_pool.hpp"
+#include "tone_mapper.hpp"
+#include "triangle_mesh.hpp"
+#include "vector3.hpp"
+#include "wide_bvh.hpp"
+
+namespace
+{
+    using T = double;
+
+    struct Options
+    {
+        std::size_t minCount{1000};
+        std::size_t maxCount{1000000};
+        std::size_t numRays{200000};
+        std::uint64_t seed{1};
+        SceneGenerator<T>::Layout layout{SceneGenerator<T>::Layout::Field};
+        SceneGenerator<T>::SizeDistribution sizes{SceneGenerator<T>::SizeDistribution::Uniform};
+        std::size_t paletteSize{0};
+        std::string checkImage{};
+        double tolerance{0};
+        bool updateReference{false};
+        int ordersWidth{0};
+        int numFrames{0};
+        int toneMapWidth{0};
+        int kernelsWidth{0};
+        int reorderWidth{0};
+        std::string bvhCacheDirectory{};
+        int incrementalWidth{0};
+        std::size_t wideBVHRays{0};
+        int buildThreads{0};
+        std::size_t deepBVHCount{0};
+        int numViews{0};
+        int irradianceCacheWidth{0};
+        int pathGuidingWidth{0};
+        int textureCacheWidth{0};
+        int environmentWidth{0};
+        int outOfCoreWidth{0};
+        int fastMathWidth{0};
+        int bandedWidth{0};
+    };
+
+    void printUsage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " [options]\n"
+                  << "  --min <count>        Smallest scene size (default 1000)\n"
+                  << "  --max <count>        Largest scene size, grown by 10x per step (default 1000000)\n"
+                  << "  --rays <count>       Rays traced per measurement (default 200000)\n"
+                  << "  --seed <n>           Scene generator seed (default 1)\n"
+                  << "  --layout <l>         field | volume (default field)\n"
+                  << "  --sizes <d>          uniform | lognormal | powerlaw (default uniform)\n"
+                  << "  --palette <count>    Shared materials, 0 for one per sphere (default 0)\n"
+                  << "  --check-image <ppm>  Instead of benchmarking, render a reference scene with different\n"
+                  << "                       thread counts and tile sizes, require identical output, and compare\n"
+                  << "                       it with the given image\n"
+                  << "  --tolerance <rmse>   Largest accepted RMSE against the reference, in 8-bit steps (default 0)\n"
+                  << "  --update-reference   With --check-image, write the render as the new reference instead\n"
+                  << "  --orders <width>     Instead of benchmarking, render the --max scene at the given width\n"
+                  << "                       with each tile and pixel order and report time and cache misses\n"
+                  << "  --frames <count>     Instead of benchmarking, render an orbit of the --min scene and\n"
+                  << "                       compare writing frames inline with the asynchronous writer\n"
+                  << "  --tonemap <width>    Instead of benchmarking, time display conversion of a 16:9 frame of\n"
+                  << "                       the given width (15360 for 16K) with every tone mapping setting\n"
+                  << "  --kernels <width>    Instead of benchmarking, render the --min scene at the given width\n"
+                  << "                       in several configurations with the generic and the specialized kernel\n"
+                  << "  --reorder <width>    Instead of benchmarking, render the --max scene at the given width\n"
+                  << "                       with rays traced in path order and sorted per bounce\n"
+                  << "  --bvh-cache <dir>    Instead of benchmarking, build, save and map the tree of every scene\n"
+                  << "                       size in the directory and compare hits of the built and mapped trees\n"
+                  << "  --incremental <width> Instead of benchmarking, render the --min scene at the given width,\n"
+                  << "                       edit a sphere near the image center and re-render incrementally\n"
+                  << "  --wide-bvh <rays>    Instead of benchmarking, trace the given number of rays through\n"
+                  << "                       binary, 4-wide and 8-wide trees of every scene size\n"
+                  << "  --build <threads>    Instead of benchmarking, time SAH and Morton builds of every scene\n"
+                  << "                       size on 1, 2, 4, ... up to the given number of threads\n"
+                  << "  --deep-bvh <count>   Instead of benchmarking, build SAH and Morton trees over a cluster of\n"
+                  << "                       the given number of boxes with outliers at growing distances, and\n"
+                  << "                       require both to fit the traversal stack\n"
+                  << "  --views <count>      Instead of benchmarking, render a turntable of the given number of\n"
+                  << "                       small views of the --min scene one by one and as one batch\n"
+                  << "  --irradiance-cache <width>\n"
+                  << "                       Instead of benchmarking, render the --min scene at the given width\n"
+                  << "                       path traced and with an irradiance cache, against a high-spp reference\n"
+                  << "  --path-guiding <width>\n"
+                  << "                       Instead of benchmarking, render the --min scene at the given width\n"
+                  << "                       with and without path guiding, against a high-spp reference\n"
+                  << "  --texture-cache <width>\n"
+                  << "                       Instead of benchmarking, render the --min scene at the given width\n"
+                  << "                       with image textures read through texture caches of several sizes\n"
+                  << "  --environment <width>\n"
+                  << "                       Instead of benchmarking, render the --min scene at the given width\n"
+                  << "                       under an HDR sky with a small sun, sampled uniformly and by importance\n"
+                  << "  --out-of-core <width>\n"
+                  << "                       Instead of benchmarking, render the --max scene at the given width\n"
+                  << "                       from memory and streamed from a chunk file under several budgets\n"
+                  << "  --fast-math <width>  Instead of benchmarking, time the approximations of the fast math tier\n"
+                  << "                       against libm, then render the --min scene at the given width with the\n"
+                  << "                       tier this binary was built with\n"
+                  << "  --banded <width>     Instead of benchmarking, render the --min scene at the given width\n"
+                  << "                       in memory and in row bands into mapped PPM and PFM files\n";
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            if (arg == "--update-reference")
+            {
+                options.updateReference = true;
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            const std::string value = argv[++i];
+
+            if (arg == "--min")
+            {
+                options.minCount = std::stoull(value);
+            }
+            else if (arg == "--max")
+            {
+                options.maxCount = std::stoull(value);
+            }
+            else if (arg == "--rays")
+            {
+                options.numRays = std::stoull(value);
+            }
+            else if (arg == "--seed")
+            {
+                options.seed = std::stoull(value);
+            }
+            else if (arg == "--palette")
+            {
+                options.paletteSize = std::stoull(value);
+            }
+            else if (arg == "--check-image")
+            {
+                options.checkImage = value;
+            }
+            else if (arg == "--tolerance")
+            {
+                options.tolerance = std::stod(value);
+            }
+            else if (arg == "--orders")
+            {
+                options.ordersWidth = std::stoi(value);
+            }
+            else if (arg == "--frames")
+            {
+                options.numFrames = std::stoi(value);
+            }
+            else if (arg == "--tonemap")
+            {
+                options.toneMapWidth = std::stoi(value);
+            }
+            else if (arg == "--kernels")
+            {
+                options.kernelsWidth = std::stoi(value);
+            }
+            else if (arg == "--reorder")
+            {
+                options.reorderWidth = std::stoi(value);
+            }
+            else if (arg == "--bvh-cache")
+            {
+                options.bvhCacheDirectory = value;
+            }
+            else if (arg == "--incremental")
+            {
+                options.incrementalWidth = std::stoi(value);
+            }
+            else if (arg == "--wide-bvh")
+            {
+                options.wideBVHRays = std::stoull(value);
+            }
+            else if (arg == "--build")
+            {
+                options.buildThreads = std::stoi(value);
+            }
+            else if (arg == "--deep-bvh")
+            {
+                options.deepBVHCount = std::stoull(value);
+            }
+            else if (arg == "--views")
+            {
+                options.numViews = std::stoi(value);
+            }
+            else if (arg == "--irradiance-cache")
+            {
+                options.irradianceCacheWidth = std::stoi(value);
+            }
+            else if (arg == "--path-guiding")
+            {
+                options.pathGuidingWidth = std::stoi(value);
+            }
+            else if (arg == "--texture-cache")
+            {
+                options.textureCacheWidth = std::stoi(value);
+            }
+            else if (arg == "--environment")
+            {
+                options.environmentWidth = std::stoi(value);
+            }
+            else if (arg == "--out-of-core")
+            {
+                options.outOfCoreWidth = std::stoi(value);
+            }
+            else if (arg == "--fast-math")
+            {
+                options.fastMathWidth = std::stoi(value);
+            }
+            else if (arg == "--banded")
+            {
+                options.bandedWidth = std::stoi(value);
+            }
+            else if (arg == "--layout" && (value == "field" || value == "volume"))
+            {
+                options.layout = (value == "field") ? SceneGenerator<T>::Layout::Field
+                                                    : SceneGenerator<T>::Layout::Volume;
+            }
+            else if (arg == "--sizes" && value == "uniform")
+            {
+                options.sizes = SceneGenerator<T>::SizeDistribution::Uniform;
+            }
+            else if (arg == "--sizes" && value == "lognormal")
+            {
+                options.sizes = SceneGenerator<T>::SizeDistribution::LogNormal;
+            }
+            else if (arg == "--sizes" && value == "powerlaw")
+            {
+                options.sizes = SceneGenerator<T>::SizeDistribution::PowerLaw;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return options.minCount > 0 && options.minCount <= options.maxCount;
+    }
+
+    // A field of /proc/self/status in bytes, 0 where there is none
+    std::size_t processStatusBytes(const std::string &field)
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.starts_with(field + ":"))
+            {
+                return 1024 * std::stoull(line.substr(field.size() + 1));
+            }
+        }
+        return 0;
+    }
+
+    // Starts a new peak of the resident set size (VmHWM)
+    void resetPeakResidentBytes()
+    {
+        std::ofstream("/proc/self/clear_refs") << "5";
+    }
+
+    std::size_t heapBytesInUse()
+    {
+#ifdef __GLIBC__
+        return mallinfo2().uordblks;
+#else
+        return 0;
+#endif
+    }
+
+    // Rays from a viewpoint above the scene towards random points of it, coherent like camera rays
+    std::vector<Ray<T>> primaryRays(const AABB<T> &bounds, std::size_t count, std::mt19937_64 &engine)
+    {
+        std::uniform_real_distribution<T> unit(0, 1);
+        const auto center = bounds.centroid();
+        const T size = bounds.x().size();
+        const Point3<T> origin(center.x(), bounds.y().max() + size / 4, center.z() + size);
+
+        std::vector<Ray<T>> rays;
+        rays.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const Point3<T> target(bounds.x().min() + unit(engine) * size,
+                                   0,
+                                   bounds.z().min() + unit(engine) * bounds.z().size());
+            rays.emplace_back(origin, target - origin);
+        }
+        return rays;
+    }
+
+    // Rays starting anywhere inside the scene in uniformly random directions, like diffuse bounces
+    std::vector<Ray<T>> incoherentRays(const AABB<T> &bounds, std::size_t count, std::mt19937_64 &engine)
+    {
+        std::uniform_real_distribution<T> unit(0, 1);
+        std::normal_distribution<T> normal(0, 1);
+
+        std::vector<Ray<T>> rays;
+        rays.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const Point3<T> origin(bounds.x().min() + unit(engine) * bounds.x().size(),
+                                   bounds.y().min() + unit(engine) * bounds.y().size(),
+                                   bounds.z().min() + unit(engine) * bounds.z().size());
+            const Vector3<T> direction(normal(engine), normal(engine), normal(engine));
+            rays.emplace_back(origin, direction);
+        }
+        return rays;
+    }
+
+    // 8-bit image as written to PPM files
+    struct Image
+    {
+        int width{0};
+        int height{0};
+        std::vector<std::uint8_t> bytes{};
+    };
+
+    Image renderReference(const Options &options, int numThreads, int tileSize)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(500);
+        generator.setSeed(options.seed);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+
+        const T extent = generator.extent();
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(96);
+        camera.setNumSamplesPerPixel(16);
+        camera.setMaxReflection(8);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookFrom(Point3<T>(0, extent / 4, extent / 2));
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setDefocusAngle_deg(0.5);
+        camera.setFocusDist(extent / 2);
+        camera.setNumThreads(numThreads);
+        camera.setTileSize(tileSize);
+
+        const auto framebuffer = camera.renderImage(bvh, LightList<T>());
+
+        Image image;
+        image.width = camera.imageWidth();
+        image.height = static_cast<int>(framebuffer.size()) / image.width;
+        image.bytes.reserve(3 * framebuffer.size());
+        for (const auto &pixelColor : framebuffer)
+        {
+            const auto bytes = toBytes(pixelColor);
+            image.bytes.insert(image.bytes.end(), bytes.begin(), bytes.end());
+        }
+        return image;
+    }
+
+    // FNV-1a, enough to tell renders apart at a glance
+    std::uint64_t imageHash(const Image &image)
+    {
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        for (const auto byte : image.bytes)
+        {
+            hash = (hash ^ byte) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    void writeImage(const std::string &path, const Image &image)
+    {
+        std::ofstream out(path);
+        out << "P3\n"
+            << image.width << ' ' << image.height << "\n255\n";
+        for (std::size_t i = 0; i < image.bytes.size(); i += 3)
+        {
+            out << static_cast<int>(image.bytes[i]) << ' '
+                << static_cast<int>(image.bytes[i + 1]) << ' '
+                << static_cast<int>(image.bytes[i + 2]) << '\n';
+        }
+    }
+
+    bool readImage(const std::string &path, Image &image)
+    {
+        std::ifstream in(path);
+        std::string magic;
+        int maxValue = 0;
+        if (!(in >> magic >> image.width >> image.height >> maxValue) || magic != "P3" || maxValue != 255)
+        {
+            return false;
+        }
+
+        image.bytes.resize(3 * static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.height));
+        for (auto &byte : image.bytes)
+        {
+            int value = 0;
+            if (!(in >> value))
+            {
+                return false;
+            }
+            byte = static_cast<std::uint8_t>(value);
+        }
+        return true;
+    }
+
+    double rmse(const Image &a, const Image &b)
+    {
+        double sum = 0;
+        for (std::size_t i = 0; i < a.bytes.size(); ++i)
+        {
+            const double difference = static_cast<double>(a.bytes[i]) - static_cast<double>(b.bytes[i]);
+            sum += difference * difference;
+        }
+        return std::sqrt(sum / static_cast<double>(a.bytes.size()));
+    }
+
+    // Output must not depend on how the work is split, and must match the stored reference
+    int checkImage(const Options &options)
+    {
+        const Image serial = renderReference(options, 1, 16);
+        const Image parallel = renderReference(options, 4, 7);
+        const std::uint64_t hash = imageHash(serial);
+
+        std::cout << "shading math: " << FastMath::tierName() << '\n'
+                  << "image hash 1 thread, 16 px tiles: " << std::hex << hash << '\n'
+                  << "image hash 4 threads, 7 px tiles: " << imageHash(parallel) << std::dec << '\n';
+        if (serial.bytes != parallel.bytes)
+        {
+            std::cout << "FAIL: output depends on thread count or tiling\n";
+            return EXIT_FAILURE;
+        }
+
+        // A missing reference fails, so that no build can bless its own output
+        if (options.updateReference)
+        {
+            writeImage(options.checkImage, serial);
+            std::cout << "reference written to " << options.checkImage << '\n';
+            return EXIT_SUCCESS;
+        }
+        if (!std::filesystem::exists(options.checkImage))
+        {
+            std::cout << "FAIL: no reference at " << options.checkImage << ", write one with --update-reference\n";
+            return EXIT_FAILURE;
+        }
+
+        Image reference;
+        if (!readImage(options.checkImage, reference) || reference.width != serial.width || reference.height != serial.height)
+        {
+            std::cout << "FAIL: " << options.checkImage << " is not a " << serial.width << "x" << serial.height << " P3 image\n";
+            return EXIT_FAILURE;
+        }
+
+        const double error = rmse(serial, reference);
+        std::cout << "reference hash: " << std::hex << imageHash(reference) << std::dec
+                  << ", RMSE " << std::setprecision(4) << error << '\n';
+        if (error > options.tolerance)
+        {
+            std::cout << "FAIL: RMSE above tolerance " << options.tolerance << '\n';
+            return EXIT_FAILURE;
+        }
+        std::cout << "OK\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::string perSample(const PerfCounters &counters, PerfCounters::Event event, double numSamples)
+    {
+        const auto count = counters.value(event);
+        if (!count)
+        {
+            return "n/a";
+        }
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(1) << static_cast<double>(*count) / numSamples;
+        return text.str();
+    }
+
+    // Same render of a large scene with every traversal order. The image is identical for all
+    // of them, only the order of the work differs.
+    int compareOrders(const Options &options)
+    {
+        using SpaceFillingCurve::Order;
+
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.maxCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+
+        const T extent = generator.extent();
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(options.ordersWidth);
+        camera.setNumSamplesPerPixel(4);
+        camera.setMaxReflection(8);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookFrom(Point3<T>(0, extent / 4, extent / 2));
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setFocusDist(extent / 2);
+
+        const double numSamples = static_cast<double>(options.ordersWidth) *
+                                  static_cast<double>(options.ordersWidth) * 9 / 16 * camera.numSamplesPerPixel();
+
+        std::cout << options.maxCount << " objects, " << options.ordersWidth << " px wide, "
+                  << camera.numSamplesPerPixel() << " spp\n"
+                  << std::setw(12) << "tiles"
+                  << std::setw(12) << "pixels"
+                  << std::setw(10) << "time [s]"
+                  << std::setw(14) << "Msample/s"
+                  << std::setw(10) << "speedup"
+                  << std::setw(16) << "L1D miss/smp"
+                  << std::setw(16) << "LLC miss/smp"
+                  << std::setw(16) << "instr/smp" << '\n';
+
+        PerfCounters counters;
+        double baselineSeconds = 0;
+        for (const auto order : {Order::RowMajor, Order::Morton, Order::Hilbert})
+        {
+            camera.setTileOrder(order);
+            camera.setPixelOrder(order);
+
+            counters.start();
+            const auto start = std::chrono::steady_clock::now();
+            camera.renderImage(bvh, LightList<T>());
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            counters.stop();
+
+            baselineSeconds = (order == Order::RowMajor) ? seconds : baselineSeconds;
+            std::cout << std::fixed
+                      << std::setw(12) << SpaceFillingCurve::name(order)
+                      << std::setw(12) << SpaceFillingCurve::name(order)
+                      << std::setw(10) << std::setprecision(2) << seconds
+                      << std::setw(14) << std::setprecision(3) << numSamples / seconds / 1e6
+                      << std::setw(10) << std::setprecision(3) << baselineSeconds / seconds
+                      << std::setw(16) << perSample(counters, PerfCounters::Event::L1DataReadMisses, numSamples)
+                      << std::setw(16) << perSample(counters, PerfCounters::Event::LastLevelReadMisses, numSamples)
+                      << std::setw(16) << perSample(counters, PerfCounters::Event::Instructions, numSamples) << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Multi-frame job: a camera orbiting the scene, every frame written as a plain PPM. With the
+    // writer thread, frame N is encoded while frame N + 1 renders.
+    int compareFrameOutput(const Options &options)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+
+        const T extent = generator.extent();
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(640);
+        camera.setNumSamplesPerPixel(1);
+        camera.setMaxReflection(4);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setFocusDist(extent / 2);
+
+        const auto directory = std::filesystem::temp_directory_path() / "raytracer_frames";
+        std::filesystem::create_directories(directory);
+
+        const auto framePath = [&](int frame)
+        {
+            return (directory / ("frame_" + std::to_string(frame) + ".ppm")).string();
+        };
+        const auto placeCamera = [&](int frame)
+        {
+            const T angle = 2 * pi<T> * frame / options.numFrames;
+            camera.setLookFrom(Point3<T>((extent / 2) * std::sin(angle), extent / 4, (extent / 2) * std::cos(angle)));
+        };
+
+        double renderSeconds = 0;
+        double writeSeconds = 0;
+        const auto inlineStart = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < options.numFrames; ++frame)
+        {
+            placeCamera(frame);
+            const auto renderStart = std::chrono::steady_clock::now();
+            auto pixels = camera.renderImage(bvh, LightList<T>());
+            const auto writeStart = std::chrono::steady_clock::now();
+            const int height = static_cast<int>(pixels.size()) / camera.imageWidth();
+            ImageWriter<T>::write(ImageWriter<T>::Frame{framePath(frame), camera.imageWidth(), height, std::move(pixels)});
+            const auto writeEnd = std::chrono::steady_clock::now();
+
+            renderSeconds += std::chrono::duration<double>(writeStart - renderStart).count();
+            writeSeconds += std::chrono::duration<double>(writeEnd - writeStart).count();
+        }
+        const double inlineSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - inlineStart).count();
+
+        ImageWriter<T> writer;
+        const auto pipelinedStart = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < options.numFrames; ++frame)
+        {
+            placeCamera(frame);
+            camera.render(bvh, LightList<T>(), writer, framePath(frame));
+        }
+        writer.finish();
+        const double pipelinedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pipelinedStart).count();
+
+        std::filesystem::remove_all(directory);
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << options.numFrames << " frames of " << options.minCount << " objects\n"
+                  << "inline:    " << inlineSeconds << " s (render " << renderSeconds << " s, write " << writeSeconds << " s)\n"
+                  << "pipelined: " << pipelinedSeconds << " s (writer thread busy " << writer.busySeconds() << " s)\n"
+                  << "speedup:   " << inlineSeconds / pipelinedSeconds << '\n';
+        return EXIT_SUCCESS;
+    }
+
+    // Forwards to a scene and counts the closest-hit queries, i.e. the path segments traced
+    class CountingHittable : public Hittable<T>
+    {
+    public:
+        explicit CountingHittable(const Hittable<T> &world) : m_world(world) {}
+
+        virtual bool intersect(const Ray<T> &r, Interval<T> rayT, SurfaceHit<T> &surface) const override
+        {
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            return m_world.intersect(r, rayT, surface);
+        }
+
+        virtual bool occluded(const Ray<T> &r, Interval<T> rayT) const override
+        {
+            return m_world.occluded(r, rayT);
+        }
+
+        virtual AABB<T> boundingBox() const override { return m_world.boundingBox(); }
+
+        std::uint64_t count() const { return m_count.load(); }
+        void reset() { m_count = 0; }
+
+    private:
+        const Hittable<T> &m_world;
+        mutable std::atomic<std::uint64_t> m_count{0};
+    };
+
+    // Largest relative difference between two renders of the same paths. The compiler may fuse
+    // multiply-adds differently in different kernels.
+    constexpr double s_maxRenderDifference = 1e-9;
+
+    // Seed of reference renders that other renders of the same settings are compared to
+    constexpr std::uint64_t s_referenceSeed = 0x5EEDF00Dull;
+
+    double maxRelativeDifference(const std::vector<Color<T>> &a, const std::vector<Color<T>> &b)
+    {
+        double difference = 0;
+        for (std::size_t i = 0; i < a.size() && i < b.size(); ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                const double x = a[i][c];
+                const double y = b[i][c];
+                difference = std::max(difference, std::abs(x - y) / std::max({std::abs(x), std::abs(y), 1e-300}));
+            }
+        }
+        return difference;
+    }
+
+    // Renders of one scene in configurations that select different kernels, each with the generic
+    // kernel, which tests the camera settings for every sample and bounce, and with the kernel
+    // compiled for them
+    int compareKernels(const Options &options)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        auto world = generator.generate();
+
+        // A light above the scene for next-event estimation
+        const T extent = generator.extent();
+        const auto light = std::make_shared<Sphere<T>>(Point3<T>(0, extent / 2, 0), extent / 8,
+                                                       std::make_shared<DiffuseLight<T>>(Color<T>(4, 4, 4)));
+        world.add(light);
+        LightList<T> lights;
+        lights.add(light);
+        const LightList<T> noLights;
+        const BVH<T> bvh(world);
+
+        // The same spheres all Lambertian and without the light, traced by kernels that skip
+        // emission and specular bounces
+        generator.setMaterialMix(1, 0, 0);
+        const BVH<T> diffuseBVH(generator.generate());
+
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(options.kernelsWidth);
+        camera.setNumSamplesPerPixel(4);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookFrom(Point3<T>(0, extent / 4, extent / 2));
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setFocusDist(extent / 2);
+
+        struct Configuration
+        {
+            const char *name;
+            T defocusAngle_deg;
+            int maxReflection;
+            bool withLights;
+            bool diffuse;
+        };
+        const Configuration configurations[] = {
+            {"pinhole, depth 8", 0, 8, false, false},
+            {"defocus, depth 8", 1, 8, false, false},
+            {"pinhole, roulette", 0, -1, false, false},
+            {"pinhole, depth 8, light", 0, 8, true, false},
+            {"defocus, roulette, light", 1, -1, true, false},
+            {"diffuse, depth 8", 0, 8, false, true},
+            {"diffuse, roulette", 0, -1, false, true},
+        };
+
+        std::cout << options.minCount << " objects, " << options.kernelsWidth << " px wide, "
+                  << camera.numSamplesPerPixel() << " spp\n"
+                  << std::setw(26) << "configuration"
+                  << std::setw(14) << "generic [s]"
+                  << std::setw(16) << "specialized [s]"
+                  << std::setw(10) << "speedup"
+                  << std::setw(14) << "max rel diff" << '\n';
+
+        bool allEqual = true;
+        for (const auto &configuration : configurations)
+        {
+            camera.setDefocusAngle_deg(configuration.defocusAngle_deg);
+            camera.setMaxReflection(configuration.maxReflection);
+            const LightList<T> &used = configuration.withLights ? lights : noLights;
+
+            double seconds[2] = {0, 0};
+            std::vector<Color<T>> images[2];
+            for (int specialized = 0; specialized < 2; ++specialized)
+            {
+                camera.setSpecializedKernels(specialized == 1);
+                const auto start = std::chrono::steady_clock::now();
+                images[specialized] = camera.renderImage(configuration.diffuse ? diffuseBVH : bvh, used);
+                seconds[specialized] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            const double difference = maxRelativeDifference(images[0], images[1]);
+            allEqual = allEqual && difference <= s_maxRenderDifference;
+
+            std::cout << std::fixed << std::setprecision(3)
+                      << std::setw(26) << configuration.name
+                      << std::setw(14) << seconds[0]
+                      << std::setw(16) << seconds[1]
+                      << std::setw(10) << seconds[0] / seconds[1]
+                      << std::setw(14) << std::scientific << std::setprecision(1) << difference << std::endl;
+        }
+        return allEqual ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Secondary ray throughput with and without sorting the rays of a tile before each bounce.
+    // Rays of depth two and more are what a render to depth 8 traces beyond one to depth 1.
+    int compareRayReordering(const Options &options)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.maxCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+        CountingHittable counted(bvh);
+
+        const T extent = generator.extent();
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(options.reorderWidth);
+        camera.setNumSamplesPerPixel(16);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookFrom(Point3<T>(0, extent / 4, extent / 2));
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setFocusDist(extent / 2);
+
+        std::cout << options.maxCount << " objects, " << options.reorderWidth << " px wide, "
+                  << camera.numSamplesPerPixel() << " spp\n"
+                  << std::setw(12) << "rays"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(14) << "all Mray/s"
+                  << std::setw(16) << "depth>=2 Mray/s"
+                  << std::setw(10) << "speedup" << '\n';
+
+        std::vector<Color<T>> images[2];
+        double baselineThroughput = 0;
+        for (const bool reorder : {false, true})
+        {
+            camera.setRayReordering(reorder);
+
+            double seconds[2] = {0, 0};
+            std::uint64_t rays[2] = {0, 0};
+            const int depths[2] = {1, 8};
+            for (int d = 0; d < 2; ++d)
+            {
+                camera.setMaxReflection(depths[d]);
+                counted.reset();
+                const auto start = std::chrono::steady_clock::now();
+                auto image = camera.renderImage(counted, LightList<T>());
+                seconds[d] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                rays[d] = counted.count();
+                if (d == 1)
+                {
+                    images[reorder ? 1 : 0] = std::move(image);
+                }
+            }
+
+            const double throughput = static_cast<double>(rays[1] - rays[0]) / (seconds[1] - seconds[0]) / 1e6;
+            baselineThroughput = reorder ? baselineThroughput : throughput;
+            std::cout << std::fixed << std::setprecision(3)
+                      << std::setw(12) << (reorder ? "sorted" : "path order")
+                      << std::setw(12) << seconds[1]
+                      << std::setw(14) << static_cast<double>(rays[1]) / seconds[1] / 1e6
+                      << std::setw(16) << throughput
+                      << std::setw(10) << throughput / baselineThroughput << std::endl;
+        }
+
+        const double difference = maxRelativeDifference(images[0], images[1]);
+        std::cout << "max relative pixel difference: " << std::scientific << std::setprecision(1) << difference << '\n';
+        return (difference <= s_maxRenderDifference) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Display conversion of a synthetic HDR frame. Only a band of rows is held in memory and
+    // mapped repeatedly, since a 16K frame of double colors alone would take 3 GB.
+    int compareToneMapping(const Options &options)
+    {
+        const auto width = static_cast<std::size_t>(options.toneMapWidth);
+        const std::size_t height = width * 9 / 16;
+        const std::size_t bandHeight = 64;
+
+        std::mt19937_64 engine(options.seed);
+        std::uniform_real_distribution<T> logRadiance(-7, 5);
+        std::vector<Color<T>> band(width * bandHeight);
+        for (auto &pixel : band)
+        {
+            pixel = Color<T>(std::exp2(logRadiance(engine)), std::exp2(logRadiance(engine)), std::exp2(logRadiance(engine)));
+        }
+        std::vector<std::uint8_t> bytes(3 * width);
+
+        const auto frameSeconds = [&](const auto &mapRow)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t y = 0; y < height; ++y)
+            {
+                mapRow(band.data() + (y % bandHeight) * width, y);
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        const auto report = [&](const std::string &label, double seconds)
+        {
+            std::cout << std::setw(24) << label
+                      << std::setw(12) << std::setprecision(1) << seconds * 1e3
+                      << std::setw(14) << std::setprecision(1) << static_cast<double>(width * height) / seconds / 1e6 << '\n';
+        };
+
+        std::cout << std::fixed << width << "x" << height << " frame\n"
+                  << std::setw(24) << "conversion"
+                  << std::setw(12) << "ms/frame"
+                  << std::setw(14) << "Mpixel/s" << '\n';
+
+        report("writeColor (std::pow)", frameSeconds([&](const Color<T> *row, std::size_t)
+                                                     {
+                                                         for (std::size_t x = 0; x < width; ++x)
+                                                         {
+                                                             const auto pixel = toBytes(row[x]);
+                                                             bytes[3 * x] = pixel[0];
+                                                             bytes[3 * x + 1] = pixel[1];
+                                                             bytes[3 * x + 2] = pixel[2];
+                                                         } }));
+
+        ToneMapper toneMapper;
+        for (const auto toneOperator : {ToneMapper::Operator::Clamp, ToneMapper::Operator::Reinhard, ToneMapper::Operator::ACES})
+        {
+            for (const bool dithering : {false, true})
+            {
+                toneMapper.setOperator(toneOperator);
+                toneMapper.setDithering(dithering);
+                const std::string label = std::string(toneOperator == ToneMapper::Operator::Clamp      ? "clamp"
+                                                      : toneOperator == ToneMapper::Operator::Reinhard ? "reinhard"
+                                                                                                       : "aces") +
+                                          (dithering ? " + dither" : "");
+                report(label, frameSeconds([&](const Color<T> *row, std::size_t y)
+                                           { toneMapper.mapRow(row, width, y, bytes.data()); }));
+            }
+        }
+
+        // The same conversion with the rows of every band spread over all hardware threads
+        ThreadPool threadPool;
+        std::vector<std::uint8_t> bandBytes(3 * width * bandHeight);
+        for (const auto toneOperator : {ToneMapper::Operator::Clamp, ToneMapper::Operator::ACES})
+        {
+            toneMapper.setOperator(toneOperator);
+            toneMapper.setDithering(toneOperator == ToneMapper::Operator::ACES);
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t y = 0; y < height; y += bandHeight)
+            {
+                toneMapper.mapRows(band.data(), width, y, std::min(bandHeight, height - y), bandBytes.data(), &threadPool);
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            report(std::string(toneOperator == ToneMapper::Operator::Clamp ? "clamp" : "aces + dither") + ", " +
+                       std::to_string(threadPool.numThreads()) + " threads",
+                   seconds);
+        }
+
+        // Accuracy of the polynomial transfer curves against std::pow
+        for (const auto transfer : {ToneMapper::Transfer::Gamma22, ToneMapper::Transfer::SRGB})
+        {
+            toneMapper.setTransfer(transfer);
+            float maxError = 0;
+            for (int i = 0; i <= 1000000; ++i)
+            {
+                const float value = static_cast<float>(i) / 1e6f;
+                maxError = std::max(maxError, std::abs(toneMapper.fastTransfer(value) - toneMapper.referenceTransfer(value)));
+            }
+            std::cout << (transfer == ToneMapper::Transfer::SRGB ? "sRGB" : "gamma 2.2")
+                      << " transfer max error: " << std::setprecision(5) << maxError * 256 << " of an 8-bit step\n";
+        }
+        return EXIT_SUCCESS;
+    }
+
+    double traceMraysPerSecond(const Hittable<T> &world, const std::vector<Ray<T>> &rays, std::size_t &hits)
+    {
+        hits = 0;
+        HitRecord<T> record;
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &ray : rays)
+        {
+            if (world.hit(ray, Interval<T>(static_cast<T>(0.001), infinity<T>), record))
+            {
+                ++hits;
+            }
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(rays.size()) / seconds / 1e6;
+    }
+
+    double occludedMraysPerSecond(const Hittable<T> &world, const std::vector<Ray<T>> &rays, std::size_t &blocked)
+    {
+        blocked = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &ray : rays)
+        {
+            if (world.occluded(ray, Interval<T>(static_cast<T>(0.001), infinity<T>)))
+            {
+                ++blocked;
+            }
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(rays.size()) / seconds / 1e6;
+    }
+
+    // Startup cost of a scene with a built and with a mapped tree. The file is read back right
+    // after it is written, so it comes from the page cache as on a repeated render; the mapped
+    // tree must give exactly the hits of the built one.
+    int compareBVHCache(const Options &options)
+    {
+        const BVHCache<T> cache(options.bvhCacheDirectory);
+
+        std::cout << std::setw(10) << "objects"
+                  << std::setw(12) << "gen [s]"
+                  << std::setw(12) << "build [s]"
+                  << std::setw(12) << "save [s]"
+                  << std::setw(12) << "map [s]"
+                  << std::setw(12) << "file MB"
+                  << std::setw(14) << "built Mray/s"
+                  << std::setw(15) << "mapped Mray/s"
+                  << std::setw(12) << "mismatches" << '\n';
+
+        bool allEqual = true;
+        for (std::size_t count = options.minCount; count <= options.maxCount; count *= 10)
+        {
+            RenderJob<T> job;
+            job.objectCount = count;
+            job.layout = options.layout;
+            job.sizes = options.sizes;
+            job.paletteSize = options.paletteSize;
+            job.sceneSeed = options.seed;
+            const std::uint64_t key = job.sceneKey();
+
+            SceneGenerator<T> generator;
+            generator.setObjectCount(count);
+            generator.setSeed(options.seed);
+            generator.setLayout(options.layout);
+            generator.setSizeDistribution(options.sizes);
+            generator.setMaterialPaletteSize(options.paletteSize);
+
+            const auto generateStart = std::chrono::steady_clock::now();
+            const auto world = generator.generate();
+            const auto buildStart = std::chrono::steady_clock::now();
+            const BVH<T> built(world);
+            const auto saveStart = std::chrono::steady_clock::now();
+            cache.save(key, built.tree());
+            const auto mapStart = std::chrono::steady_clock::now();
+            auto tree = cache.load(key, world.objects().size());
+            const auto mapEnd = std::chrono::steady_clock::now();
+            if (!tree)
+            {
+                std::cerr << "Cannot load " << cache.path(key) << '\n';
+                return EXIT_FAILURE;
+            }
+            const BVH<T> mapped(world, std::move(*tree));
+
+            std::mt19937_64 engine(options.seed);
+            const auto rays = incoherentRays(built.boundingBox(), options.numRays, engine);
+            std::size_t builtHits = 0;
+            std::size_t mappedHits = 0;
+            const double builtMrays = traceMraysPerSecond(built, rays, builtHits);
+            const double mappedMrays = traceMraysPerSecond(mapped, rays, mappedHits);
+
+            std::size_t mismatches = 0;
+            for (const auto &ray : rays)
+            {
+                HitRecord<T> records[2];
+                const Interval<T> rayT(static_cast<T>(0.001), infinity<T>);
+                const bool hits[2] = {built.hit(ray, rayT, records[0]), mapped.hit(ray, rayT, records[1])};
+                if (hits[0] != hits[1] || (hits[0] && (records[0].t() != records[1].t() ||
+                                                       records[0].object() != records[1].object())))
+                {
+                    ++mismatches;
+                }
+            }
+            allEqual = allEqual && mismatches == 0;
+
+            const auto seconds = [](auto begin, auto end)
+            {
+                return std::chrono::duration<double>(end - begin).count();
+            };
+            std::cout << std::fixed
+                      << std::setw(10) << count
+                      << std::setw(12) << std::setprecision(3) << seconds(generateStart, buildStart)
+                      << std::setw(12) << std::setprecision(3) << seconds(buildStart, saveStart)
+                      << std::setw(12) << std::setprecision(3) << seconds(saveStart, mapStart)
+                      << std::setw(12) << std::setprecision(3) << seconds(mapStart, mapEnd)
+                      << std::setw(12) << std::setprecision(1) << static_cast<double>(std::filesystem::file_size(cache.path(key))) / 1e6
+                      << std::setw(14) << std::setprecision(2) << builtMrays
+                      << std::setw(15) << std::setprecision(2) << mappedMrays
+                      << std::setw(12) << mismatches << std::endl;
+        }
+        return allEqual ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Look-dev edits of one sphere near the image center, each followed by an incremental
+    // render. Tiles are traced with the same samples as in a full render, so the incremental
+    // image only differs from a full render of the edited scene where an edit changed what a
+    // path saw beyond its first bounce.
+    int compareIncrementalRender(const Options &options)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        const auto world = generator.generate();
+        BVH<T> bvh(world);
+
+        std::shared_ptr<Sphere<T>> target;
+        for (const auto &object : world.objects())
+        {
+            const auto sphere = std::dynamic_pointer_cast<Sphere<T>>(object);
+            if (sphere && sphere->radius() <= generator.maxRadius() &&
+                (!target || sphere->center().squaredNorm() < target->center().squaredNorm()))
+            {
+                target = sphere;
+            }
+        }
+        if (!target)
+        {
+            std::cerr << "No sphere to edit\n";
+            return EXIT_FAILURE;
+        }
+
+        const T extent = generator.extent();
+        const Point3<T> lookAt = target->center();
+        const auto setUp = [&](Camera<T> &camera)
+        {
+            camera.setAspectRatio(16.0 / 9.0);
+            camera.setImageWidth(options.incrementalWidth);
+            camera.setNumSamplesPerPixel(16);
+            camera.setMaxReflection(8);
+            camera.setVerticalFOV_deg(20);
+            camera.setLookFrom(Point3<T>(0, extent / 8, extent / 4));
+            camera.setLookAt(lookAt);
+            camera.setFocusDist(extent / 4);
+        };
+
+        Camera<T> camera;
+        setUp(camera);
+        camera.setIncremental(true);
+        SceneEditor<T> editor(bvh, camera);
+
+        const auto timed = [](auto &&render)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            auto image = render();
+            return std::pair{std::move(image), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+        };
+
+        const auto [first, fullSeconds] = timed([&]
+                                                { return camera.renderImage(bvh, LightList<T>()); });
+        const std::size_t numTiles = camera.numTilesRendered();
+
+        std::cout << options.minCount << " objects, " << options.incrementalWidth << " px wide, "
+                  << camera.numSamplesPerPixel() << " spp, full frame " << std::fixed << std::setprecision(3)
+                  << fullSeconds << " s\n"
+                  << std::setw(16) << "edit"
+                  << std::setw(10) << "tiles"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(10) << "speedup"
+                  << std::setw(14) << "pixels off"
+                  << std::setw(14) << "max diff" << '\n';
+
+        const auto edit = [&](const char *name, auto &&apply)
+        {
+            apply();
+            const auto [image, seconds] = timed([&]
+                                                { return camera.renderImage(bvh, LightList<T>()); });
+            const std::size_t numRendered = camera.numTilesRendered();
+
+            Camera<T> reference;
+            setUp(reference);
+            const auto expected = reference.renderImage(bvh, LightList<T>());
+            std::size_t numDiffering = 0;
+            for (std::size_t i = 0; i < image.size(); ++i)
+            {
+                if (maxRelativeDifference({image[i]}, {expected[i]}) > s_maxRenderDifference)
+                {
+                    ++numDiffering;
+                }
+            }
+
+            std::cout << std::fixed
+                      << std::setw(16) << name
+                      << std::setw(10) << (std::to_string(numRendered) + "/" + std::to_string(numTiles))
+                      << std::setw(12) << std::setprecision(3) << seconds
+                      << std::setw(10) << std::setprecision(1) << fullSeconds / seconds
+                      << std::setw(14) << numDiffering
+                      << std::setw(14) << std::scientific << std::setprecision(1) << maxRelativeDifference(image, expected)
+                      << std::endl;
+        };
+
+        edit("material swap", [&]
+             { editor.setMaterial(*target, std::make_shared<Metal<T>>(Color<T>(0.9, 0.6, 0.2), 0.1)); });
+        edit("move", [&]
+             { editor.move(*target, target->center() + Vector3<T>(3 * target->radius(), 0, 0)); });
+        edit("no change", [] {});
+        return EXIT_SUCCESS;
+    }
+    // Rays through one tree layout over the objects of a scene
+    struct LayoutResult
+    {
+        double primaryMrays{0};
+        double diffuseMrays{0};
+        double shadowMrays{0};
+        double nodesPerRay{0};
+        double primitivesPerRay{0};
+        std::vector<std::pair<T, const Hittable<T> *>> hits{}; // Closest hit of every ray, primary first
+        std::size_t numBlocked{0};
+    };
+
+    template <typename Tree>
+    LayoutResult traceLayout(const Tree &tree, const HittableList<T> &world,
+                             const std::vector<Ray<T>> &primary, const std::vector<Ray<T>> &diffuse)
+    {
+        const auto &objects = world.objects();
+        const Interval<T> rayT(static_cast<T>(0.001), infinity<T>);
+        LayoutResult result;
+        std::size_t numNodes = 0;
+        std::size_t numPrimitives = 0;
+
+        const auto closest = [&](const std::vector<Ray<T>> &rays)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto &ray : rays)
+            {
+                SurfaceHit<T> surface;
+                surface.t = infinity<T>;
+                tree.traverse(
+                    ray, rayT,
+                    [&](std::uint32_t object, Interval<T> &currentT)
+                    {
+                        ++numPrimitives;
+                        if (!objects[object]->intersect(ray, currentT, surface))
+                        {
+                            return false;
+                        }
+                        currentT = Interval<T>(currentT.min(), surface.t);
+                        return true;
+                    },
+                    &numNodes);
+                result.hits.emplace_back(surface.t, surface.object);
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return static_cast<double>(rays.size()) / seconds / 1e6;
+        };
+
+        result.primaryMrays = closest(primary);
+        result.diffuseMrays = closest(diffuse);
+        result.nodesPerRay = static_cast<double>(numNodes) / static_cast<double>(primary.size() + diffuse.size());
+        result.primitivesPerRay = static_cast<double>(numPrimitives) / static_cast<double>(primary.size() + diffuse.size());
+
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &ray : diffuse)
+        {
+            if (tree.traverseAny(ray, rayT, [&](std::uint32_t object, const Interval<T> &currentT)
+                                 { return objects[object]->occluded(ray, currentT); }))
+            {
+                ++result.numBlocked;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.shadowMrays = static_cast<double>(diffuse.size()) / seconds / 1e6;
+        return result;
+    }
+
+    // Binary tree against the 4- and 8-wide trees collapsed from it: node memory, nodes fetched
+    // per closest-hit ray and throughput. The wide trees must find exactly the hits of the
+    // binary one.
+    int compareWideBVH(const Options &options)
+    {
+        std::cout << std::setw(10) << "objects"
+                  << std::setw(8) << "width"
+                  << std::setw(12) << "build [s]"
+                  << std::setw(12) << "node MB"
+                  << std::setw(12) << "nodes/ray"
+                  << std::setw(12) << "prims/ray"
+                  << std::setw(16) << "primary Mray/s"
+                  << std::setw(16) << "diffuse Mray/s"
+                  << std::setw(16) << "shadow Mray/s"
+                  << std::setw(12) << "mismatches" << '\n';
+
+        bool allEqual = true;
+        for (std::size_t count = options.minCount; count <= options.maxCount; count *= 10)
+        {
+            SceneGenerator<T> generator;
+            generator.setObjectCount(count);
+            generator.setSeed(options.seed);
+            generator.setLayout(options.layout);
+            generator.setSizeDistribution(options.sizes);
+            generator.setMaterialPaletteSize(options.paletteSize);
+            const auto world = generator.generate();
+
+            const auto timed = [](auto &&build)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                auto tree = build();
+                return std::pair{std::move(tree), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+            };
+            const auto [binary, binarySeconds] = timed([&]
+                                                       { return BVHTree<T>(BVH<T>::objectBounds(world)); });
+            const auto [wide4, wide4Seconds] = timed([&]
+                                                     { return WideBVHTree<T, 4>(binary); });
+            const auto [wide8, wide8Seconds] = timed([&]
+                                                     { return WideBVHTree<T, 8>(binary); });
+
+            std::mt19937_64 engine(options.seed);
+            const T halfExtent = generator.extent() / 2;
+            const auto bounds = (options.layout == SceneGenerator<T>::Layout::Field)
+                                    ? AABB<T>(Point3<T>(-halfExtent, 0, -halfExtent),
+                                              Point3<T>(halfExtent, 2 * generator.maxRadius(), halfExtent))
+                                    : binary.bounds();
+            const auto primary = primaryRays(bounds, options.wideBVHRays, engine);
+            const auto diffuse = incoherentRays(bounds, options.wideBVHRays, engine);
+
+            const auto reference = traceLayout(binary, world, primary, diffuse);
+            const auto report = [&](int width, double buildSeconds, std::size_t nodeBytes, const LayoutResult &result)
+            {
+                std::size_t mismatches = 0;
+                for (std::size_t i = 0; i < result.hits.size(); ++i)
+                {
+                    if (result.hits[i] != reference.hits[i])
+                    {
+                        ++mismatches;
+                    }
+                }
+                if (result.numBlocked != reference.numBlocked)
+                {
+                    ++mismatches;
+                }
+                allEqual = allEqual && mismatches == 0;
+
+                std::cout << std::fixed
+                          << std::setw(10) << count
+                          << std::setw(8) << width
+                          << std::setw(12) << std::setprecision(3) << buildSeconds
+                          << std::setw(12) << std::setprecision(2) << static_cast<double>(nodeBytes) / 1e6
+                          << std::setw(12) << std::setprecision(1) << result.nodesPerRay
+                          << std::setw(12) << std::setprecision(1) << result.primitivesPerRay
+                          << std::setw(16) << std::setprecision(2) << result.primaryMrays
+                          << std::setw(16) << std::setprecision(2) << result.diffuseMrays
+                          << std::setw(16) << std::setprecision(2) << result.shadowMrays
+                          << std::setw(12) << mismatches << std::endl;
+            };
+            report(2, binarySeconds, binary.nodes().size_bytes(), reference);
+            report(4, wide4Seconds, wide4.nodes().size_bytes(), traceLayout(wide4, world, primary, diffuse));
+            report(8, wide8Seconds, wide8.nodes().size_bytes(), traceLayout(wide8, world, primary, diffuse));
+        }
+        return allEqual ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Expected cost of a closest-hit ray under the surface area heuristic, with a node visit and
+    // a primitive test costing the same: what the SAH builder minimises, for comparing trees
+    double sahCost(const BVHTree<T> &tree)
+    {
+        const auto nodes = tree.nodes();
+        if (nodes.empty())
+        {
+            return 0;
+        }
+        const double rootArea = static_cast<double>(nodes.front().bounds.surfaceArea());
+        double cost = 0;
+        for (const auto &node : nodes)
+        {
+            const double visits = static_cast<double>(node.bounds.surfaceArea()) / rootArea;
+            cost += visits * ((node.count > 0) ? static_cast<double>(node.count) : 1.0);
+        }
+        return cost;
+    }
+
+    // SAH and Morton builds from the objects of each scene on 1, 2, 4, ... threads: build time,
+    // speedup over one thread, tree quality and throughput of the 8-wide tree collapsed from it.
+    // Every thread count must build the same tree.
+    int compareBuilders(const Options &options)
+    {
+        std::cout << std::setw(10) << "objects"
+                  << std::setw(10) << "builder"
+                  << std::setw(10) << "threads"
+                  << std::setw(12) << "build [s]"
+                  << std::setw(10) << "speedup"
+                  << std::setw(12) << "SAH cost"
+                  << std::setw(16) << "primary Mray/s"
+                  << std::setw(16) << "diffuse Mray/s"
+                  << std::setw(12) << "same tree" << '\n';
+
+        std::vector<int> threadCounts;
+        for (int threads = 1; threads < options.buildThreads; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(options.buildThreads);
+
+        bool allSame = true;
+        for (std::size_t count = options.minCount; count <= options.maxCount; count *= 10)
+        {
+            SceneGenerator<T> generator;
+            generator.setObjectCount(count);
+            generator.setSeed(options.seed);
+            generator.setLayout(options.layout);
+            generator.setSizeDistribution(options.sizes);
+            generator.setMaterialPaletteSize(options.paletteSize);
+            const auto world = generator.generate();
+
+            std::mt19937_64 engine(options.seed);
+            const T halfExtent = generator.extent() / 2;
+            const auto bounds = (options.layout == SceneGenerator<T>::Layout::Field)
+                                    ? AABB<T>(Point3<T>(-halfExtent, 0, -halfExtent),
+                                              Point3<T>(halfExtent, 2 * generator.maxRadius(), halfExtent))
+                                    : world.boundingBox();
+            const auto primary = primaryRays(bounds, options.numRays, engine);
+            const auto diffuse = incoherentRays(bounds, options.numRays, engine);
+
+            for (const auto builder : {BVHTree<T>::Builder::SAH, BVHTree<T>::Builder::Morton})
+            {
+                double singleThreadSeconds = 0;
+                std::uint64_t singleThreadChecksum = 0;
+                for (const int threads : threadCounts)
+                {
+                    ThreadPool threadPool(threads);
+
+                    // Best of three, the first build also faults in the memory
+                    double seconds = infinity<double>;
+                    BVHTree<T> tree;
+                    for (int run = 0; run < 3; ++run)
+                    {
+                        const auto start = std::chrono::steady_clock::now();
+                        tree = BVHTree<T>(BVH<T>::objectBounds(world, &threadPool), builder, &threadPool);
+                        seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                    }
+
+                    const auto checksum = BVHCache<T>::checksum(tree.nodes(), tree.primitiveIndices());
+                    if (threads == threadCounts.front())
+                    {
+                        singleThreadSeconds = seconds;
+                        singleThreadChecksum = checksum;
+                    }
+                    const bool same = checksum == singleThreadChecksum;
+                    allSame = allSame && same;
+
+                    std::cout << std::fixed
+                              << std::setw(10) << count
+                              << std::setw(10) << ((builder == BVHTree<T>::Builder::SAH) ? "sah" : "morton")
+                              << std::setw(10) << threads
+                              << std::setw(12) << std::setprecision(4) << seconds
+                              << std::setw(10) << std::setprecision(2) << singleThreadSeconds / seconds
+                              << std::setw(12) << std::setprecision(1) << sahCost(tree);
+                    if (threads == threadCounts.front())
+                    {
+                        // The tree does not depend on the thread count, so neither does tracing
+                        const auto result = traceLayout(WideBVHTree<T>(tree), world, primary, diffuse);
+                        std::cout << std::setw(16) << std::setprecision(2) << result.primaryMrays
+                                  << std::setw(16) << std::setprecision(2) << result.diffuseMrays;
+                    }
+                    else
+                    {
+                        std::cout << std::setw(16) << "-" << std::setw(16) << "-";
+                    }
+                    std::cout << std::setw(12) << (same ? "yes" : "NO") << std::endl;
+                }
+            }
+        }
+        return allSame ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Depth of the deepest leaf of a tree
+    std::size_t treeDepth(std::span<const BVHNode<T>> nodes)
+    {
+        std::vector<std::size_t> depths(nodes.size(), 0);
+        std::size_t deepest = 0;
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            deepest = std::max(deepest, depths[i]);
+            if (nodes[i].count == 0)
+            {
+                depths[i + 1] = depths[i] + 1;
+                depths[nodes[i].offset] = depths[i] + 1;
+            }
+        }
+        return deepest;
+    }
+
+    // SAH and Morton builds over boxes that push the SAH builder to its deepest tree: a cluster
+    // in the unit cube, plus outliers at x = 32^k, far enough apart that SAH splits peel them off
+    // one level at a time. Every tree must be accepted by BVHTree::isValid, which also bounds its
+    // traversal stack.
+    int checkDeepBVH(const Options &options)
+    {
+        std::mt19937_64 engine(options.seed);
+        std::uniform_real_distribution<T> unit(0, 1);
+        std::vector<AABB<T>> boxes;
+        boxes.reserve(options.deepBVHCount + 60);
+        for (std::size_t i = 0; i < options.deepBVHCount; ++i)
+        {
+            const Point3<T> corner(unit(engine), unit(engine), unit(engine));
+            boxes.emplace_back(corner, corner + Vector3<T>(1e-3, 1e-3, 1e-3));
+        }
+        for (int k = 1; k <= 60; ++k)
+        {
+            const Point3<T> corner(std::pow(static_cast<T>(32), k), 0, 0);
+            boxes.emplace_back(corner, corner + Vector3<T>(1, 1, 1));
+        }
+
+        std::cout << std::setw(10) << "boxes"
+                  << std::setw(10) << "builder"
+                  << std::setw(10) << "depth"
+                  << std::setw(10) << "valid" << '\n';
+
+        bool allValid = true;
+        for (const auto builder : {BVHTree<T>::Builder::SAH, BVHTree<T>::Builder::Morton})
+        {
+            const BVHTree<T> tree(boxes, builder);
+            const bool valid = BVHTree<T>::isValid(tree.nodes(), tree.primitiveIndices(), boxes.size());
+            allValid = allValid && valid;
+            std::cout << std::setw(10) << boxes.size()
+                      << std::setw(10) << ((builder == BVHTree<T>::Builder::SAH) ? "sah" : "morton")
+                      << std::setw(10) << treeDepth(tree.nodes())
+                      << std::setw(10) << (valid ? "yes" : "NO") << std::endl;
+        }
+        return allValid ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // A turntable of small views rendered three ways: each as its own run that builds the scene
+    // again, as is done with one process per view; one after another over a scene built once;
+    // and as one batch whose tiles share the thread pool. All must give the same images.
+    int compareMultiView(const Options &options)
+    {
+        RenderJob<T> job;
+        job.objectCount = options.minCount;
+        job.layout = options.layout;
+        job.sizes = options.sizes;
+        job.paletteSize = options.paletteSize;
+        job.sceneSeed = options.seed;
+        job.imageWidth = 160;
+
+        const auto threadPool = std::make_shared<ThreadPool>();
+        SceneCache<T> cache(1);
+        cache.setThreadPool(threadPool);
+        const auto sceneStart = std::chrono::steady_clock::now();
+        auto origin = SceneCache<T>::Origin::Built;
+        const auto scene = cache.get(job, origin);
+        const double sceneSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sceneStart).count();
+
+        std::vector<Camera<T>> cameras;
+        for (int view = 0; view < options.numViews; ++view)
+        {
+            const T angle = 2 * pi<T> * static_cast<T>(view) / static_cast<T>(options.numViews);
+            const T radius = scene->extent / 2;
+            job.lookFrom = scene->center + Vector3<T>(radius * std::sin(angle), scene->extent / 4, radius * std::cos(angle));
+            cameras.push_back(job.camera(scene->center, scene->extent));
+            cameras.back().setThreadPool(threadPool);
+        }
+
+        const auto timed = [](auto &&render)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            auto images = render();
+            return std::pair{std::move(images), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+        };
+
+        const auto [separate, separateSeconds] = timed([&]
+                                                       {
+                                                           std::vector<std::vector<Color<T>>> images;
+                                                           for (auto &camera : cameras)
+                                                           {
+                                                               SceneCache<T> ownCache(1);
+                                                               ownCache.setThreadPool(threadPool);
+                                                               const auto ownScene = ownCache.get(job, origin);
+                                                               images.push_back(camera.renderImage(ownScene->bvh, LightList<T>()));
+                                                           }
+                                                           return images; });
+        const auto [sequential, sequentialSeconds] = timed([&]
+                                                           {
+                                                               std::vector<std::vector<Color<T>>> images;
+                                                               for (auto &camera : cameras)
+                                                               {
+                                                                   images.push_back(camera.renderImage(scene->bvh, LightList<T>()));
+                                                               }
+                                                               return images; });
+        const auto [batch, batchSeconds] = timed([&]
+                                                 { return Camera<T>::renderViews(cameras, scene->bvh, LightList<T>(), *threadPool); });
+
+        double difference = 0;
+        for (std::size_t view = 0; view < cameras.size(); ++view)
+        {
+            difference = std::max({difference, maxRelativeDifference(separate[view], sequential[view]),
+                                   maxRelativeDifference(separate[view], batch[view])});
+        }
+
+        std::cout << options.numViews << " views of " << options.minCount << " objects, " << job.imageWidth
+                  << " px wide, " << job.numSamplesPerPixel << " spp, " << threadPool->numThreads()
+                  << " threads, scene build " << std::fixed << std::setprecision(3) << sceneSeconds << " s\n"
+                  << std::setw(26) << "schedule"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(14) << "per view [s]"
+                  << std::setw(10) << "speedup" << '\n';
+        const auto report = [&](const char *name, double seconds)
+        {
+            std::cout << std::fixed << std::setprecision(3)
+                      << std::setw(26) << name
+                      << std::setw(12) << seconds
+                      << std::setw(14) << seconds / options.numViews
+                      << std::setw(10) << std::setprecision(2) << separateSeconds / seconds << std::endl;
+        };
+        report("rebuild scene per view", separateSeconds);
+        report("shared scene, one by one", sequentialSeconds);
+        report("one batch", batchSeconds);
+        std::cout << "max rel diff " << std::scientific << std::setprecision(1) << difference << '\n';
+        return (difference <= s_maxRenderDifference) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Root mean square difference of two framebuffers, per channel of linear radiance
+    double radianceRMSE(const std::vector<Color<T>> &a, const std::vector<Color<T>> &b)
+    {
+        double sum = 0;
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                const double difference = a[i][c] - b[i][c];
+                sum += difference * difference;
+            }
+        }
+        return std::sqrt(sum / static_cast<double>(3 * std::max<std::size_t>(a.size(), 1)));
+    }
+
+    // The --min scene path traced and with an irradiance cache at equal samples per pixel, both
+    // compared to a path traced reference with many more samples. The cached render is also
+    // repeated on one thread, its records and image must not depend on the thread count.
+    int compareIrradianceCache(const Options &options)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+
+        constexpr int numSamplesPerPixel = 4;
+        constexpr int numReferenceSamples = 256;
+        const auto threadPool = std::make_shared<ThreadPool>();
+        const auto makeCamera = [&](int numSamples, std::optional<typename IrradianceCache<T>::Settings> cache)
+        {
+            RenderJob<T> job;
+            job.imageWidth = options.irradianceCacheWidth;
+            job.numSamplesPerPixel = numSamples;
+            auto camera = job.camera(Point3<T>(0, 0, 0), generator.extent());
+            camera.setIrradianceCache(cache);
+            camera.setThreadPool(threadPool);
+            return camera;
+        };
+        const auto timed = [&](Camera<T> &camera)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            auto image = camera.renderImage(bvh, LightList<T>());
+            return std::pair{std::move(image), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+        };
+
+        auto referenceCamera = makeCamera(numReferenceSamples, std::nullopt);
+        referenceCamera.setSeed(s_referenceSeed);
+        const auto [reference, referenceSeconds] = timed(referenceCamera);
+
+        std::cout << options.minCount << " objects, " << options.irradianceCacheWidth << " px wide, "
+                  << threadPool->numThreads() << " threads, reference " << numReferenceSamples << " spp in "
+                  << std::fixed << std::setprecision(3) << referenceSeconds << " s\n"
+                  << std::setw(24) << "integrator"
+                  << std::setw(8) << "spp"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(10) << "records"
+                  << std::setw(12) << "RMSE" << '\n';
+        const auto report = [&](const char *name, int numSamples, double seconds, std::size_t numRecords, const std::vector<Color<T>> &image)
+        {
+            std::cout << std::setw(24) << name
+                      << std::setw(8) << numSamples
+                      << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+                      << std::setw(10) << numRecords
+                      << std::setw(12) << std::setprecision(5) << radianceRMSE(image, reference) << std::endl;
+        };
+
+        auto pathCamera = makeCamera(numSamplesPerPixel, std::nullopt);
+        const auto [pathImage, pathSeconds] = timed(pathCamera);
+        report("path traced", numSamplesPerPixel, pathSeconds, 0, pathImage);
+
+        auto equalTimeCamera = makeCamera(4 * numSamplesPerPixel, std::nullopt);
+        const auto [equalTimeImage, equalTimeSeconds] = timed(equalTimeCamera);
+        report("path traced", 4 * numSamplesPerPixel, equalTimeSeconds, 0, equalTimeImage);
+
+        bool deterministic = true;
+        for (const T errorBound : {T(0.5), T(0.25)})
+        {
+            typename IrradianceCache<T>::Settings settings;
+            settings.errorBound = errorBound;
+            auto cachedCamera = makeCamera(numSamplesPerPixel, settings);
+            const auto [cachedImage, cachedSeconds] = timed(cachedCamera);
+            const std::string name = "irradiance cache a=" + std::to_string(errorBound).substr(0, 4);
+            report(name.c_str(), numSamplesPerPixel, cachedSeconds, cachedCamera.irradianceCache()->size(), cachedImage);
+
+            auto serialCamera = makeCamera(numSamplesPerPixel, settings);
+            serialCamera.setThreadPool(nullptr);
+            serialCamera.setNumThreads(1);
+            const auto serialImage = serialCamera.renderImage(bvh, LightList<T>());
+            deterministic = deterministic && serialCamera.irradianceCache()->size() == cachedCamera.irradianceCache()->size() &&
+                            maxRelativeDifference(serialImage, cachedImage) <= s_maxRenderDifference;
+        }
+
+        if (!deterministic)
+        {
+            std::cout << "FAIL: the cached render depends on the thread count\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // A closed diffuse room, 2 units wide, lit only by the sky through a small square opening in
+    // the middle of its ceiling. Most BSDF samples end on a wall, the few that leave through the
+    // opening carry all the light.
+    HittableList<T> skylightRoom()
+    {
+        constexpr T hole = static_cast<T>(0.2);
+
+        auto mesh = std::make_shared<MeshData<T>>();
+        const auto quad = [&](const Point3<T> &a, const Point3<T> &b, const Point3<T> &c, const Point3<T> &d)
+        {
+            const auto first = static_cast<std::uint32_t>(mesh->vertices.size());
+            mesh->vertices.insert(mesh->vertices.end(), {a, b, c, d});
+            mesh->triangles.push_back({first, first + 1, first + 2});
+            mesh->triangles.push_back({first, first + 2, first + 3});
+        };
+        quad({-1, -1, -1}, {1, -1, -1}, {1, -1, 1}, {-1, -1, 1}); // Floor
+        quad({-1, -1, -1}, {-1, 1, -1}, {1, 1, -1}, {1, -1, -1}); // Walls
+        quad({-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1});
+        quad({-1, -1, -1}, {-1, -1, 1}, {-1, 1, 1}, {-1, 1, -1});
+        quad({1, -1, -1}, {1, 1, -1}, {1, 1, 1}, {1, -1, 1});
+        quad({-1, 1, -1}, {-1, 1, 1}, {-hole, 1, 1}, {-hole, 1, -1}); // Ceiling around the opening
+        quad({hole, 1, -1}, {hole, 1, 1}, {1, 1, 1}, {1, 1, -1});
+        quad({-hole, 1, -1}, {-hole, 1, -hole}, {hole, 1, -hole}, {hole, 1, -1});
+        quad({-hole, 1, hole}, {-hole, 1, 1}, {hole, 1, 1}, {hole, 1, hole});
+
+        HittableList<T> world;
+        world.add(std::make_shared<TriangleMesh<T>>(mesh, std::make_shared<Lambertial<T>>(Color<T>(0.7, 0.7, 0.7))));
+        world.add(std::make_shared<Sphere<T>>(Point3<T>(-0.4, -0.7, -0.3), 0.3, std::make_shared<Lambertial<T>>(Color<T>(0.7, 0.3, 0.2))));
+        world.add(std::make_shared<Sphere<T>>(Point3<T>(0.45, -0.75, 0.1), 0.25, std::make_shared<Metal<T>>(Color<T>(0.8, 0.8, 0.8), 0.1)));
+        return world;
+    }
+
+    // BSDF sampling and path guiding at a few sample counts, on the --min scene under an open
+    // sky and in a room lit through a small opening, each against a reference with many more
+    // samples. Efficiency is 1 / (RMSE^2 x time), the inverse of the time needed for a given
+    // noise level; the guided times include training. Guided renders are also repeated on one
+    // thread, they must not depend on the thread count.
+    int comparePathGuiding(const Options &options)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+
+        struct Scene
+        {
+            std::string name;
+            HittableList<T> world;
+            RenderJob<T> job;
+        };
+        std::vector<Scene> scenes;
+        scenes.push_back({std::to_string(options.minCount) + " spheres", generator.generate(), RenderJob<T>()});
+        scenes.push_back({"skylight room", skylightRoom(), RenderJob<T>()});
+        scenes[0].job.lookFrom = Point3<T>(0, generator.extent() / 4, generator.extent() / 2);
+        scenes[1].job.lookFrom = Point3<T>(0, -0.2, 0.95);
+        scenes[1].job.lookAt = Point3<T>(0, -0.4, -1);
+        scenes[1].job.verticalFOV_deg = 75;
+
+        constexpr int numReferenceSamples = 256;
+        const auto threadPool = std::make_shared<ThreadPool>();
+        std::cout << options.pathGuidingWidth << " px wide, " << threadPool->numThreads() << " threads, references "
+                  << numReferenceSamples << " spp\n"
+                  << std::setw(16) << "scene"
+                  << std::setw(10) << "sampling"
+                  << std::setw(8) << "spp"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(10) << "cells"
+                  << std::setw(12) << "RMSE"
+                  << std::setw(14) << "efficiency" << '\n';
+
+        bool deterministic = true;
+        for (auto &scene : scenes)
+        {
+            const BVH<T> bvh(scene.world);
+            const auto makeCamera = [&](int numSamples, int numTrainingPasses)
+            {
+                auto job = scene.job;
+                job.imageWidth = options.pathGuidingWidth;
+                job.numSamplesPerPixel = numSamples;
+                job.pathGuidingPasses = numTrainingPasses;
+                auto camera = job.camera(Point3<T>(0, 0, 0), 1);
+                camera.setThreadPool(threadPool);
+                return camera;
+            };
+
+            // Seeded apart, so that the first samples of the reference are not those of the
+            // BSDF renders, which would hide part of their noise
+            auto referenceCamera = makeCamera(numReferenceSamples, 0);
+            referenceCamera.setSeed(s_referenceSeed);
+            const auto reference = referenceCamera.renderImage(bvh, LightList<T>());
+
+            for (const int numSamples : {4, 16, 64})
+            {
+                for (const int numTrainingPasses : {0, 3})
+                {
+                    auto camera = makeCamera(numSamples, numTrainingPasses);
+                    const auto start = std::chrono::steady_clock::now();
+                    const auto image = camera.renderImage(bvh, LightList<T>());
+                    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    const double error = radianceRMSE(image, reference);
+                    std::cout << std::setw(16) << scene.name
+                              << std::setw(10) << (numTrainingPasses > 0 ? "guided" : "BSDF")
+                              << std::setw(8) << numSamples
+                              << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+                              << std::setw(10) << (camera.pathGuide() ? camera.pathGuide()->numCells() : 0)
+                              << std::setw(12) << std::setprecision(5) << error
+                              << std::setw(14) << std::setprecision(1) << 1 / (error * error * seconds) << std::endl;
+
+                    if (numTrainingPasses > 0)
+                    {
+                        auto serialCamera = makeCamera(numSamples, numTrainingPasses);
+                        serialCamera.setThreadPool(nullptr);
+                        serialCamera.setNumThreads(1);
+                        deterministic = deterministic && maxRelativeDifference(serialCamera.renderImage(bvh, LightList<T>()), image) <= s_maxRenderDifference;
+                    }
+                }
+            }
+        }
+
+        if (!deterministic)
+        {
+            std::cout << "FAIL: the guided render depends on the thread count\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Renders the --min scene with image textures on its spheres, far larger than the smaller
+    // caches, once with every cache size. The tiles a lookup reads do not depend on what is
+    // cached, so every image must match the one rendered with all tiles in memory.
+    int compareTextureCache(const Options &options)
+    {
+        constexpr int numTextures = 16;
+        constexpr std::uint32_t textureSize = 1024;
+        const auto directory = std::filesystem::temp_directory_path() / ("raytracer-textures-" + std::to_string(::getpid()));
+        std::filesystem::create_directories(directory);
+
+        // Checkers of two colors, with a fine stripe that only the finest levels resolve
+        std::vector<std::shared_ptr<const TextureFile>> files;
+        std::uintmax_t fileBytes = 0;
+        for (int k = 0; k < numTextures; ++k)
+        {
+            const T hue = static_cast<T>(k) / numTextures;
+            const Color<T> first(0.1 + 0.8 * hue, 0.5, 0.9 - 0.8 * hue);
+            const Color<T> second(0.9 - 0.6 * hue, 0.2 + 0.6 * hue, 0.3);
+            std::vector<Color<T>> texels(static_cast<std::size_t>(textureSize) * textureSize);
+            for (std::uint32_t y = 0; y < textureSize; ++y)
+            {
+                for (std::uint32_t x = 0; x < textureSize; ++x)
+                {
+                    const bool checker = ((x / 64) + (y / 64)) % 2 == 0;
+                    const T stripe = (x % 4 == 0) ? static_cast<T>(0.5) : static_cast<T>(1);
+                    texels[static_cast<std::size_t>(y) * textureSize + x] = stripe * (checker ? first : second);
+                }
+            }
+            const auto path = (directory / ("texture" + std::to_string(k) + ".rttex")).string();
+            TextureFile::write(path, textureSize, textureSize, std::move(texels));
+            fileBytes += std::filesystem::file_size(path);
+            files.push_back(std::make_shared<const TextureFile>(path));
+        }
+
+        const auto threadPool = std::make_shared<ThreadPool>();
+        const auto render = [&](std::shared_ptr<TextureCache> cache)
+        {
+            SceneGenerator<T> generator;
+            generator.setObjectCount(options.minCount);
+            generator.setSeed(options.seed);
+            generator.setLayout(options.layout);
+            generator.setSizeDistribution(options.sizes);
+            generator.setMaterialPaletteSize(options.paletteSize);
+            if (cache)
+            {
+                std::vector<std::shared_ptr<const Texture<T>>> textures;
+                for (const auto &file : files)
+                {
+                    textures.push_back(std::make_shared<ImageTexture<T>>(cache, file));
+                }
+                generator.setAlbedoTextures(std::move(textures));
+            }
+            const auto world = generator.generate();
+            const BVH<T> bvh(world);
+
+            RenderJob<T> job;
+            job.imageWidth = options.textureCacheWidth;
+            auto camera = job.camera(Point3<T>(0, 0, 0), generator.extent());
+            camera.setThreadPool(threadPool);
+            const auto start = std::chrono::steady_clock::now();
+            auto image = camera.renderImage(bvh, LightList<T>());
+            return std::pair{std::move(image), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+        };
+
+        std::cout << options.minCount << " objects, " << options.textureCacheWidth << " px wide, "
+                  << threadPool->numThreads() << " threads, " << numTextures << " textures of "
+                  << textureSize << "^2, " << std::fixed << std::setprecision(1)
+                  << static_cast<double>(fileBytes) / (1 << 20) << " MiB of tiles\n"
+                  << std::setw(14) << "cache [MiB]"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(12) << "hit %"
+                  << std::setw(12) << "tile reads"
+                  << std::setw(12) << "evictions"
+                  << std::setw(12) << "peak [MiB]" << '\n';
+
+        const auto [plainImage, plainSeconds] = render(nullptr);
+        std::cout << std::setw(14) << "untextured" << std::setw(12) << std::setprecision(3) << plainSeconds << std::endl;
+
+        bool identical = true;
+        std::vector<Color<T>> fullImage;
+        for (const std::size_t capacityMiB : {std::size_t(1024), std::size_t(16), std::size_t(4), std::size_t(1)})
+        {
+            const auto cache = std::make_shared<TextureCache>(capacityMiB << 20);
+            const auto [image, seconds] = render(cache);
+            const auto statistics = cache->statistics();
+            std::cout << std::setw(14) << capacityMiB
+                      << std::setw(12) << std::setprecision(3) << seconds
+                      << std::setw(12) << std::setprecision(2) << 100 * statistics.hitRate()
+                      << std::setw(12) << statistics.misses
+                      << std::setw(12) << statistics.evictions
+                      << std::setw(12) << std::setprecision(2) << static_cast<double>(statistics.peakBytes) / (1 << 20) << std::endl;
+
+            if (fullImage.empty())
+            {
+                fullImage = image;
+            }
+            identical = identical && image == fullImage;
+        }
+
+        files.clear();
+        std::filesystem::remove_all(directory);
+        if (!identical)
+        {
+            std::cout << "FAIL: the image depends on the cache size\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    // Renders the --min scene under a sky whose light mostly comes from a sun 2 degrees wide,
+    // with the environment sampled uniformly over the sphere and by importance, both compared
+    // to an importance sampled reference with many more samples. The sky goes through a PFM
+    // file, as a scene's environment would.
+    int compareEnvironment(const Options &options)
+    {
+        constexpr int skyWidth = 1024;
+        constexpr int skyHeight = 512;
+        const auto sunDirection = unitVector(Vector3<T>(1, 0.7, -0.5));
+        const T sunCos = std::cos(pi<T> / 180);
+        std::vector<Color<T>> texels(static_cast<std::size_t>(skyWidth) * skyHeight);
+        for (int row = 0; row < skyHeight; ++row)
+        {
+            for (int column = 0; column < skyWidth; ++column)
+            {
+                const auto direction = EnvironmentMap<T>::direction((row + 0.5) / skyHeight, (column + 0.5) / skyWidth);
+                const T t = std::max(direction.y(), static_cast<T>(0));
+                Color<T> sky = (1 - t) * Color<T>(0.6, 0.7, 0.8) + t * Color<T>(0.15, 0.3, 0.7);
+                if (direction.y() < 0)
+                {
+                    sky = Color<T>(0.1, 0.09, 0.08);
+                }
+                if (dot(direction, sunDirection) > sunCos)
+                {
+                    sky = Color<T>(20000, 18000, 15000);
+                }
+                texels[static_cast<std::size_t>(row) * skyWidth + static_cast<std::size_t>(column)] = sky;
+            }
+        }
+        const auto path = (std::filesystem::temp_directory_path() / ("raytracer-sky-" + std::to_string(::getpid()) + ".pfm")).string();
+        EnvironmentMap<T>::savePFM(path, skyWidth, skyHeight, texels);
+
+        const auto lightsWith = [&](typename EnvironmentMap<T>::Strategy strategy)
+        {
+            LightList<T> lights;
+            lights.setEnvironment(std::make_shared<const EnvironmentMap<T>>(EnvironmentMap<T>::loadPFM(path, strategy)));
+            return lights;
+        };
+        const auto importance = lightsWith(EnvironmentMap<T>::Strategy::Importance);
+        const auto uniform = lightsWith(EnvironmentMap<T>::Strategy::Uniform);
+        std::filesystem::remove(path);
+
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        // Metal and glass would show the sun as caustics, which no light sampling finds
+        generator.setMaterialMix(1, 0, 0);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+
+        constexpr int numReferenceSamples = 256;
+        const auto threadPool = std::make_shared<ThreadPool>();
+        const auto makeCamera = [&](int numSamples)
+        {
+            RenderJob<T> job;
+            job.imageWidth = options.environmentWidth;
+            job.numSamplesPerPixel = numSamples;
+            auto camera = job.camera(Point3<T>(0, 0, 0), generator.extent());
+            camera.setThreadPool(threadPool);
+            return camera;
+        };
+
+        auto referenceCamera = makeCamera(numReferenceSamples);
+        referenceCamera.setSeed(s_referenceSeed);
+        const auto reference = referenceCamera.renderImage(bvh, importance);
+
+        std::cout << options.minCount << " objects, " << options.environmentWidth << " px wide, "
+                  << threadPool->numThreads() << " threads, " << skyWidth << "x" << skyHeight
+                  << " sky, reference " << numReferenceSamples << " spp\n"
+                  << std::setw(12) << "sampling"
+                  << std::setw(8) << "spp"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(12) << "RMSE"
+                  << std::setw(14) << "efficiency" << '\n';
+        for (const int numSamples : {4, 16, 64})
+        {
+            for (const auto *lights : {&uniform, &importance})
+            {
+                auto camera = makeCamera(numSamples);
+                const auto start = std::chrono::steady_clock::now();
+                const auto image = camera.renderImage(bvh, *lights);
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                const double error = radianceRMSE(image, reference);
+                std::cout << std::setw(12) << (lights == &uniform ? "uniform" : "importance")
+                          << std::setw(8) << numSamples
+                          << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+                          << std::setw(12) << std::setprecision(5) << error
+                          << std::setw(14) << std::setprecision(1) << 1 / (error * error * seconds) << std::endl;
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+    // Renders the --max scene from its objects in memory, then streamed from a chunk file with
+    // budgets down to a small part of the file, chunks paged in by the rays that reach them one
+    // at a time and by whole bounces queued per chunk. Hits do not depend on what is resident,
+    // so every image must match the in-memory one.
+    int compareOutOfCore(const Options &options)
+    {
+        constexpr std::size_t spheresPerChunk = 4096;
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.maxCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+
+        const std::size_t heapBefore = heapBytesInUse();
+        auto world = std::make_optional(generator.generate());
+        auto bvh = std::make_optional<BVH<T>>(*world);
+        const std::size_t sceneBytes = heapBytesInUse() - heapBefore;
+
+        const auto path = (std::filesystem::temp_directory_path() / ("raytracer-chunks-" + std::to_string(::getpid()) + ".rtchunk")).string();
+        auto palette = ChunkedScene<T>::write(path, *world, spheresPerChunk);
+        const auto fileBytes = static_cast<std::size_t>(std::filesystem::file_size(path));
+
+        const T extent = generator.extent();
+        const auto threadPool = std::make_shared<ThreadPool>();
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(options.outOfCoreWidth);
+        camera.setNumSamplesPerPixel(16);
+        camera.setMaxReflection(8);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookFrom(Point3<T>(0, extent / 4, extent / 2));
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setFocusDist(extent / 2);
+        camera.setThreadPool(threadPool);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto reference = camera.renderImage(*bvh, LightList<T>());
+        const double referenceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Only the materials stay behind for the chunked renders
+        bvh.reset();
+        world.reset();
+
+        std::cout << options.maxCount << " objects, " << options.outOfCoreWidth << " px wide, "
+                  << camera.numSamplesPerPixel() << " spp, " << threadPool->numThreads() << " threads\n"
+                  << std::fixed << std::setprecision(1)
+                  << "in memory: " << static_cast<double>(sceneBytes) / (1 << 20) << " MiB of objects and trees, "
+                  << std::setprecision(3) << referenceSeconds << " s\n"
+                  << "chunk file: " << std::setprecision(1) << static_cast<double>(fileBytes) / (1 << 20) << " MiB in chunks of "
+                  << spheresPerChunk << " spheres\n"
+                  << std::setw(12) << "budget [%]"
+                  << std::setw(12) << "traversal"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(12) << "hit %"
+                  << std::setw(10) << "loads"
+                  << std::setw(12) << "read [MiB]"
+                  << std::setw(12) << "peak [MiB]"
+                  << std::setw(12) << "difference" << '\n';
+
+        // Paging per ray at the smallest budget would take minutes
+        const std::pair<std::size_t, bool> runs[] = {{100, false}, {100, true}, {25, false}, {25, true}, {5, true}};
+        double worstDifference = 0;
+        for (const auto &[budgetPercent, batching] : runs)
+        {
+            ChunkedScene<T> scene(path, palette, fileBytes * budgetPercent / 100);
+            scene.setBatching(batching);
+            const auto chunkedStart = std::chrono::steady_clock::now();
+            const auto image = camera.renderImage(scene, LightList<T>());
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - chunkedStart).count();
+
+            const auto statistics = scene.statistics();
+            const double difference = maxRelativeDifference(reference, image);
+            worstDifference = std::max(worstDifference, difference);
+            std::cout << std::setw(12) << budgetPercent
+                      << std::setw(12) << (batching ? "batched" : "per ray")
+                      << std::setw(12) << std::setprecision(3) << seconds
+                      << std::setw(12) << std::setprecision(2) << 100 * statistics.hitRate()
+                      << std::setw(10) << statistics.loads
+                      << std::setw(12) << std::setprecision(1) << static_cast<double>(statistics.loadedBytes) / (1 << 20)
+                      << std::setw(12) << std::setprecision(1) << static_cast<double>(statistics.peakBytes) / (1 << 20)
+                      << std::setw(12) << std::scientific << std::setprecision(1) << difference << std::fixed << std::endl;
+        }
+
+        std::filesystem::remove(path);
+        return (worstDifference <= s_maxRenderDifference) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    // The approximations of the fast math tier against libm on inputs from the ranges the
+    // shading code passes, then a render with whichever tier this binary was built with. Run
+    // it from a build of each tier to compare their render times; --check-image with a
+    // reference from the precise build measures the image error of the fast one.
+    int compareFastMath(const Options &options)
+    {
+        constexpr std::size_t numValues = 1 << 20;
+        constexpr int numRepeats = 16;
+        std::mt19937_64 engine(options.seed);
+        const auto uniformValues = [&](T low, T high)
+        {
+            std::uniform_real_distribution<T> distribution(low, high);
+            std::vector<T> values(numValues);
+            for (auto &value : values)
+            {
+                value = distribution(engine);
+            }
+            return values;
+        };
+
+        std::cout << std::setw(22) << "function"
+                  << std::setw(14) << "libm [ns]"
+                  << std::setw(14) << "approx [ns]"
+                  << std::setw(12) << "speedup"
+                  << std::setw(16) << "max rel error" << '\n';
+
+        const auto measure = [&](const std::string &label, const std::vector<T> &values, const auto &exact, const auto &approximate)
+        {
+            // Summing the results keeps the loops from being optimized away
+            const auto nanoseconds = [&](const auto &function)
+            {
+                T sum = 0;
+                const auto start = std::chrono::steady_clock::now();
+                for (int repeat = 0; repeat < numRepeats; ++repeat)
+                {
+                    for (const T value : values)
+                    {
+                        sum += function(value);
+                    }
+                }
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                volatile T sink = sum;
+                static_cast<void>(sink);
+                return 1e9 * seconds / static_cast<double>(values.size() * numRepeats);
+            };
+
+            double maxError = 0;
+            for (const T value : values)
+            {
+                const T reference = exact(value);
+                maxError = std::max(maxError, static_cast<double>(std::abs(approximate(value) - reference) / reference));
+            }
+
+            const double exactNanoseconds = nanoseconds(exact);
+            const double approximateNanoseconds = nanoseconds(approximate);
+            std::cout << std::setw(22) << label << std::fixed
+                      << std::setw(14) << std::setprecision(2) << exactNanoseconds
+                      << std::setw(14) << std::setprecision(2) << approximateNanoseconds
+                      << std::setw(12) << std::setprecision(2) << exactNanoseconds / approximateNanoseconds
+                      << std::setw(16) << std::scientific << std::setprecision(1) << maxError << std::endl;
+        };
+
+        const auto unit = uniformValues(static_cast<T>(1e-4), 1);
+        const auto wide = uniformValues(static_cast<T>(1e-3), static_cast<T>(1e3));
+        measure("pow(x, 5)", unit, [](T x)
+                { return std::pow(x, 5); }, [](T x)
+                { const T x2 = x * x; return x2 * x2 * x; });
+        measure("1 / sqrt(x)", wide, [](T x)
+                { return 1 / std::sqrt(x); }, [](T x)
+                { return FastMath::approxRsqrt(x); });
+        measure("pow(x, 1 / 2.2)", unit, [](T x)
+                { return std::pow(x, static_cast<T>(1 / 2.2)); }, [](T x)
+                { return FastMath::approxPow(x, static_cast<T>(1 / 2.2)); });
+        measure("pow(x, 2.2)", unit, [](T x)
+                { return std::pow(x, static_cast<T>(2.2)); }, [](T x)
+                { return FastMath::approxPow(x, static_cast<T>(2.2)); });
+
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+
+        const T extent = generator.extent();
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(options.fastMathWidth);
+        camera.setNumSamplesPerPixel(16);
+        camera.setMaxReflection(8);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookFrom(Point3<T>(0, extent / 4, extent / 2));
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setFocusDist(extent / 2);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto image = camera.renderImage(bvh, LightList<T>());
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        for (const auto &pixel : image)
+        {
+            for (const auto byte : toBytes(pixel))
+            {
+                hash = (hash ^ byte) * 0x100000001B3ull;
+            }
+        }
+        std::cout << "render with " << FastMath::tierName() << " shading math: " << options.minCount << " objects, "
+                  << options.fastMathWidth << " px wide, " << camera.numSamplesPerPixel() << " spp, "
+                  << std::fixed << std::setprecision(3) << seconds << " s, image hash " << std::hex << hash << std::dec << '\n';
+        return EXIT_SUCCESS;
+    }
+
+    // Renders the --min scene into a framebuffer of the whole image and written out from it,
+    // then in bands of rows written into mapped PPM and PFM files. Reports the growth of the
+    // resident set over the render and requires the files to hold the same image.
+    int compareBandedRender(const Options &options)
+    {
+        constexpr int bandHeight = 64;
+        SceneGenerator<T> generator;
+        generator.setObjectCount(options.minCount);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+        const auto world = generator.generate();
+        const BVH<T> bvh(world);
+
+        const T extent = generator.extent();
+        Camera<T> camera;
+        camera.setAspectRatio(16.0 / 9.0);
+        camera.setImageWidth(options.bandedWidth);
+        camera.setNumSamplesPerPixel(1);
+        camera.setMaxReflection(4);
+        camera.setVerticalFOV_deg(40);
+        camera.setLookFrom(Point3<T>(0, extent / 4, extent / 2));
+        camera.setLookAt(Point3<T>(0, 0, 0));
+        camera.setFocusDist(extent / 2);
+        camera.setThreadPool(std::make_shared<ThreadPool>());
+
+        const auto directory = std::filesystem::temp_directory_path();
+        const auto prefix = "raytracer-banded-" + std::to_string(::getpid());
+        const auto referencePath = (directory / (prefix + "-reference.ppm")).string();
+        const auto ppmPath = (directory / (prefix + ".ppm")).string();
+        const auto pfmPath = (directory / (prefix + ".pfm")).string();
+
+        std::cout << options.minCount << " objects, " << options.bandedWidth << " px wide, "
+                  << camera.numSamplesPerPixel() << " spp, bands of " << bandHeight << " rows\n"
+                  << std::setw(22) << "output"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(14) << "file [MiB]"
+                  << std::setw(14) << "peak [MiB]" << '\n';
+
+        // Growth of the peak resident set over a run
+        const auto measure = [&](const std::string &label, const std::string &path, const auto &run)
+        {
+            const std::size_t residentBefore = processStatusBytes("VmRSS");
+            resetPeakResidentBytes();
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const std::size_t peak = processStatusBytes("VmHWM");
+            std::cout << std::setw(22) << label << std::fixed
+                      << std::setw(12) << std::setprecision(3) << seconds
+                      << std::setw(14) << std::setprecision(1) << static_cast<double>(std::filesystem::file_size(path)) / (1 << 20)
+                      << std::setw(14) << std::setprecision(1) << static_cast<double>(peak - std::min(peak, residentBefore)) / (1 << 20)
+                      << std::endl;
+        };
+
+        measure("in memory, P6", referencePath, [&]
+                {
+                    ImageWriter<T> writer;
+                    camera.render(bvh, LightList<T>(), writer, referencePath, ImageWriter<T>::Format::BinaryPPM);
+                    writer.finish();
+                });
+        measure("bands, mapped P6", ppmPath, [&]
+                { camera.renderBands(bvh, LightList<T>(), ppmPath, FramebufferFile<T>::Format::BinaryPPM, bandHeight); });
+        measure("bands, mapped PFM", pfmPath, [&]
+                { camera.renderBands(bvh, LightList<T>(), pfmPath, FramebufferFile<T>::Format::PFM, bandHeight); });
+
+        // The PPM must match byte for byte, the PFM to float precision
+        const auto readFile = [](const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        };
+        const bool ppmEqual = readFile(ppmPath) == readFile(referencePath);
+
+        const auto reference = camera.renderImage(bvh, LightList<T>());
+        const auto width = static_cast<std::size_t>(camera.imageWidth());
+        const std::size_t height = reference.size() / width;
+        const auto pfm = readFile(pfmPath);
+        const std::string header = "PF\n" + std::to_string(width) + ' ' + std::to_string(height) + "\n-1.0\n";
+        double pfmDifference = (pfm.size() == header.size() + 12 * reference.size() && pfm.starts_with(header)) ? 0 : 1;
+        for (std::size_t y = 0; pfmDifference < 1 && y < height; ++y)
+        {
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                // Rows are stored from the bottom up
+                const auto &pixel = reference[y * width + x];
+                const auto *stored = pfm.data() + header.size() + 12 * ((height - 1 - y) * width + x);
+                const T channels[] = {pixel.r(), pixel.g(), pixel.b()};
+                for (std::size_t c = 0; c < 3; ++c)
+                {
+                    float value;
+                    std::memcpy(&value, stored + 4 * c, sizeof(value));
+                    pfmDifference = std::max(pfmDifference, std::abs(static_cast<double>(value) - channels[c]) / std::max(channels[c], 1e-3));
+                }
+            }
+        }
+
+        std::cout << "P6 files identical: " << (ppmEqual ? "yes" : "NO") << ", PFM max relative difference "
+                  << std::scientific << std::setprecision(1) << pfmDifference << '\n';
+
+        for (const auto &path : {referencePath, ppmPath, pfmPath})
+        {
+            std::filesystem::remove(path);
+        }
+        return (ppmEqual && pfmDifference <= 1e-6) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!options.checkImage.empty())
+    {
+        return checkImage(options);
+    }
+
+    if (options.ordersWidth > 0)
+    {
+        return compareOrders(options);
+    }
+
+    if (options.numFrames > 0)
+    {
+        return compareFrameOutput(options);
+    }
+
+    if (options.toneMapWidth > 0)
+    {
+        return compareToneMapping(options);
+    }
+
+    if (options.kernelsWidth > 0)
+    {
+        return compareKernels(options);
+    }
+
+    if (options.reorderWidth > 0)
+    {
+        return compareRayReordering(options);
+    }
+
+    if (!options.bvhCacheDirectory.empty())
+    {
+        return compareBVHCache(options);
+    }
+
+    if (options.incrementalWidth > 0)
+    {
+        return compareIncrementalRender(options);
+    }
+
+    if (options.wideBVHRays > 0)
+    {
+        return compareWideBVH(options);
+    }
+
+    if (options.buildThreads > 0)
+    {
+        return compareBuilders(options);
+    }
+
+    if (options.deepBVHCount > 0)
+    {
+        return checkDeepBVH(options);
+    }
+
+    if (options.numViews > 0)
+    {
+        return compareMultiView(options);
+    }
+
+    if (options.irradianceCacheWidth > 0)
+    {
+        return compareIrradianceCache(options);
+    }
+
+    if (options.pathGuidingWidth > 0)
+    {
+        return comparePathGuiding(options);
+    }
+
+    if (options.textureCacheWidth > 0)
+    {
+        return compareTextureCache(options);
+    }
+
+    if (options.environmentWidth > 0)
+    {
+        return compareEnvironment(options);
+    }
+
+    if (options.outOfCoreWidth > 0)
+    {
+        return compareOutOfCore(options);
+    }
+
+    if (options.fastMathWidth > 0)
+    {
+        return compareFastMath(options);
+    }
+
+    if (options.bandedWidth > 0)
+    {
+        return compareBandedRender(options);
+    }
+
+    std::cout << std::setw(10) << "objects"
+              << std::setw(12) << "gen [s]"
+              << std::setw(12) << "build [s]"
+              << std::setw(14) << "bytes/prim"
+              << std::setw(14) << "bvh B/prim"
+              << std::setw(16) << "primary Mray/s"
+              << std::setw(16) << "diffuse Mray/s"
+              << std::setw(16) << "shadow Mray/s"
+              << std::setw(10) << "hit %" << '\n';
+
+    for (std::size_t count = options.minCount; count <= options.maxCount; count *= 10)
+    {
+        SceneGenerator<T> generator;
+        generator.setObjectCount(count);
+        generator.setSeed(options.seed);
+        generator.setLayout(options.layout);
+        generator.setSizeDistribution(options.sizes);
+        generator.setMaterialPaletteSize(options.paletteSize);
+
+        const std::size_t heapBefore = heapBytesInUse();
+
+        const auto generateStart = std::chrono::steady_clock::now();
+        const auto world = generator.generate();
+        const auto buildStart = std::chrono::steady_clock::now();
+        const BVH<T> bvh(world);
+        const auto buildEnd = std::chrono::steady_clock::now();
+
+        const std::size_t heapAfter = heapBytesInUse();
+
+        const double generateSeconds = std::chrono::duration<double>(buildStart - generateStart).count();
+        const double buildSeconds = std::chrono::duration<double>(buildEnd - buildStart).count();
+        const double bytesPerPrimitive = static_cast<double>(heapAfter - heapBefore) / static_cast<double>(count);
+        const double bvhBytesPerPrimitive = static_cast<double>(bvh.tree().memoryBytes() + bvh.wideTree().memoryBytes()) / static_cast<double>(count);
+
+        // Generated scenes are deterministic, so the same rays are traced at every size
+        std::mt19937_64 engine(options.seed);
+        // Field scenes exclude the ground sphere, which would dwarf the region of interest
+        const T halfExtent = generator.extent() / 2;
+        const auto bounds = (options.layout == SceneGenerator<T>::Layout::Field)
+                                ? AABB<T>(Point3<T>(-halfExtent, 0, -halfExtent),
+                                          Point3<T>(halfExtent, 2 * generator.maxRadius(), halfExtent))
+                                : bvh.boundingBox();
+        const auto primary = primaryRays(bounds, options.numRays, engine);
+        const auto diffuse = incoherentRays(bounds, options.numRays, engine);
+
+        std::size_t primaryHits = 0;
+        std::size_t diffuseHits = 0;
+        const double primaryMrays = traceMraysPerSecond(bvh, primary, primaryHits);
+        const double diffuseMrays = traceMraysPerSecond(bvh, diffuse, diffuseHits);
+        std::size_t blockedRays = 0;
+        const double shadowMrays = occludedMraysPerSecond(bvh, diffuse, blockedRays);
+        const double hitPercent = 100.0 * static_cast<double>(primaryHits + diffuseHits) /
+                                  static_cast<double>(primary.size() + diffuse.size());
+
+        std::cout << std::fixed
+                  << std::setw(10) << count
+                  << std::setw(12) << std::setprecision(3) << generateSeconds
+                  << std::setw(12) << std::setprecision(3) << buildSeconds
+                  << std::setw(14) << std::setprecision(1) << bytesPerPrimitive
+                  << std::setw(14) << std::setprecision(1) << bvhBytesPerPrimitive
+                  << std::setw(16) << std::setprecision(2) << primaryMrays
+                  << std::setw(16) << std::setprecision(2) << diffuseMrays
+                  << std::setw(16) << std::setprecision(2) << shadowMrays
+                  << std::setw(10) << std::setprecision(1) << hitPercent << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
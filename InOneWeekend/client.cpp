@@ -0,0 +1,107 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "unix_socket.hpp"
+
+// Command-line client of the render server (RayTracerInOneWeekend --serve <socket>). Sends one
+// job, writes the image it gets back and reports the timings.
+namespace
+{
+    void printUsage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " <socket> <output.ppm | -> [job line]...\n"
+                  << "       " << program << " <socket> --shutdown\n"
+                  << "Each job line is one setting, e.g. \"objects 10000\", \"width 640\", \"spp 16\",\n"
+                  << "\"depth 8\", \"look-from 0 2 10\", \"look-at 0 0 0\", \"obj model.obj\" or \"format plain\".\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::string socketPath = argv[1];
+    const std::string_view output = argv[2];
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto connection = UnixSocket::connect(socketPath);
+
+        std::string request;
+        if (output == "--shutdown")
+        {
+            request = "shutdown\n";
+        }
+        else
+        {
+            for (int i = 3; i < argc; ++i)
+            {
+                request += std::string(argv[i]) + '\n';
+            }
+            request += "render\n";
+        }
+        connection.sendAll(request);
+
+        std::string status;
+        if (!connection.readLine(status))
+        {
+            std::cerr << "Server closed the connection\n";
+            return EXIT_FAILURE;
+        }
+        if (status.rfind("ok ", 0) != 0)
+        {
+            std::cerr << status << '\n';
+            return EXIT_FAILURE;
+        }
+
+        const std::size_t size = std::stoull(status.substr(3));
+        std::string image;
+        if (!connection.readExact(size, image))
+        {
+            std::cerr << "Server closed the connection\n";
+            return EXIT_FAILURE;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (output == "-")
+        {
+            std::cout.write(image.data(), static_cast<std::streamsize>(image.size()));
+        }
+        else if (output != "--shutdown")
+        {
+            std::ofstream file(std::string(output), std::ios::binary);
+            file.write(image.data(), static_cast<std::streamsize>(image.size()));
+            if (!file)
+            {
+                std::cerr << "Cannot write file: " << output << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+
+        std::cerr << status << std::fixed << std::setprecision(3) << " round trip " << seconds << '\n';
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_AABB_HPP
+#define INONEWEEKEND_INCLUDE_AABB_HPP
+
+#include <concepts>
+#include <utility>
+
+#include "interval.hpp"
+#include "ray.hpp"
+#include "vector3.hpp"
+
+template <std::floating_point T = double>
+class AABB
+{
+public:
+    // Default bounding box is empty, since intervals are empty by default
+    constexpr AABB() = default;
+
+    constexpr AABB(const Interval<T> &x, const Interval<T> &y, const Interval<T> &z)
+        : m_x(x), m_y(y), m_z(z) {}
+
+    constexpr AABB(const Point3<T> &a, const Point3<T> &b)
+        // Treat the two points a and b as extrema for the bounding box
+        : m_x(a.x() <= b.x() ? Interval<T>(a.x(), b.x()) : Interval<T>(b.x(), a.x())),
+          m_y(a.y() <= b.y() ? Interval<T>(a.y(), b.y()) : Interval<T>(b.y(), a.y())),
+          m_z(a.z() <= b.z() ? Interval<T>(a.z(), b.z()) : Interval<T>(b.z(), a.z()))
+    {
+    }
+
+    constexpr AABB(const AABB<T> &a, const AABB<T> &b)
+        // Tightest box enclosing both input boxes
+        : m_x(a.m_x, b.m_x), m_y(a.m_y, b.m_y), m_z(a.m_z, b.m_z)
+    {
+    }
+
+    constexpr const Interval<T> &x() const { return m_x; }
+    constexpr const Interval<T> &y() const { return m_y; }
+    constexpr const Interval<T> &z() const { return m_z; }
+
+    constexpr const Interval<T> &axisInterval(int n) const
+    {
+        if (n == 1)
+        {
+            return m_y;
+        }
+        if (n == 2)
+        {
+            return m_z;
+        }
+        return m_x;
+    }
+
+    constexpr Point3<T> min() const { return Point3<T>(m_x.min(), m_y.min(), m_z.min()); }
+    constexpr Point3<T> max() const { return Point3<T>(m_x.max(), m_y.max(), m_z.max()); }
+
+    constexpr Point3<T> centroid() const
+    {
+        return Point3<T>((m_x.min() + m_x.max()) / 2,
+                         (m_y.min() + m_y.max()) / 2,
+                         (m_z.min() + m_z.max()) / 2);
+    }
+
+    constexpr bool isEmpty() const
+    {
+        return m_x.isEmpty() || m_y.isEmpty() || m_z.isEmpty();
+    }
+
+    constexpr int longestAxis() const
+    {
+        // Returns the index of the longest axis of the bounding box
+        if (m_x.size() > m_y.size())
+        {
+            return m_x.size() > m_z.size() ? 0 : 2;
+        }
+        return m_y.size() > m_z.size() ? 1 : 2;
+    }
+
+    constexpr T surfaceArea() const
+    {
+        if (isEmpty())
+        {
+            return 0;
+        }
+        const T dx = m_x.size();
+        const T dy = m_y.size();
+        const T dz = m_z.size();
+        return 2 * (dx * dy + dy * dz + dz * dx);
+    }
+
+    bool hit(const Ray<T> &r, Interval<T> rayT) const
+    {
+        const Vector3<T> invDirection(static_cast<T>(1.0) / r.direction().x(),
+                                      static_cast<T>(1.0) / r.direction().y(),
+                                      static_cast<T>(1.0) / r.direction().z());
+        return hit(r.origin(), invDirection, rayT);
+    }
+
+    bool hit(const Point3<T> &origin, const Vector3<T> &invDirection, Interval<T> rayT) const
+    {
+        // Slab test with the reciprocal ray direction precomputed by the caller, so that
+        // traversal of a hierarchy pays for the three divisions once per ray
+        T tMin = rayT.min();
+        T tMax = rayT.max();
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const Interval<T> &ax = axisInterval(axis);
+            T t0 = (ax.min() - origin[axis]) * invDirection[axis];
+            T t1 = (ax.max() - origin[axis]) * invDirection[axis];
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+
+            tMin = t0 > tMin ? t0 : tMin;
+            tMax = t1 < tMax ? t1 : tMax;
+
+            if (tMax < tMin)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static constexpr AABB<T> empty()
+    {
+        return AABB<T>(Interval<T>::empty(), Interval<T>::empty(), Interval<T>::empty());
+    }
+
+    static constexpr AABB<T> universe()
+    {
+        return AABB<T>(Interval<T>::universe(), Interval<T>::universe(), Interval<T>::universe());
+    }
+
+private:
+    Interval<T> m_x{};
+    Interval<T> m_y{};
+    Interval<T> m_z{};
+};
+
+#endif /* INONEWEEKEND_INCLUDE_AABB_HPP */
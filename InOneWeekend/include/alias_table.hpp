@@ -0,0 +1,108 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_ALIAS_TABLE_HPP
+#define INONEWEEKEND_INCLUDE_ALIAS_TABLE_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <vector>
+
+// Walker's alias method: draws index i with probability weights[i] / sum(weights) in constant
+// time from a single uniform random number, regardless of the number of entries
+template <std::floating_point T = double>
+class AliasTable
+{
+public:
+    AliasTable() = default;
+
+    explicit AliasTable(const std::vector<T> &weights)
+    {
+        build(weights);
+    }
+
+    std::size_t size() const { return m_entries.size(); }
+    bool isEmpty() const { return m_entries.empty(); }
+
+    // Probability of drawing index i
+    T pmf(std::size_t i) const { return m_entries[i].pmf; }
+
+    void build(const std::vector<T> &weights)
+    {
+        const std::size_t n = weights.size();
+        m_entries.assign(n, Entry{});
+        if (n == 0)
+        {
+            return;
+        }
+
+        T total = 0;
+        for (const T weight : weights)
+        {
+            total += weight;
+        }
+
+        // Scaled probabilities average to one; entries below one get topped up by an alias
+        std::vector<T> scaled(n);
+        std::vector<std::uint32_t> small;
+        std::vector<std::uint32_t> large;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            m_entries[i].pmf = (total > 0) ? weights[i] / total : static_cast<T>(1.0) / static_cast<T>(n);
+            scaled[i] = m_entries[i].pmf * static_cast<T>(n);
+            (scaled[i] < 1 ? small : large).push_back(static_cast<std::uint32_t>(i));
+        }
+
+        while (!small.empty() && !large.empty())
+        {
+            const auto less = small.back();
+            small.pop_back();
+            const auto more = large.back();
+            large.pop_back();
+
+            m_entries[less].threshold = scaled[less];
+            m_entries[less].alias = more;
+
+            scaled[more] = (scaled[more] + scaled[less]) - 1;
+            (scaled[more] < 1 ? small : large).push_back(more);
+        }
+
+        // Whatever is left is one up to rounding error
+        for (const auto i : large)
+        {
+            m_entries[i].threshold = 1;
+        }
+        for (const auto i : small)
+        {
+            m_entries[i].threshold = 1;
+        }
+    }
+
+    // Maps a uniform random number in [0, 1) to an index
+    std::size_t sample(T u) const
+    {
+        const T scaled = u * static_cast<T>(m_entries.size());
+        auto i = static_cast<std::size_t>(scaled);
+        i = (i < m_entries.size()) ? i : m_entries.size() - 1;
+
+        // The fractional part decides between the entry and its alias
+        const T remainder = scaled - static_cast<T>(i);
+        return (remainder < m_entries[i].threshold) ? i : m_entries[i].alias;
+    }
+
+private:
+    struct Entry
+    {
+        T threshold{1};
+        T pmf{0};
+        std::uint32_t alias{0};
+    };
+
+    std::vector<Entry> m_entries{};
+};
+
+#endif /* INONEWEEKEND_INCLUDE_ALIAS_TABLE_HPP */
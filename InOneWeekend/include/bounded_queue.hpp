@@ -0,0 +1,89 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_BOUNDED_QUEUE_HPP
+#define INONEWEEKEND_INCLUDE_BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+// Blocking multi-producer multi-consumer queue with a fixed capacity. Producers wait while it
+// is full, which bounds the memory held by a slow consumer, e.g. frames waiting to be encoded.
+template <typename Item>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity)
+        : m_capacity(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    std::size_t capacity() const { return m_capacity; }
+
+    // Waits for free space, returns false without queueing if the queue was closed
+    bool push(Item item)
+    {
+        std::unique_lock lock(m_mutex);
+        m_notFull.wait(lock, [this]
+                       { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed)
+        {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // Waits for an item, empty once the queue is closed and drained
+    std::optional<Item> pop()
+    {
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [this]
+                        { return m_closed || !m_items.empty(); });
+        if (m_items.empty())
+        {
+            return std::nullopt;
+        }
+
+        Item item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    // Rejects further pushes and wakes all waiters; queued items can still be popped
+    void close()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    std::size_t m_capacity;
+    std::deque<Item> m_items{};
+    bool m_closed{false};
+    std::mutex m_mutex{};
+    std::condition_variable m_notFull{};
+    std::condition_variable m_notEmpty{};
+};
+
+#endif /* INONEWEEKEND_INCLUDE_BOUNDED_QUEUE_HPP */
@@ -0,0 +1,150 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_BVH_HPP
+#define INONEWEEKEND_INCLUDE_BVH_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "aabb.hpp"
+#include "bvh_tree.hpp"
+#include "hittable.hpp"
+#include "hittable_list.hpp"
+#include "interval.hpp"
+#include "ray.hpp"
+#include "thread_pool.hpp"
+#include "wide_bvh.hpp"
+
+// Scene-level acceleration structure over the objects of a HittableList. The binary tree is
+// built, saved and refitted; rays traverse the 8-wide tree collapsed from it.
+template <std::floating_point T = double>
+class BVH : public Hittable<T>
+{
+public:
+    // Builds the tree, on the threads of threadPool if given
+    explicit BVH(const HittableList<T> &list,
+                 typename BVHTree<T>::Builder builder = BVHTree<T>::Builder::SAH,
+                 ThreadPool *threadPool = nullptr)
+        : m_objects(list.objects()), m_tree(objectBounds(list, threadPool), builder, threadPool), m_wideTree(m_tree)
+    {
+    }
+
+    // Over a tree built earlier for the same objects, e.g. one loaded by BVHCache
+    BVH(const HittableList<T> &list, BVHTree<T> tree)
+        : m_objects(list.objects()), m_tree(std::move(tree)), m_wideTree()
+    {
+        if (m_tree.primitiveIndices().size() != m_objects.size())
+        {
+            throw std::invalid_argument("BVH: tree does not match the objects");
+        }
+        m_wideTree.build(m_tree);
+    }
+
+    // What the tree over the objects of a list is built from
+    static std::vector<AABB<T>> objectBounds(const HittableList<T> &list, ThreadPool *threadPool = nullptr)
+    {
+        const auto &objects = list.objects();
+        std::vector<AABB<T>> bounds(objects.size());
+        const auto boundChunk = [&](std::size_t chunk)
+        {
+            const std::size_t end = std::min(objects.size(), (chunk + 1) * s_boundsChunkSize);
+            for (std::size_t i = chunk * s_boundsChunkSize; i < end; ++i)
+            {
+                bounds[i] = objects[i]->boundingBox();
+            }
+        };
+        const std::size_t numChunks = (objects.size() + s_boundsChunkSize - 1) / s_boundsChunkSize;
+        if (threadPool != nullptr && numChunks > 1)
+        {
+            threadPool->parallelFor(numChunks, boundChunk);
+        }
+        else
+        {
+            for (std::size_t chunk = 0; chunk < numChunks; ++chunk)
+            {
+                boundChunk(chunk);
+            }
+        }
+        return bounds;
+    }
+
+    virtual ~BVH() override = default;
+
+    const BVHTree<T> &tree() const { return m_tree; }
+    const WideBVHTree<T> &wideTree() const { return m_wideTree; }
+
+    // Catches the tree up with objects that moved since it was built
+    void refit()
+    {
+        std::vector<AABB<T>> bounds;
+        bounds.reserve(m_objects.size());
+        for (const auto &object : m_objects)
+        {
+            bounds.push_back(object->boundingBox());
+        }
+        m_tree.refit(bounds);
+        m_wideTree.build(m_tree);
+    }
+
+    virtual bool intersect(
+        const Ray<T> &r,
+        Interval<T> rayT,
+        SurfaceHit<T> &surface) const override
+    {
+        return m_wideTree.traverse(
+            r, rayT,
+            [&](std::uint32_t object, Interval<T> &currentT)
+            {
+                if (!m_objects[object]->intersect(r, currentT, surface))
+                {
+                    return false;
+                }
+                currentT = Interval<T>(currentT.min(), surface.t);
+                return true;
+            });
+    }
+
+    virtual bool occluded(
+        const Ray<T> &r,
+        Interval<T> rayT) const override
+    {
+        return m_wideTree.traverseAny(
+            r, rayT,
+            [&](std::uint32_t object, const Interval<T> &currentT)
+            {
+                return m_objects[object]->occluded(r, currentT);
+            });
+    }
+
+    virtual bool onlyDiffuse() const override
+    {
+        return std::all_of(m_objects.begin(), m_objects.end(), [](const auto &object)
+                           { return object->onlyDiffuse(); });
+    }
+
+    virtual AABB<T> boundingBox() const override
+    {
+        return m_tree.bounds();
+    }
+
+private:
+    // Objects whose bounds one thread computes at a time
+    static constexpr std::size_t s_boundsChunkSize = 4096;
+
+    std::vector<std::shared_ptr<Hittable<T>>> m_objects;
+    BVHTree<T> m_tree;
+    WideBVHTree<T> m_wideTree;
+};
+
+#endif /* INONEWEEKEND_INCLUDE_BVH_HPP */
@@ -0,0 +1,224 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_BVH_CACHE_HPP
+#define INONEWEEKEND_INCLUDE_BVH_CACHE_HPP
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <unistd.h>
+
+#include "bvh_tree.hpp"
+#include "mapped_file.hpp"
+
+// Fixed-size start of a BVH file. The node array follows at nodeOffset and the primitive
+// indices at indexOffset, both exactly as they are laid out in memory.
+struct BVHFileHeader
+{
+    std::array<char, 8> magic{};
+    std::uint32_t version{0};
+    std::uint32_t byteOrder{0};  // s_byteOrder as written, tells a file from another endianness
+    std::uint32_t scalarBytes{0}; // sizeof(T) of the bounds
+    std::uint32_t nodeBytes{0};
+    std::uint64_t sceneKey{0};
+    std::uint64_t primitiveCount{0};
+    std::uint64_t nodeCount{0};
+    std::uint64_t nodeOffset{0};
+    std::uint64_t indexOffset{0};
+    std::uint64_t checksum{0}; // BVHCache::checksum of both arrays
+};
+
+// Acceleration structures saved in a directory, one file per scene keyed by a hash of the
+// scene input (see RenderJob::sceneKey). A later run maps the file and traverses the nodes in
+// place instead of building the tree again, which for a million spheres saves seconds of SAH
+// binning before the first ray.
+//
+// Files hold the raw arrays of one build of this code: the version has to go up whenever the
+// builder or the node layout changes. Files that do not match, are damaged or do not pass
+// BVHTree::isValid are ignored and rebuilt.
+template <std::floating_point T = double>
+class BVHCache
+{
+public:
+    static constexpr std::array<char, 8> s_magic{'R', 'T', 'B', 'V', 'H', '\0', '\0', '\0'};
+    static constexpr std::uint32_t s_version = 2;
+    static constexpr std::uint32_t s_byteOrder = 0x01020304;
+
+    static_assert(std::is_trivially_copyable_v<BVHNode<T>>, "BVH nodes are written as raw bytes");
+
+    explicit BVHCache(std::string directory)
+        : m_directory(std::move(directory))
+    {
+    }
+
+    const std::string &directory() const { return m_directory; }
+
+    std::string path(std::uint64_t key) const
+    {
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key << '-' << std::dec << 8 * sizeof(T) << ".bvh";
+        return (std::filesystem::path(m_directory) / name.str()).string();
+    }
+
+    // The tree saved under key for primitiveCount primitives, viewed in the mapped file, or
+    // nothing if there is no such file or it does not hold a usable tree
+    std::optional<BVHTree<T>> load(std::uint64_t key, std::size_t primitiveCount) const
+    {
+        std::shared_ptr<const MappedFile> file;
+        try
+        {
+            file = std::make_shared<const MappedFile>(path(key), MappedFile::Access::Prefetch);
+        }
+        catch (const std::exception &)
+        {
+            return std::nullopt;
+        }
+
+        BVHFileHeader header;
+        if (file->size() < sizeof(header))
+        {
+            return std::nullopt;
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+
+        if (header.magic != s_magic || header.version != s_version || header.byteOrder != s_byteOrder ||
+            header.scalarBytes != sizeof(T) || header.nodeBytes != sizeof(BVHNode<T>) ||
+            header.sceneKey != key || header.primitiveCount != primitiveCount ||
+            header.nodeOffset % alignof(BVHNode<T>) != 0 || header.indexOffset % alignof(std::uint32_t) != 0 ||
+            header.nodeOffset > file->size() || header.indexOffset > file->size() ||
+            header.nodeCount > (file->size() - header.nodeOffset) / sizeof(BVHNode<T>) ||
+            header.primitiveCount > (file->size() - header.indexOffset) / sizeof(std::uint32_t))
+        {
+            return std::nullopt;
+        }
+
+        // The mapping is page aligned, so the arrays are as aligned as their offsets
+        const std::span<const BVHNode<T>> nodes(
+            reinterpret_cast<const BVHNode<T> *>(file->data() + header.nodeOffset), header.nodeCount);
+        const std::span<const std::uint32_t> indices(
+            reinterpret_cast<const std::uint32_t *>(file->data() + header.indexOffset), header.primitiveCount);
+        if (checksum(nodes, indices) != header.checksum || !BVHTree<T>::isValid(nodes, indices, primitiveCount))
+        {
+            return std::nullopt;
+        }
+
+        return BVHTree<T>(std::move(file), nodes, indices);
+    }
+
+    // Saves a tree under key. The file is written next to its final name and renamed, so a
+    // concurrent load sees either the old file or the complete new one.
+    void save(std::uint64_t key, const BVHTree<T> &tree) const
+    {
+        const auto nodes = tree.nodes();
+        const auto indices = tree.primitiveIndices();
+
+        BVHFileHeader header;
+        header.magic = s_magic;
+        header.version = s_version;
+        header.byteOrder = s_byteOrder;
+        header.scalarBytes = sizeof(T);
+        header.nodeBytes = sizeof(BVHNode<T>);
+        header.sceneKey = key;
+        header.primitiveCount = indices.size();
+        header.nodeCount = nodes.size();
+        header.nodeOffset = s_arrayAlignment;
+        header.indexOffset = header.nodeOffset + nodes.size_bytes();
+        header.checksum = checksum(nodes, indices);
+
+        std::filesystem::create_directories(m_directory);
+        const std::string finalPath = path(key);
+        const std::string temporaryPath = finalPath + ".tmp" + std::to_string(::getpid());
+
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            const std::array<char, s_arrayAlignment - sizeof(header)> padding{};
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(padding.data(), padding.size());
+            file.write(reinterpret_cast<const char *>(nodes.data()), static_cast<std::streamsize>(nodes.size_bytes()));
+            file.write(reinterpret_cast<const char *>(indices.data()), static_cast<std::streamsize>(indices.size_bytes()));
+            if (!file.flush())
+            {
+                std::filesystem::remove(temporaryPath);
+                throw std::runtime_error("BVHCache: cannot write " + temporaryPath);
+            }
+        }
+        std::filesystem::rename(temporaryPath, finalPath);
+    }
+
+    // The saved tree if there is one, otherwise build() saved for the next run; `loaded` tells
+    // which. Failing to save only costs the next run a build, so it is reported and ignored.
+    template <typename BuildTree>
+    BVHTree<T> getOrBuild(std::uint64_t key, std::size_t primitiveCount, BuildTree &&build, bool &loaded) const
+    {
+        if (auto tree = load(key, primitiveCount))
+        {
+            loaded = true;
+            return std::move(*tree);
+        }
+
+        BVHTree<T> tree = build();
+        try
+        {
+            save(key, tree);
+        }
+        catch (const std::exception &e)
+        {
+            std::clog << "BVHCache: " << e.what() << '\n';
+        }
+        loaded = false;
+        return tree;
+    }
+
+    // Hash of the arrays, eight bytes per step so that checking a large file stays cheap next
+    // to reading it
+    static std::uint64_t checksum(std::span<const BVHNode<T>> nodes, std::span<const std::uint32_t> indices)
+    {
+        const auto hashBytes = [](std::span<const std::byte> data, std::uint64_t hash)
+        {
+            std::size_t i = 0;
+            for (; i + sizeof(std::uint64_t) <= data.size(); i += sizeof(std::uint64_t))
+            {
+                std::uint64_t word;
+                std::memcpy(&word, data.data() + i, sizeof(word));
+                hash = std::rotl((hash ^ word) * 0x9E3779B97F4A7C15ull, 29);
+            }
+            for (; i < data.size(); ++i)
+            {
+                hash = std::rotl((hash ^ static_cast<std::uint64_t>(data[i])) * 0x9E3779B97F4A7C15ull, 29);
+            }
+            return hash;
+        };
+        return hashBytes(std::as_bytes(indices), hashBytes(std::as_bytes(nodes), 0xCBF29CE484222325ull));
+    }
+
+private:
+    // Offset of the node array, keeps nodes on their own cache lines
+    static constexpr std::size_t s_arrayAlignment = 128;
+
+    static_assert(sizeof(BVHFileHeader) <= s_arrayAlignment);
+
+    std::string m_directory;
+};
+
+#endif /* INONEWEEKEND_INCLUDE_BVH_CACHE_HPP */
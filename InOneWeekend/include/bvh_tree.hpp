@@ -0,0 +1,897 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_BVH_TREE_HPP
+#define INONEWEEKEND_INCLUDE_BVH_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "aabb.hpp"
+#include "interval.hpp"
+#include "ray.hpp"
+#include "space_filling_curve.hpp"
+#include "thread_pool.hpp"
+#include "vector3.hpp"
+
+// A node of the flattened hierarchy. Nodes are stored depth-first, so the first child of an
+// interior node always directly follows it and only the second child needs an explicit index.
+template <std::floating_point T = double>
+struct BVHNode
+{
+    AABB<T> bounds{};
+    std::uint32_t offset{0}; // Interior: index of the second child. Leaf: first primitive slot
+    std::uint16_t count{0};  // Number of primitives in a leaf, 0 for interior nodes
+    std::uint16_t axis{0};   // Split axis of an interior node, used to order traversal
+};
+
+// Bounding volume hierarchy over an indexed set of primitives, built with the surface area
+// heuristic or from Morton codes, optionally on several threads. The tree only knows the bounds
+// of each primitive; the owner supplies the ray-primitive intersection during traversal, which
+// lets the same structure serve both the scene (over Hittables) and triangle meshes.
+//
+// Nodes and primitive indices are flat arrays without pointers, so a tree either owns them or
+// views them in memory kept alive by someone else, such as a mapped BVH file (see BVHCache).
+template <std::floating_point T = double>
+class BVHTree
+{
+public:
+    static constexpr std::uint32_t s_maxLeafSize = 4;
+
+    BVHTree() = default;
+
+    // How build() chooses splits. The surface area heuristic gives the trees that trace fastest;
+    // sorting primitives along a Morton curve and splitting at its bits builds several times
+    // faster, for scenes that are rebuilt every frame.
+    enum class Builder
+    {
+        SAH,
+        Morton
+    };
+
+    explicit BVHTree(const std::vector<AABB<T>> &primitiveBounds, Builder builder = Builder::SAH,
+                     ThreadPool *threadPool = nullptr)
+    {
+        build(primitiveBounds, builder, threadPool);
+    }
+
+    // A tree stored elsewhere; storage keeps the memory behind the views alive
+    BVHTree(std::shared_ptr<const void> storage,
+            std::span<const BVHNode<T>> nodes,
+            std::span<const std::uint32_t> primitiveIndices)
+        : m_storage(std::move(storage)), m_nodeView(nodes), m_indexView(primitiveIndices)
+    {
+    }
+
+    BVHTree(const BVHTree &other)
+        : m_nodes(other.m_nodes), m_primitiveIndices(other.m_primitiveIndices), m_storage(other.m_storage)
+    {
+        adoptViews(other);
+    }
+
+    BVHTree &operator=(const BVHTree &other)
+    {
+        if (this != &other)
+        {
+            m_nodes = other.m_nodes;
+            m_primitiveIndices = other.m_primitiveIndices;
+            m_storage = other.m_storage;
+            adoptViews(other);
+        }
+        return *this;
+    }
+
+    // Moving a vector keeps its buffer, so the views stay valid
+    BVHTree(BVHTree &&) noexcept = default;
+    BVHTree &operator=(BVHTree &&) noexcept = default;
+
+    std::span<const BVHNode<T>> nodes() const { return m_nodeView; }
+    std::span<const std::uint32_t> primitiveIndices() const { return m_indexView; }
+
+    // True if the nodes and indices are viewed rather than owned
+    bool isMapped() const { return m_storage != nullptr; }
+
+    std::size_t memoryBytes() const
+    {
+        if (isMapped())
+        {
+            return m_nodeView.size_bytes() + m_indexView.size_bytes();
+        }
+        return m_nodes.capacity() * sizeof(BVHNode<T>) +
+               m_primitiveIndices.capacity() * sizeof(std::uint32_t);
+    }
+
+    AABB<T> bounds() const
+    {
+        return m_nodeView.empty() ? AABB<T>() : m_nodeView.front().bounds;
+    }
+
+    // Checks a tree that was not built here before it is traversed: every child and primitive
+    // range lies inside the arrays, children follow their parents, and no path is deeper than
+    // the traversal stack
+    static bool isValid(std::span<const BVHNode<T>> nodes,
+                        std::span<const std::uint32_t> primitiveIndices,
+                        std::size_t primitiveCount)
+    {
+        if (nodes.empty())
+        {
+            return primitiveIndices.empty();
+        }
+
+        std::vector<std::uint8_t> depths(nodes.size(), 0);
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            const auto &node = nodes[i];
+            if (node.count > 0)
+            {
+                if (static_cast<std::size_t>(node.offset) + node.count > primitiveIndices.size())
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            if (node.axis > 2 || node.offset <= i + 1 || node.offset >= nodes.size() ||
+                depths[i] + 1u >= s_stackSize)
+            {
+                return false;
+            }
+            depths[i + 1] = static_cast<std::uint8_t>(depths[i] + 1);
+            depths[node.offset] = static_cast<std::uint8_t>(depths[i] + 1);
+        }
+
+        return std::all_of(primitiveIndices.begin(), primitiveIndices.end(), [&](std::uint32_t primitive)
+                           { return primitive < primitiveCount; });
+    }
+
+    // Builds over the primitives, on the threads of threadPool if given. Ranges of at least
+    // s_parallelSplitSize primitives are split one at a time with every thread binning and
+    // partitioning a share; the subtrees below them are then built side by side, one per thread.
+    // The tree does not depend on the number of threads.
+    void build(const std::vector<AABB<T>> &primitiveBounds, Builder builder = Builder::SAH,
+               ThreadPool *threadPool = nullptr)
+    {
+        const auto count = static_cast<std::uint32_t>(primitiveBounds.size());
+
+        m_nodes.clear();
+        m_primitiveIndices.resize(count);
+        std::iota(m_primitiveIndices.begin(), m_primitiveIndices.end(), 0u);
+        m_storage.reset();
+        m_nodeView = m_nodes;
+        m_indexView = m_primitiveIndices;
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        BuildContext context{primitiveBounds, std::vector<Point3<T>>(count), {}, {}, builder, threadPool};
+        forEachChunk(context, 0, count, [&](std::size_t, std::uint32_t begin, std::uint32_t end)
+                     {
+                         for (std::uint32_t i = begin; i < end; ++i)
+                         {
+                             context.centroids[i] = primitiveBounds[i].centroid();
+                         }
+                     });
+        if (builder == Builder::Morton)
+        {
+            sortByMortonCode(context);
+        }
+
+        // Top of the tree, split with all threads
+        std::vector<TopNode> top;
+        std::vector<Subtree> subtrees;
+        splitTop(context, 0, count, 0, top, subtrees);
+
+        // Subtrees, largest first so that the last ones to finish are small
+        std::vector<std::size_t> order(subtrees.size());
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+                  { return subtrees[a].end - subtrees[a].begin > subtrees[b].end - subtrees[b].begin; });
+        forEach(threadPool, order.size(), [&](std::size_t i)
+                {
+                    auto &subtree = subtrees[order[i]];
+                    buildRecursive(context, subtree.nodes, subtree.begin, subtree.end, subtree.depth);
+                });
+
+        // Depth-first layout: place every node, copy the subtrees in and finish the top nodes,
+        // children before parents
+        std::uint32_t numNodes = 0;
+        place(BuildRef{0, top.empty()}, top, subtrees, numNodes);
+        m_nodes.resize(numNodes);
+        forEach(threadPool, subtrees.size(), [&](std::size_t i)
+                {
+                    const auto &subtree = subtrees[i];
+                    for (std::size_t n = 0; n < subtree.nodes.size(); ++n)
+                    {
+                        auto node = subtree.nodes[n];
+                        node.offset += (node.count == 0) ? subtree.base : 0;
+                        m_nodes[subtree.base + n] = node;
+                    }
+                });
+        for (auto node = top.rbegin(); node != top.rend(); ++node)
+        {
+            const auto bounds = AABB<T>(m_nodes[node->base + 1].bounds, m_nodes[node->secondBase].bounds);
+            m_nodes[node->base] = BVHNode<T>{bounds, node->secondBase, 0, node->axis};
+        }
+
+        m_nodeView = m_nodes;
+        m_indexView = m_primitiveIndices;
+    }
+
+    // Updates the bounds of every node after primitives moved, keeping the topology. Much
+    // cheaper than a build, but the tree gets worse the further primitives move.
+    void refit(const std::vector<AABB<T>> &primitiveBounds)
+    {
+        if (isMapped())
+        {
+            // The mapped arrays are read-only, edits go to a copy
+            m_nodes.assign(m_nodeView.begin(), m_nodeView.end());
+            m_primitiveIndices.assign(m_indexView.begin(), m_indexView.end());
+            m_storage.reset();
+            m_nodeView = m_nodes;
+            m_indexView = m_primitiveIndices;
+        }
+
+        // Children follow their parents, so walking backwards visits them first
+        for (std::size_t n = m_nodes.size(); n-- > 0;)
+        {
+            auto &node = m_nodes[n];
+            if (node.count > 0)
+            {
+                AABB<T> bounds;
+                for (std::uint32_t i = 0; i < node.count; ++i)
+                {
+                    bounds = AABB<T>(bounds, primitiveBounds[m_primitiveIndices[node.offset + i]]);
+                }
+                node.bounds = bounds;
+            }
+            else
+            {
+                node.bounds = AABB<T>(m_nodes[n + 1].bounds, m_nodes[node.offset].bounds);
+            }
+        }
+    }
+
+    // Walks the hierarchy front to back and calls intersect(primitiveIndex, rayT) for every
+    // primitive in a leaf whose box the ray enters. On a hit, the callback must shrink rayT to
+    // end at the hit distance so that farther subtrees get culled. Returns true if any call hit.
+    // numNodesVisited, if given, counts the nodes fetched, for comparing layouts.
+    template <typename IntersectPrimitive>
+    bool traverse(const Ray<T> &r, Interval<T> rayT, IntersectPrimitive &&intersect,
+                  std::size_t *numNodesVisited = nullptr) const
+    {
+        if (m_nodeView.empty())
+        {
+            return false;
+        }
+
+        const auto &origin = r.origin();
+        const Vector3<T> invDirection(static_cast<T>(1.0) / r.direction().x(),
+                                      static_cast<T>(1.0) / r.direction().y(),
+                                      static_cast<T>(1.0) / r.direction().z());
+        const std::array<bool, 3> directionIsNegative{invDirection.x() < 0,
+                                                      invDirection.y() < 0,
+                                                      invDirection.z() < 0};
+
+        std::array<std::uint32_t, s_stackSize> stack;
+        std::size_t stackSize = 0;
+        std::uint32_t current = 0;
+        bool hitAnything = false;
+
+        while (true)
+        {
+            if (numNodesVisited != nullptr)
+            {
+                ++*numNodesVisited;
+            }
+
+            const auto &node = m_nodeView[current];
+            if (node.bounds.hit(origin, invDirection, rayT))
+            {
+                if (node.count > 0)
+                {
+                    for (std::uint32_t i = 0; i < node.count; ++i)
+                    {
+                        if (intersect(m_indexView[node.offset + i], rayT))
+                        {
+                            hitAnything = true;
+                        }
+                    }
+                }
+                else
+                {
+                    // Visit the child on the near side of the split plane first
+                    if (directionIsNegative[node.axis])
+                    {
+                        stack[stackSize++] = current + 1;
+                        current = node.offset;
+                    }
+                    else
+                    {
+                        stack[stackSize++] = node.offset;
+                        current = current + 1;
+                    }
+                    continue;
+                }
+            }
+
+            if (stackSize == 0)
+            {
+                break;
+            }
+            current = stack[--stackSize];
+        }
+
+        return hitAnything;
+    }
+
+    // Any-hit traversal: returns true as soon as occludes(primitiveIndex, rayT) does
+    template <typename OccludesPrimitive>
+    bool traverseAny(const Ray<T> &r, Interval<T> rayT, OccludesPrimitive &&occludes,
+                     std::size_t *numNodesVisited = nullptr) const
+    {
+        if (m_nodeView.empty())
+        {
+            return false;
+        }
+
+        const auto &origin = r.origin();
+        const Vector3<T> invDirection(static_cast<T>(1.0) / r.direction().x(),
+                                      static_cast<T>(1.0) / r.direction().y(),
+                                      static_cast<T>(1.0) / r.direction().z());
+
+        std::array<std::uint32_t, s_stackSize> stack;
+        std::size_t stackSize = 0;
+        std::uint32_t current = 0;
+
+        while (true)
+        {
+            if (numNodesVisited != nullptr)
+            {
+                ++*numNodesVisited;
+            }
+
+            const auto &node = m_nodeView[current];
+            if (node.bounds.hit(origin, invDirection, rayT))
+            {
+                if (node.count == 0)
+                {
+                    stack[stackSize++] = node.offset;
+                    current = current + 1;
+                    continue;
+                }
+
+                for (std::uint32_t i = 0; i < node.count; ++i)
+                {
+                    if (occludes(m_indexView[node.offset + i], rayT))
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            if (stackSize == 0)
+            {
+                break;
+            }
+            current = stack[--stackSize];
+        }
+
+        return false;
+    }
+
+private:
+    static constexpr std::size_t s_stackSize = 64;
+
+    std::vector<BVHNode<T>> m_nodes{};
+    std::vector<std::uint32_t> m_primitiveIndices{};
+    std::shared_ptr<const void> m_storage{}; // Owner of the viewed arrays when they are not ours
+    std::span<const BVHNode<T>> m_nodeView{};
+    std::span<const std::uint32_t> m_indexView{};
+
+    void adoptViews(const BVHTree &other)
+    {
+        m_nodeView = m_storage ? other.m_nodeView : std::span<const BVHNode<T>>(m_nodes);
+        m_indexView = m_storage ? other.m_indexView : std::span<const std::uint32_t>(m_primitiveIndices);
+    }
+
+    // Binned surface area heuristic: centroids are sorted into a few equal-width bins per axis
+    // and the bin boundary minimising the expected traversal cost becomes the split plane
+    static constexpr std::size_t s_numBins = 16;
+
+    // Deepest node a build may create, so that traversal never pushes more than s_stackSize
+    // entries. SAH splits can peel off one primitive per level; a node stops using them once
+    // median splits from it would only just reach this depth, so its subtree always fits. Morton
+    // splits use up one of the code bits per level and stay within it on their own.
+    static constexpr std::size_t s_maxDepth = s_stackSize - 1;
+
+    // Levels of median splits below a node of count primitives until every leaf holds at most
+    // s_maxLeafSize
+    static std::size_t medianSplitLevels(std::uint32_t count)
+    {
+        return (count <= s_maxLeafSize) ? 0 : static_cast<std::size_t>(std::bit_width((count - 1) / s_maxLeafSize));
+    }
+
+    // True while a SAH split at this depth cannot push the subtree past s_maxDepth
+    static bool allowsSAHSplit(std::size_t depth, std::uint32_t count)
+    {
+        return depth + medianSplitLevels(count) < s_maxDepth;
+    }
+
+    // Ranges this large are split with all threads; smaller ones become single-threaded subtrees.
+    // Parallel steps hand out primitives s_chunkSize at a time.
+    static constexpr std::uint32_t s_parallelSplitSize = 1u << 15;
+    static constexpr std::uint32_t s_chunkSize = 1u << 14;
+
+    // Morton codes quantize centroids to a grid of 2^10 cells per axis
+    static constexpr std::uint32_t s_mortonBitsPerAxis = 10;
+
+    struct SplitCandidate
+    {
+        int axis{-1};
+        std::size_t bin{0};
+        T cost{infinity<T>};
+    };
+
+    struct Bins
+    {
+        std::array<std::array<AABB<T>, s_numBins>, 3> bounds{};
+        std::array<std::array<std::uint32_t, s_numBins>, 3> counts{};
+
+        void merge(const Bins &other)
+        {
+            for (std::size_t axis = 0; axis < 3; ++axis)
+            {
+                for (std::size_t bin = 0; bin < s_numBins; ++bin)
+                {
+                    bounds[axis][bin] = AABB<T>(bounds[axis][bin], other.bounds[axis][bin]);
+                    counts[axis][bin] += other.counts[axis][bin];
+                }
+            }
+        }
+    };
+
+    struct BuildContext
+    {
+        const std::vector<AABB<T>> &primitiveBounds;
+        std::vector<Point3<T>> centroids;
+        std::vector<std::uint32_t> mortonCodes; // Morton builds: code of the primitive in each slot
+        std::vector<std::uint32_t> scratch;     // Parallel partitions scatter here
+        Builder builder;
+        ThreadPool *threadPool;
+    };
+
+    // A node of the top of the tree or, if subtree is set, one of the subtrees below it
+    struct BuildRef
+    {
+        std::uint32_t index{0};
+        bool subtree{false};
+    };
+
+    struct TopNode
+    {
+        BuildRef first{};
+        BuildRef second{};
+        std::uint16_t axis{0};
+        std::uint32_t base{0}; // Final index of the node
+        std::uint32_t secondBase{0};
+    };
+
+    struct Subtree
+    {
+        std::uint32_t begin{0};
+        std::uint32_t end{0};
+        std::size_t depth{0};
+        std::vector<BVHNode<T>> nodes{}; // Interior offsets relative to the subtree root
+        std::uint32_t base{0};           // Final index of the subtree root
+    };
+
+    static void forEach(ThreadPool *threadPool, std::size_t count, const std::function<void(std::size_t)> &body)
+    {
+        if (threadPool == nullptr || threadPool->numThreads() == 1 || count < 2)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                body(i);
+            }
+            return;
+        }
+        threadPool->parallelFor(count, body);
+    }
+
+    // Calls body(chunk, chunkBegin, chunkEnd) for the chunks of s_chunkSize slots of [begin, end)
+    static std::size_t forEachChunk(
+        const BuildContext &context, std::uint32_t begin, std::uint32_t end,
+        const std::function<void(std::size_t, std::uint32_t, std::uint32_t)> &body)
+    {
+        const std::size_t numChunks = (end - begin + s_chunkSize - 1) / s_chunkSize;
+        forEach(context.threadPool, numChunks, [&](std::size_t chunk)
+                {
+                    const auto chunkBegin = static_cast<std::uint32_t>(begin + chunk * s_chunkSize);
+                    body(chunk, chunkBegin, std::min(end, chunkBegin + s_chunkSize));
+                });
+        return numChunks;
+    }
+
+    // Splits ranges with all threads down to s_parallelSplitSize and queues the rest as subtrees
+    BuildRef splitTop(BuildContext &context, std::uint32_t begin, std::uint32_t end, std::size_t depth,
+                      std::vector<TopNode> &top, std::vector<Subtree> &subtrees)
+    {
+        if (end - begin < s_parallelSplitSize)
+        {
+            subtrees.push_back(Subtree{begin, end, depth, {}, 0});
+            return BuildRef{static_cast<std::uint32_t>(subtrees.size() - 1), true};
+        }
+
+        int axis = 0;
+        std::uint32_t mid = begin;
+        if (context.builder == Builder::Morton)
+        {
+            mortonSplit(context, begin, end, mid, axis);
+        }
+        else
+        {
+            std::vector<AABB<T>> chunkBounds((end - begin + s_chunkSize - 1) / s_chunkSize);
+            forEachChunk(context, begin, end, [&](std::size_t chunk, std::uint32_t chunkBegin, std::uint32_t chunkEnd)
+                         { chunkBounds[chunk] = centroidBounds(context, chunkBegin, chunkEnd); });
+            AABB<T> bounds;
+            for (const auto &box : chunkBounds)
+            {
+                bounds = AABB<T>(bounds, box);
+            }
+
+            std::vector<Bins> chunkBins(chunkBounds.size());
+            forEachChunk(context, begin, end, [&](std::size_t chunk, std::uint32_t chunkBegin, std::uint32_t chunkEnd)
+                         { fillBins(context, bounds, chunkBegin, chunkEnd, chunkBins[chunk]); });
+            Bins bins;
+            for (const auto &chunk : chunkBins)
+            {
+                bins.merge(chunk);
+            }
+
+            const auto split = allowsSAHSplit(depth, end - begin) ? findSAHSplit(bins, bounds, end - begin) : SplitCandidate{};
+            if (split.axis >= 0)
+            {
+                axis = split.axis;
+                const T axisMin = bounds.axisInterval(axis).min();
+                const T scale = static_cast<T>(s_numBins) / bounds.axisInterval(axis).size();
+                mid = parallelPartition(context, begin, end, [&](std::uint32_t primitive)
+                                        { return binIndex(context.centroids[primitive][axis], axisMin, scale) <= split.bin; });
+            }
+            if (mid == begin || mid == end)
+            {
+                medianSplit(context, bounds, begin, end, mid, axis);
+            }
+        }
+
+        const auto index = static_cast<std::uint32_t>(top.size());
+        top.emplace_back();
+        const auto first = splitTop(context, begin, mid, depth + 1, top, subtrees);
+        const auto second = splitTop(context, mid, end, depth + 1, top, subtrees);
+        top[index].first = first;
+        top[index].second = second;
+        top[index].axis = static_cast<std::uint16_t>(axis);
+        return BuildRef{index, false};
+    }
+
+    // Stable partition of [begin, end) with all threads: each chunk counts its primitives that
+    // go left, then scatters them to their final slots in the scratch array. Returns the middle.
+    template <typename GoesLeft>
+    std::uint32_t parallelPartition(BuildContext &context, std::uint32_t begin, std::uint32_t end, GoesLeft &&goesLeft)
+    {
+        context.scratch.resize(m_primitiveIndices.size());
+
+        std::vector<std::uint32_t> numLeft((end - begin + s_chunkSize - 1) / s_chunkSize);
+        forEachChunk(context, begin, end, [&](std::size_t chunk, std::uint32_t chunkBegin, std::uint32_t chunkEnd)
+                     {
+                         numLeft[chunk] = static_cast<std::uint32_t>(std::count_if(
+                             m_primitiveIndices.begin() + chunkBegin, m_primitiveIndices.begin() + chunkEnd, goesLeft));
+                     });
+        const std::uint32_t totalLeft = std::accumulate(numLeft.begin(), numLeft.end(), 0u);
+
+        forEachChunk(context, begin, end, [&](std::size_t chunk, std::uint32_t chunkBegin, std::uint32_t chunkEnd)
+                     {
+                         // Everything left of this chunk's primitives comes from earlier chunks
+                         const auto leftBefore = std::accumulate(numLeft.begin(), numLeft.begin() + static_cast<std::ptrdiff_t>(chunk), 0u);
+                         auto left = begin + leftBefore;
+                         auto right = begin + totalLeft + (chunkBegin - begin - leftBefore);
+                         for (std::uint32_t i = chunkBegin; i < chunkEnd; ++i)
+                         {
+                             const auto primitive = m_primitiveIndices[i];
+                             context.scratch[goesLeft(primitive) ? left++ : right++] = primitive;
+                         }
+                     });
+        forEachChunk(context, begin, end, [&](std::size_t, std::uint32_t chunkBegin, std::uint32_t chunkEnd)
+                     {
+                         std::copy(context.scratch.begin() + chunkBegin, context.scratch.begin() + chunkEnd,
+                                   m_primitiveIndices.begin() + chunkBegin);
+                     });
+        return begin + totalLeft;
+    }
+
+    // Builds the subtree over [begin, end) into nodes, with interior offsets relative to the
+    // first node added. Subtrees touch disjoint slots, so several can be built at once.
+    std::uint32_t buildRecursive(BuildContext &context, std::vector<BVHNode<T>> &nodes,
+                                 std::uint32_t begin, std::uint32_t end, std::size_t depth)
+    {
+        const auto nodeIndex = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+
+        const std::uint32_t count = end - begin;
+        if (count <= s_maxLeafSize)
+        {
+            AABB<T> bounds;
+            for (std::uint32_t i = begin; i < end; ++i)
+            {
+                bounds = AABB<T>(bounds, context.primitiveBounds[m_primitiveIndices[i]]);
+            }
+            nodes[nodeIndex] = BVHNode<T>{bounds, begin, static_cast<std::uint16_t>(count), 0};
+            return nodeIndex;
+        }
+
+        int axis = 0;
+        std::uint32_t mid = begin;
+        if (context.builder == Builder::Morton)
+        {
+            mortonSplit(context, begin, end, mid, axis);
+        }
+        else
+        {
+            const auto bounds = centroidBounds(context, begin, end);
+            SplitCandidate split;
+            if (allowsSAHSplit(depth, count))
+            {
+                Bins bins;
+                fillBins(context, bounds, begin, end, bins);
+                split = findSAHSplit(bins, bounds, count);
+            }
+
+            if (split.axis >= 0)
+            {
+                axis = split.axis;
+                const T axisMin = bounds.axisInterval(axis).min();
+                const T scale = static_cast<T>(s_numBins) / bounds.axisInterval(axis).size();
+                const auto middle = std::partition(
+                    m_primitiveIndices.begin() + begin,
+                    m_primitiveIndices.begin() + end,
+                    [&](std::uint32_t primitive)
+                    {
+                        return binIndex(context.centroids[primitive][axis], axisMin, scale) <= split.bin;
+                    });
+                mid = static_cast<std::uint32_t>(middle - m_primitiveIndices.begin());
+            }
+            if (mid == begin || mid == end)
+            {
+                medianSplit(context, bounds, begin, end, mid, axis);
+            }
+        }
+
+        buildRecursive(context, nodes, begin, mid, depth + 1);
+        const auto secondChild = buildRecursive(context, nodes, mid, end, depth + 1);
+
+        const auto bounds = AABB<T>(nodes[nodeIndex + 1].bounds, nodes[secondChild].bounds);
+        nodes[nodeIndex] = BVHNode<T>{bounds, secondChild, 0, static_cast<std::uint16_t>(axis)};
+        return nodeIndex;
+    }
+
+    // Gives every top node and subtree its final index, depth-first from ref
+    static std::uint32_t place(const BuildRef &ref, std::vector<TopNode> &top, std::vector<Subtree> &subtrees,
+                               std::uint32_t &numNodes)
+    {
+        if (ref.subtree)
+        {
+            auto &subtree = subtrees[ref.index];
+            subtree.base = numNodes;
+            numNodes += static_cast<std::uint32_t>(subtree.nodes.size());
+            return subtree.base;
+        }
+
+        auto &node = top[ref.index];
+        node.base = numNodes++;
+        place(node.first, top, subtrees, numNodes);
+        node.secondBase = place(node.second, top, subtrees, numNodes);
+        return node.base;
+    }
+
+    AABB<T> centroidBounds(const BuildContext &context, std::uint32_t begin, std::uint32_t end) const
+    {
+        AABB<T> bounds;
+        for (std::uint32_t i = begin; i < end; ++i)
+        {
+            const auto &centroid = context.centroids[m_primitiveIndices[i]];
+            bounds = AABB<T>(bounds, AABB<T>(centroid, centroid));
+        }
+        return bounds;
+    }
+
+    static std::size_t binIndex(T centroid, T axisMin, T scale)
+    {
+        const auto bin = static_cast<std::size_t>((centroid - axisMin) * scale);
+        return bin < s_numBins ? bin : s_numBins - 1;
+    }
+
+    // Adds the primitives in [begin, end) to the bins of every axis along which the centroids
+    // of the node spread
+    void fillBins(const BuildContext &context, const AABB<T> &centroidBounds, std::uint32_t begin, std::uint32_t end,
+                  Bins &bins) const
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const auto &extent = centroidBounds.axisInterval(axis);
+            if (extent.size() <= 0)
+            {
+                continue;
+            }
+
+            auto &binBounds = bins.bounds[static_cast<std::size_t>(axis)];
+            auto &binCounts = bins.counts[static_cast<std::size_t>(axis)];
+            const T scale = static_cast<T>(s_numBins) / extent.size();
+            for (std::uint32_t i = begin; i < end; ++i)
+            {
+                const auto primitive = m_primitiveIndices[i];
+                const auto bin = binIndex(context.centroids[primitive][axis], extent.min(), scale);
+                binBounds[bin] = AABB<T>(binBounds[bin], context.primitiveBounds[primitive]);
+                ++binCounts[bin];
+            }
+        }
+    }
+
+    static SplitCandidate findSAHSplit(const Bins &bins, const AABB<T> &centroidBounds, std::uint32_t count)
+    {
+        SplitCandidate best;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (centroidBounds.axisInterval(axis).size() <= 0)
+            {
+                continue;
+            }
+
+            const auto &binBounds = bins.bounds[static_cast<std::size_t>(axis)];
+            const auto &binCounts = bins.counts[static_cast<std::size_t>(axis)];
+
+            // Sweep from the right to get the area and count of everything right of each plane
+            std::array<T, s_numBins> rightCost{};
+            AABB<T> rightBounds;
+            std::uint32_t rightCount = 0;
+            for (std::size_t bin = s_numBins - 1; bin > 0; --bin)
+            {
+                rightBounds = AABB<T>(rightBounds, binBounds[bin]);
+                rightCount += binCounts[bin];
+                rightCost[bin - 1] = static_cast<T>(rightCount) * rightBounds.surfaceArea();
+            }
+
+            AABB<T> leftBounds;
+            std::uint32_t leftCount = 0;
+            for (std::size_t bin = 0; bin + 1 < s_numBins; ++bin)
+            {
+                leftBounds = AABB<T>(leftBounds, binBounds[bin]);
+                leftCount += binCounts[bin];
+                const T cost = static_cast<T>(leftCount) * leftBounds.surfaceArea() + rightCost[bin];
+                if (leftCount > 0 && leftCount < count && cost < best.cost)
+                {
+                    best = SplitCandidate{axis, bin, cost};
+                }
+            }
+        }
+
+        return best;
+    }
+
+    // Object median split along the axis with the widest spread of centroids. Used when all
+    // centroids coincide or the depth budget is used up, as it keeps the tree balanced.
+    void medianSplit(const BuildContext &context, const AABB<T> &centroidBounds, std::uint32_t begin,
+                     std::uint32_t end, std::uint32_t &mid, int &axis)
+    {
+        axis = centroidBounds.longestAxis();
+        mid = begin + (end - begin) / 2;
+        const auto &centroids = context.centroids;
+        std::nth_element(m_primitiveIndices.begin() + begin,
+                         m_primitiveIndices.begin() + mid,
+                         m_primitiveIndices.begin() + end,
+                         [&centroids, axis](std::uint32_t a, std::uint32_t b)
+                         {
+                             return centroids[a][axis] < centroids[b][axis];
+                         });
+    }
+
+    // Splits a range sorted by Morton code where its codes first differ, which is a plane of the
+    // grid along the axis of that bit. A range of equal codes is halved.
+    static void mortonSplit(const BuildContext &context, std::uint32_t begin, std::uint32_t end,
+                            std::uint32_t &mid, int &axis)
+    {
+        const auto &codes = context.mortonCodes;
+        const std::uint32_t differing = codes[begin] ^ codes[end - 1];
+        if (differing == 0)
+        {
+            axis = 0;
+            mid = begin + (end - begin) / 2;
+            return;
+        }
+
+        const int bit = static_cast<int>(std::bit_width(differing)) - 1;
+        axis = bit % 3;
+        const auto middle = std::partition_point(codes.begin() + begin, codes.begin() + end, [bit](std::uint32_t code)
+                                                 { return ((code >> bit) & 1u) == 0; });
+        mid = static_cast<std::uint32_t>(middle - codes.begin());
+    }
+
+    // Orders the primitive indices by the Morton code of their centroid within the centroid
+    // bounds, with a stable radix sort of s_mortonBitsPerAxis bits per pass, and keeps the code
+    // of each slot
+    void sortByMortonCode(BuildContext &context)
+    {
+        const auto count = static_cast<std::uint32_t>(m_primitiveIndices.size());
+
+        std::vector<AABB<T>> chunkBounds((count + s_chunkSize - 1) / s_chunkSize);
+        forEachChunk(context, 0, count, [&](std::size_t chunk, std::uint32_t chunkBegin, std::uint32_t chunkEnd)
+                     { chunkBounds[chunk] = centroidBounds(context, chunkBegin, chunkEnd); });
+        AABB<T> bounds;
+        for (const auto &box : chunkBounds)
+        {
+            bounds = AABB<T>(bounds, box);
+        }
+
+        constexpr std::uint32_t gridSize = 1u << s_mortonBitsPerAxis;
+        std::array<T, 3> scale{};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const T size = bounds.axisInterval(axis).size();
+            scale[static_cast<std::size_t>(axis)] = (size > 0) ? static_cast<T>(gridSize) / size : 0;
+        }
+        const auto cell = [&](const Point3<T> &centroid, int axis)
+        {
+            const T offset = (centroid[axis] - bounds.axisInterval(axis).min()) * scale[static_cast<std::size_t>(axis)];
+            return std::min(static_cast<std::uint32_t>(std::max(offset, T(0))), gridSize - 1);
+        };
+
+        std::vector<std::uint32_t> codes(count);
+        forEachChunk(context, 0, count, [&](std::size_t, std::uint32_t chunkBegin, std::uint32_t chunkEnd)
+                     {
+                         for (std::uint32_t i = chunkBegin; i < chunkEnd; ++i)
+                         {
+                             const auto &centroid = context.centroids[i];
+                             codes[i] = SpaceFillingCurve::mortonEncode(cell(centroid, 0), cell(centroid, 1), cell(centroid, 2));
+                         }
+                     });
+
+        std::vector<std::uint32_t> sorted(count);
+        for (std::uint32_t shift = 0; shift < 3 * s_mortonBitsPerAxis; shift += s_mortonBitsPerAxis)
+        {
+            std::array<std::uint32_t, gridSize + 1> start{};
+            for (const auto primitive : m_primitiveIndices)
+            {
+                ++start[((codes[primitive] >> shift) & (gridSize - 1)) + 1];
+            }
+            std::partial_sum(start.begin(), start.end(), start.begin());
+            for (const auto primitive : m_primitiveIndices)
+            {
+                sorted[start[(codes[primitive] >> shift) & (gridSize - 1)]++] = primitive;
+            }
+            m_primitiveIndices.swap(sorted);
+        }
+
+        context.mortonCodes.resize(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            context.mortonCodes[i] = codes[m_primitiveIndices[i]];
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_BVH_TREE_HPP */
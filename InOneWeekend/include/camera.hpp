@@ -8,14 +8,40 @@
 #ifndef INONEWEEKEND_INCLUDE_CAMERA_HPP
 #define INONEWEEKEND_INCLUDE_CAMERA_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iomanip>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include "aabb.hpp"
 #include "hittable.hpp"
 #include "color.hpp"
+#include "framebuffer_file.hpp"
+#include "image_writer.hpp"
+#include "irradiance_cache.hpp"
+#include "light_list.hpp"
+#include "material.hpp"
+#include "onb.hpp"
+#include "path_guide.hpp"
 #include "ray.hpp"
+#include "sampling.hpp"
+#include "space_filling_curve.hpp"
+#include "thread_pool.hpp"
+#include "tone_mapper.hpp"
 
 template <std::floating_point T = double>
 class Camera
@@ -41,6 +67,22 @@ public:
         return Util::radiansToDegrees<T>(m_defocusAngle);
     }
     constexpr T focusDist() const { return m_focusDist; }
+    constexpr int tileSize() const { return m_tileSize; }
+    constexpr SpaceFillingCurve::Order tileOrder() const { return m_tileOrder; }
+    constexpr SpaceFillingCurve::Order pixelOrder() const { return m_pixelOrder; }
+    constexpr int numThreads() const { return m_numThreads; }
+    constexpr std::uint64_t seed() const { return m_seed; }
+    constexpr const std::optional<Color<T>> &background() const { return m_background; }
+    constexpr const ToneMapper &toneMapper() const { return m_toneMapper; }
+    constexpr bool specializedKernels() const { return m_specializedKernels; }
+    constexpr bool rayReordering() const { return m_rayReordering; }
+    constexpr bool incremental() const { return m_incremental; }
+    constexpr std::size_t numTilesRendered() const { return m_numTilesRendered; }
+    constexpr const std::optional<typename IrradianceCache<T>::Settings> &irradianceCacheSettings() const { return m_irradianceCacheSettings; }
+    const std::shared_ptr<const IrradianceCache<T>> &irradianceCache() const { return m_irradianceCache; } // Of the last render
+    constexpr const std::optional<typename PathGuide<T>::Settings> &pathGuiding() const { return m_pathGuiding; }
+    const std::shared_ptr<const PathGuide<T>> &pathGuide() const { return m_pathGuide; } // Of the last render
+    const std::shared_ptr<ThreadPool> &threadPool() const { return m_threadPool; }
 
     void setAspectRatio(T aspectRatio)
     {
@@ -63,8 +105,7 @@ public:
         // before being terminated
         // Default is 10
         // Higher values increase realism but also increase render time
-        // Very high values can lead to stack overflow due to deep recursion
-        // in rayColor()
+        // Negative for no limit, paths then end by Russian roulette
         m_maxReflection = maxReflection;
     }
 
@@ -108,68 +149,397 @@ public:
         m_focusDist = focusDist;
     }
 
+    void setTileSize(int tileSize)
+    {
+        // Edge length in pixels of the square tiles the image is rendered in
+        m_tileSize = tileSize;
+    }
+
+    void setTileOrder(SpaceFillingCurve::Order tileOrder)
+    {
+        // Order in which tiles are handed out to the render threads
+        m_tileOrder = tileOrder;
+    }
+
+    void setPixelOrder(SpaceFillingCurve::Order pixelOrder)
+    {
+        // Order in which the pixels of a tile are traced
+        m_pixelOrder = pixelOrder;
+    }
+
+    void setNumThreads(int numThreads)
+    {
+        // Number of threads rendering tiles, 0 uses one per hardware thread
+        // The image does not depend on it
+        m_numThreads = numThreads;
+    }
+
+    void setThreadPool(std::shared_ptr<ThreadPool> threadPool)
+    {
+        // Render with the pool's threads instead of starting numThreads for every render
+        m_threadPool = std::move(threadPool);
+    }
+
+    void setSeed(std::uint64_t seed)
+    {
+        // Renders with the same seed and settings are identical
+        m_seed = seed;
+    }
+
+    void setBackground(const Color<T> &background)
+    {
+        // Constant radiance for rays escaping the scene, replacing the default sky gradient
+        // Use black for interior scenes lit only by emissive objects
+        m_background = background;
+    }
+
+    void setToneMapper(const ToneMapper &toneMapper)
+    {
+        // Exposure, tone curve and dithering applied when images are written
+        m_toneMapper = toneMapper;
+    }
+
+    void setSpecializedKernels(bool specializedKernels)
+    {
+        // Trace with a kernel compiled for the settings of the render (default), or with the
+        // generic one that tests them for every sample; the images are identical
+        m_specializedKernels = specializedKernels;
+    }
+
+    void setRayReordering(bool rayReordering)
+    {
+        // Trace the paths of a tile bounce by bounce, sorted by ray origin and direction before
+        // each bounce after the first; the images are identical
+        // Whether it pays off depends on the scene and the caches, see the benchmark's --reorder
+        m_rayReordering = rayReordering;
+    }
+
+    void setIrradianceCache(std::optional<typename IrradianceCache<T>::Settings> settings)
+    {
+        // Take the indirect light of the first diffuse surface along each path from an
+        // irradiance cache instead of tracing on (see IrradianceCache). The cache is filled by
+        // a prepass over the image before every render. Much less noise for the time, at the
+        // cost of some bias; pass nothing for plain path tracing
+        m_irradianceCacheSettings = settings;
+        m_frame.reset();
+    }
+
+    void setPathGuiding(std::optional<typename PathGuide<T>::Settings> settings)
+    {
+        // Sample scattering directions in part from the incident light learned by training
+        // passes before every render (see PathGuide), instead of from the BSDF alone. Pays off
+        // where light arrives through small openings that BSDF samples rarely find; pass
+        // nothing for plain BSDF sampling
+        m_pathGuiding = settings;
+        m_frame.reset();
+    }
+
+    void setIncremental(bool incremental)
+    {
+        // Keep the last frame and what the first two segments of each tile's paths hit, so
+        // that after scene edits the next render of the same view only traces the tiles the
+        // edits touch (see invalidate and SceneEditor); the other tiles are copied
+        m_incremental = incremental;
+        m_frame.reset();
+    }
+
+    // Marks the tiles of the kept frame whose camera or first-bounce rays hit object, or
+    // sampled it as a light there, e.g. after its material changed
+    void invalidate(const Hittable<T> *object)
+    {
+        if (!m_frame)
+        {
+            return;
+        }
+
+        for (std::size_t tile = 0; tile < m_frame->footprints.size(); ++tile)
+        {
+            const auto &footprint = m_frame->footprints[tile];
+            if (std::binary_search(footprint.begin(), footprint.end(), object))
+            {
+                m_frame->invalid[tile] = true;
+            }
+        }
+    }
+
+    // As above, and also the tiles in which camera rays can reach region. An object that moved
+    // is passed with its bounds before and after, which covers where it newly shows up.
+    // Where it newly appears in reflections or casts new shadows is not tracked; invalidateAll
+    // brings those in.
+    void invalidate(const Hittable<T> *object, const AABB<T> &region)
+    {
+        invalidate(object);
+        if (!m_frame)
+        {
+            return;
+        }
+
+        const auto &frame = m_frame->settings;
+        const auto pixels = imageFootprint(region);
+        if (!pixels)
+        {
+            return;
+        }
+
+        const int tilesX = (frame.imageWidth + frame.tileSize - 1) / frame.tileSize;
+        for (int tileY = (*pixels)[1] / frame.tileSize; tileY <= (*pixels)[3] / frame.tileSize; ++tileY)
+        {
+            for (int tileX = (*pixels)[0] / frame.tileSize; tileX <= (*pixels)[2] / frame.tileSize; ++tileX)
+            {
+                m_frame->invalid[static_cast<std::size_t>(tileY * tilesX + tileX)] = true;
+            }
+        }
+    }
+
+    void invalidateAll()
+    {
+        m_frame.reset();
+    }
+
     void render(const Hittable<T> &world)
     {
-        // Always initialize before rendering
-        initialize();
+        render(world, LightList<T>());
+    }
+
+    void render(const Hittable<T> &world, const LightList<T> &lights)
+    {
+        // Writes a plain PPM to standard output once the image is done, converted on the render
+        // threads if they persist
+        auto pixels = renderImage(world, lights);
+        ImageWriter<T>::write(typename ImageWriter<T>::Frame{{}, m_imageWidth, m_imageHeight, std::move(pixels), ImageWriter<T>::Format::PlainPPM, m_toneMapper},
+                              m_threadPool.get());
+    }
+
+    void render(
+        const Hittable<T> &world,
+        const LightList<T> &lights,
+        ImageWriter<T> &writer,
+        const std::string &path,
+        typename ImageWriter<T>::Format format = ImageWriter<T>::Format::PlainPPM)
+    {
+        // Hands the image to the writer's output thread and returns, so that the next frame
+        // renders while this one is encoded
+        auto pixels = renderImage(world, lights);
+        writer.submit(typename ImageWriter<T>::Frame{path, m_imageWidth, m_imageHeight, std::move(pixels), format, m_toneMapper});
+    }
+
+    // Renders into a linear framebuffer in row-major order, without writing the image
+    std::vector<Color<T>> renderImage(const Hittable<T> &world, const LightList<T> &lights)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        std::clog << "Rendering..." << std::flush;
 
-        std::cout << "P3\n"
-                  << m_imageWidth << ' ' << m_imageHeight << "\n255\n";
+        auto pass = beginPass(world, lights);
+        runTiles(m_threadPool.get(), m_numThreads, pass.tiles.size(), [&](std::size_t tile)
+                 { (this->*pass.kernel)(pass, tile); }, startTime);
+        auto framebuffer = endPass(std::move(pass));
+
+        logDone(startTime);
+        return framebuffer;
+    }
 
+    // Renders several views of one scene as one batch, e.g. the frames of a turntable. The tiles
+    // of all views go to the threads of threadPool from a single queue, view after view, so a
+    // thread that runs out of tiles of one view moves on to the next instead of waiting for the
+    // slowest tile. Returns the framebuffers in the order of the cameras, each exactly as the
+    // camera's renderImage would.
+    static std::vector<std::vector<Color<T>>> renderViews(
+        std::span<Camera> cameras,
+        const Hittable<T> &world,
+        const LightList<T> &lights,
+        ThreadPool &threadPool)
+    {
         const auto startTime = std::chrono::steady_clock::now();
+        std::clog << "Rendering " << cameras.size() << " views..." << std::flush;
+
+        std::vector<RenderPass> passes;
+        passes.reserve(cameras.size());
+        std::vector<std::size_t> firstTiles; // Index of the first tile of each view in the batch
+        firstTiles.reserve(cameras.size());
+        std::size_t numTiles = 0;
+        for (auto &camera : cameras)
+        {
+            passes.push_back(camera.beginPass(world, lights));
+            firstTiles.push_back(numTiles);
+            numTiles += passes.back().tiles.size();
+        }
+
+        runTiles(&threadPool, 0, numTiles, [&](std::size_t tile)
+                 {
+                     const auto view = static_cast<std::size_t>(std::upper_bound(firstTiles.begin(), firstTiles.end(), tile) - firstTiles.begin()) - 1;
+                     auto &pass = passes[view];
+                     (cameras[view].*pass.kernel)(pass, tile - firstTiles[view]);
+                 }, startTime);
+
+        std::vector<std::vector<Color<T>>> framebuffers;
+        framebuffers.reserve(cameras.size());
+        for (std::size_t view = 0; view < cameras.size(); ++view)
+        {
+            framebuffers.push_back(cameras[view].endPass(std::move(passes[view])));
+        }
 
+        logDone(startTime);
+        return framebuffers;
+    }
+
+    // Renders an image too large for memory straight into an image file, one band of rows at a
+    // time: the tiles of a band are traced into a framebuffer of the band, its rows written to
+    // the file, and the framebuffer reused for the next band. Memory grows with bandHeight,
+    // rounded up to whole tiles, instead of with the image. The pixels are those of renderImage;
+    // incremental rendering does not apply. An irradiance cache or path guide would be made
+    // over the whole image before the first band, with memory that grows with the image again,
+    // so neither may be set.
+    void renderBands(
+        const Hittable<T> &world,
+        const LightList<T> &lights,
+        const std::string &path,
+        typename FramebufferFile<T>::Format format,
+        int bandHeight)
+    {
+        if (m_irradianceCacheSettings || m_pathGuiding)
+        {
+            throw std::invalid_argument("Camera::renderBands: irradiance caching and path guiding need the whole image");
+        }
+
+        const auto startTime = std::chrono::steady_clock::now();
         std::clog << "Rendering..." << std::flush;
 
-        for (int i = 0; i < m_imageHeight; ++i)
+        auto pass = beginPass(world, lights, true);
+        FramebufferFile<T> file(path, m_imageWidth, m_imageHeight, format, m_toneMapper);
+
+        const int tilesX = (m_imageWidth + m_tileSize - 1) / m_tileSize;
+        const int tilesY = (m_imageHeight + m_tileSize - 1) / m_tileSize;
+        const int bandTiles = std::max((bandHeight + m_tileSize - 1) / m_tileSize, 1);
+        const int numBands = (tilesY + bandTiles - 1) / bandTiles;
+        m_numTilesRendered = 0;
+        for (int band = 0; band < numBands; ++band)
         {
-            for (int j = 0; j < m_imageWidth; ++j)
+            // A band is a strip far wider than high. The curve is walked over square blocks of
+            // the band height, left to right, instead of over the enclosing square of the
+            // strip, which would visit mostly cells outside it and jump between distant tiles.
+            const int firstTileY = band * bandTiles;
+            const int numTilesY = std::min(bandTiles, tilesY - firstTileY);
+            pass.tiles.clear();
+            for (int firstTileX = 0; firstTileX < tilesX; firstTileX += numTilesY)
             {
-                Color<T> pixelColor(0.0, 0.0, 0.0);
-                for (int s = 0; s < m_numSamplesPerPixel; ++s)
+                const int numTilesX = std::min(numTilesY, tilesX - firstTileX);
+                for (auto cell : SpaceFillingCurve::traverse(static_cast<std::uint32_t>(numTilesX), static_cast<std::uint32_t>(numTilesY), m_tileOrder))
                 {
-                    const auto ray = getRay(i, j);
-                    pixelColor += rayColor(ray, world);
+                    cell[0] += static_cast<std::uint32_t>(firstTileX);
+                    cell[1] += static_cast<std::uint32_t>(firstTileY);
+                    pass.tiles.push_back(cell);
                 }
-                pixelColor *= m_pixelSampleScale;
-
-                writeColor(std::cout, pixelColor);
             }
 
-            // Log progress after each scanline
-            const int linesDone = i + 1;
-            const auto now = std::chrono::steady_clock::now();
-            const auto elapsed = std::chrono::duration<double>(now - startTime).count();
-            const double avgTimePerLine = elapsed / linesDone;
-            const int linesRemaining = m_imageHeight - linesDone;
-            const double etaSeconds = avgTimePerLine * linesRemaining;
+            pass.firstRow = firstTileY * m_tileSize;
+            const int numRows = std::min(numTilesY * m_tileSize, m_imageHeight - pass.firstRow);
+            pass.framebuffer.resize(static_cast<std::size_t>(numRows) * static_cast<std::size_t>(m_imageWidth));
 
-            const int etaH = static_cast<int>(etaSeconds) / 3600;
-            const int etaM = (static_cast<int>(etaSeconds) % 3600) / 60;
-            const int etaS = static_cast<int>(etaSeconds) % 60;
+            runTiles(m_threadPool.get(), m_numThreads, pass.tiles.size(), [&](std::size_t tile)
+                     { (this->*pass.kernel)(pass, tile); }, std::nullopt);
+            file.writeRows(pass.firstRow, pass.framebuffer);
+            m_numTilesRendered += pass.tiles.size();
 
-            std::clog << "\rRendering... Progress: " << linesDone << "/" << m_imageHeight
-                      << " | ETA: " << std::setfill('0')
-                      << std::setw(2) << etaH << ":"
-                      << std::setw(2) << etaM << ":"
-                      << std::setw(2) << etaS
-                      << "    " << std::flush;
+            std::clog << "\rRendering... Progress: " << (band + 1) << "/" << numBands << " bands" << std::flush;
         }
+        file.finish();
 
-        const auto endTime = std::chrono::steady_clock::now();
-        const auto totalSeconds = std::chrono::duration<double>(endTime - startTime).count();
-        const int totalH = static_cast<int>(totalSeconds) / 3600;
-        const int totalM = (static_cast<int>(totalSeconds) % 3600) / 60;
-        const int totalS = static_cast<int>(totalSeconds) % 60;
-
-        std::clog << "\rDone. Total time: "
-                  << std::setfill('0')
-                  << std::setw(2) << totalH << ":"
-                  << std::setw(2) << totalM << ":"
-                  << std::setw(2) << totalS
-                  << "                    \n";
+        logDone(startTime);
     }
 
 private:
+    // Settings that stay the same for every sample of a render. A kernel has each of them
+    // either fixed at compile time or read from the camera while tracing.
+    enum class Switch
+    {
+        Off,
+        On,
+        Runtime,
+    };
+
+    struct KernelConfig
+    {
+        Switch defocus;    // Camera rays start on the defocus disk
+        Switch depthLimit; // Paths end after m_maxReflection bounces, otherwise by Russian roulette
+        Switch lights;     // Next-event estimation towards the light list
+        Switch diffuse;    // Every material of the scene is diffuse: no emission, no specular bounces
+    };
+
+    // The generic kernel asks the materials at every hit; whether all of them are diffuse is
+    // only resolved for the whole scene when a kernel is selected
+    static constexpr KernelConfig s_genericKernel{Switch::Runtime, Switch::Runtime, Switch::Runtime, Switch::Runtime};
+
+    // Objects the camera and first-bounce rays of a tile hit or sampled as lights, sorted
+    using Footprint = std::vector<const Hittable<T> *>;
+
+    struct RenderPass;
+
+    // Traces one tile of a pass, compiled for one kernel configuration
+    using TileKernel = void (Camera::*)(RenderPass &, std::size_t) const;
+
+    // What a render shares with all of its threads
+    struct RenderPass
+    {
+        const Hittable<T> &world;
+        const LightList<T> &lights;
+        std::vector<Color<T>> framebuffer;               // Rows from firstRow on
+        int firstRow;                                    // Image row of the first framebuffer row
+        std::vector<std::array<std::uint32_t, 2>> tiles; // The tiles to trace
+        int tilesX;                                      // Tiles per image row
+        std::vector<Footprint> *footprints;              // Per tile, recorded if set
+        TileKernel kernel;
+    };
+
+    // What the pixels of a frame depend on besides the contents of the scene
+    struct FrameSettings
+    {
+        const Hittable<T> *world;
+        const LightList<T> *lights;
+        int imageWidth;
+        int imageHeight;
+        int numSamplesPerPixel;
+        int maxReflection;
+        int tileSize;
+        std::uint64_t seed;
+        std::optional<Color<T>> background;
+        Point3<T> center;
+        Point3<T> pixel00Center;
+        Vector3<T> pixelDeltaHorizontal;
+        Vector3<T> pixelDeltaVertical;
+        Vector3<T> w;
+        Vector3<T> defocusDiskU;
+        Vector3<T> defocusDiskV;
+
+        bool operator==(const FrameSettings &) const = default;
+    };
+
+    // Last frame of an incremental render and what it needs to be brought up to date
+    struct KeptFrame
+    {
+        FrameSettings settings;
+        std::vector<Color<T>> framebuffer;
+        std::vector<Footprint> footprints; // Per tile, row-major
+        std::vector<bool> invalid;         // Per tile, traced by the next render
+    };
+
+    // A camera sample's path between two bounces
+    struct PathState
+    {
+        Ray<T> ray{};
+        Color<T> throughput{1.0, 1.0, 1.0};
+        Color<T> radiance{0.0, 0.0, 0.0};
+        T previousPdf{0};
+        bool previousSpecular{true}; // Camera rays count as specular, their emission is unweighted
+        int depth{0};
+        T hitDistance{0};           // Ray parameter of the last hit, infinite if the ray escaped
+        Vector3<T> normal{};        // Surface normal at the last hit
+        T rayWidth{0};              // Width of the ray's footprint at the last hit, for texture filtering
+        T raySpread{0};             // Growth of that width per unit of distance after the last bounce
+        bool diffuseBounce{false};  // Scattered off a non-specular surface, the cache no longer applies
+        std::uint64_t key{0};    // Random stream of the sample
+        std::uint32_t sample{0}; // Index of the sample in its tile
+    };
+
     // Publically Accessible Camera Parameters
 
     T m_aspectRatio{1.0};         // Ratio of Image Width over Height
@@ -185,6 +555,22 @@ private:
     T m_defocusAngle{0.0}; // Variation angle of rays through each pixel
     T m_focusDist{0.0};    // Distance from camera lookFrom point to plane of perfect focus
 
+    std::optional<Color<T>> m_background{}; // Radiance of escaping rays, sky gradient if unset; an environment light replaces both
+    ToneMapper m_toneMapper{};              // Conversion to display values on output
+
+    int m_tileSize{16};      // Edge length of the square render tiles in px
+    int m_numThreads{0};     // Render threads, 0 for one per hardware thread
+    std::shared_ptr<ThreadPool> m_threadPool{}; // Persistent render threads, replace m_numThreads
+
+    SpaceFillingCurve::Order m_tileOrder{SpaceFillingCurve::Order::Hilbert};  // Tile schedule
+    SpaceFillingCurve::Order m_pixelOrder{SpaceFillingCurve::Order::Hilbert}; // Pixel order in a tile
+    std::uint64_t m_seed{0}; // Seed of all random decisions of a render
+    bool m_specializedKernels{true}; // Trace with a kernel compiled for the render's settings
+    bool m_rayReordering{false};     // Sort the rays of a tile before every bounce
+    bool m_incremental{false};       // Keep frames and re-render only tiles invalidated since
+    std::optional<typename IrradianceCache<T>::Settings> m_irradianceCacheSettings{}; // Cache diffuse indirect light if set
+    std::optional<typename PathGuide<T>::Settings> m_pathGuiding{};                   // Guide scattering if set
+
     // Internally Used Camera Parameters
 
     int m_imageHeight{100};              // Rendered Image Height
@@ -192,11 +578,42 @@ private:
     Point3<T> m_pixel00Center{};         // Center of Pixel 0, 0
     Vector3<T> m_pixelDeltaHorizontal{}; // Offset of pixel to the right
     Vector3<T> m_pixelDeltaVertical{};   // Offset of pixel below
+    T m_pixelSpread{0};                  // Angle a pixel subtends, the spread of camera rays
     T m_pixelSampleScale{0.1};           // Color scale factor for a sum of pixel samples
     Vector3<T> m_u{}, m_v{}, m_w{};      // Camera Frame basis vectors
     Vector3<T> m_defocusDiskU{};         // Defocus disk horizontal radius
     Vector3<T> m_defocusDiskV{};         // Defocus disk vertical radius
 
+    std::vector<std::array<std::uint32_t, 2>> m_tilePixels{}; // Pixel offsets of a tile in trace order
+    std::optional<KeptFrame> m_frame{};                       // Last frame of an incremental render
+    std::size_t m_numTilesRendered{0};                        // Tiles traced by the last render
+    std::shared_ptr<const IrradianceCache<T>> m_irradianceCache{}; // Filled for the current render
+    std::shared_ptr<const PathGuide<T>> m_pathGuide{};             // Trained for the current render
+
+    // Dimensions of each sample's random stream
+    static constexpr std::uint64_t s_pixelOffsetDimension = 0; // 2D offset within the pixel
+    static constexpr std::uint64_t s_lensDimension = 2;        // 2D point on the defocus disk
+    static constexpr std::uint64_t s_pathDimension = 4;        // First one used along the path
+    static constexpr std::uint64_t s_bounceDimensions = 1024;  // Reserved for each bounce
+
+    // Without a depth limit, paths continue with a probability that follows their throughput
+    // once they are this long, but never with certainty, so that every path ends
+    static constexpr int s_rouletteDepth = 3;
+    static constexpr T s_maxSurvival = static_cast<T>(0.95);
+
+    // Irradiance cache prepass: the coarsest pixel grid, the salt of its sample streams and how
+    // many specular surfaces it follows camera rays through
+    static constexpr int s_cachePrepassStride = 16;
+    static constexpr std::uint64_t s_cacheSeed = 0x1C0FFEE5EEDull;
+    static constexpr int s_maxCachePointDepth = 8;
+
+    // Spread of the footprint of rays leaving a rough bounce. Such a bounce blurs what it sees
+    // anyway, and reading coarse mip levels keeps its incoherent rays on few texture tiles.
+    static constexpr T s_roughSpread = static_cast<T>(0.1);
+
+    // Salt of the sample streams of the path guide's training passes
+    static constexpr std::uint64_t s_guideSeed = 0x6D1DE5EEDull;
+
     void initialize()
     {
         m_imageHeight = static_cast<int>(m_imageWidth / m_aspectRatio);
@@ -228,6 +645,7 @@ private:
                                      (viewportVertical / 2);
 
         m_pixel00Center = viewportTopLeft + 0.5 * (m_pixelDeltaHorizontal + m_pixelDeltaVertical);
+        m_pixelSpread = m_pixelDeltaHorizontal.length() / m_focusDist;
 
         // Calculate the camera defocus disk basis vectors
         const auto defocusRadius = m_focusDist * std::tan(m_defocusAngle / 2);
@@ -235,59 +653,1115 @@ private:
         m_defocusDiskV = m_v * defocusRadius;
     }
 
-    Ray<T> getRay(int i, int j) const
+    template <Switch S>
+    static constexpr bool enabled(bool runtimeValue)
     {
-        // Construct a camera ray originating from the origin (defocus disk) and directed at a
-        // randomly sampled point around the pixel (i, j).
+        if constexpr (S == Switch::Runtime)
+        {
+            return runtimeValue;
+        }
+        else
+        {
+            return S == Switch::On;
+        }
+    }
 
-        const auto offset = sampleSquare();
-        const auto pixelSample = m_pixel00Center +
-                                 ((i + offset.y()) * m_pixelDeltaVertical) +
-                                 ((j + offset.x()) * m_pixelDeltaHorizontal);
+    // Sets up a frame: its tiles, the framebuffer they are traced into and the kernel for the
+    // camera's settings. An incremental render of the same view starts from the kept frame and
+    // only traces the tiles invalidated since. A banded pass has neither tiles nor framebuffer
+    // yet; renderBands sets them up band by band.
+    RenderPass beginPass(const Hittable<T> &world, const LightList<T> &lights, bool banded = false)
+    {
+        // Always initialize before rendering
+        initialize();
 
-        const auto rayOrigin = (m_defocusAngle <= 0) ? m_center : sampleDefocusDisk();
-        const auto rayDirection = pixelSample - rayOrigin;
+        // The guide is trained first, so that the paths of the cache records are guided too
+        m_pathGuide.reset();
+        if (m_pathGuiding)
+        {
+            m_pathGuide = trainPathGuide(world, lights);
+        }
 
-        return Ray<T>(rayOrigin, rayDirection);
+        m_irradianceCache.reset();
+        if (m_irradianceCacheSettings)
+        {
+            m_irradianceCache = fillIrradianceCache(world, lights);
+        }
+
+        // The image is traced in square tiles, each of which draws its camera samples as one
+        // pre-generated block. Threads take the next tile from a shared counter.
+        const int tilesX = (m_imageWidth + m_tileSize - 1) / m_tileSize;
+        const int tilesY = (m_imageHeight + m_tileSize - 1) / m_tileSize;
+
+        // Along a space-filling curve consecutive tiles, and pixels within a tile, see mostly
+        // the same part of the scene
+        m_tilePixels = SpaceFillingCurve::traverse(static_cast<std::uint32_t>(m_tileSize), static_cast<std::uint32_t>(m_tileSize), m_pixelOrder);
+
+        // The settings are resolved once into a kernel compiled for them, together with the
+        // scalar type of the camera
+        const TileKernel kernel = m_specializedKernels ? selectKernel(world, lights) : &Camera::traceTile<s_genericKernel>;
+        if (banded)
+        {
+            return RenderPass{world, lights, {}, 0, {}, tilesX, nullptr, kernel};
+        }
+
+        std::vector<Color<T>> framebuffer(static_cast<std::size_t>(m_imageWidth) * static_cast<std::size_t>(m_imageHeight));
+        auto tiles = SpaceFillingCurve::traverse(static_cast<std::uint32_t>(tilesX), static_cast<std::uint32_t>(tilesY), m_tileOrder);
+
+        std::vector<Footprint> *footprints = nullptr;
+        if (m_incremental && (m_irradianceCache || m_pathGuide))
+        {
+            // The cache and the guide are made anew from the whole frame, which the tile
+            // footprints do not track, so every tile is traced again
+            m_frame.reset();
+        }
+        if (m_incremental)
+        {
+            const auto settings = frameSettings(world, lights);
+            if (!m_frame || !(m_frame->settings == settings))
+            {
+                const auto numTiles = static_cast<std::size_t>(tilesX) * static_cast<std::size_t>(tilesY);
+                m_frame = KeptFrame{settings, std::move(framebuffer), std::vector<Footprint>(numTiles), std::vector<bool>(numTiles, true)};
+            }
+
+            std::erase_if(tiles, [&](const auto &cell)
+                          { return !m_frame->invalid[static_cast<std::size_t>(cell[1]) * static_cast<std::size_t>(tilesX) + cell[0]]; });
+            m_frame->invalid.assign(m_frame->invalid.size(), false);
+            framebuffer = std::move(m_frame->framebuffer);
+            footprints = &m_frame->footprints;
+        }
+        m_numTilesRendered = tiles.size();
+        return RenderPass{world, lights, std::move(framebuffer), 0, std::move(tiles), tilesX, footprints, kernel};
     }
 
-    Vector3<T> sampleSquare() const
+    std::vector<Color<T>> endPass(RenderPass &&pass)
     {
-        // Returns the vector to a random point in the [-0.5, -0.5] x [+0.5, +0.5] square
-        return Vector3<T>(Util::random<T>() - 0.5, Util::random<T>() - 0.5, 0);
+        if (m_incremental)
+        {
+            m_frame->framebuffer = pass.framebuffer;
+        }
+        return std::move(pass.framebuffer);
     }
 
-    Point3<T> sampleDefocusDisk() const
+    // Resolves the settings of the render one at a time into template arguments, so that tracing
+    // runs in a kernel without branches on them
+    template <Switch Defocus = Switch::Runtime, Switch DepthLimit = Switch::Runtime, Switch Lights = Switch::Runtime, Switch Diffuse = Switch::Runtime>
+    TileKernel selectKernel(const Hittable<T> &world, const LightList<T> &lights) const
     {
-        const auto p = randomInUnitDisk<T>();
-        return m_center + (p.x() * m_defocusDiskU) + (p.y() * m_defocusDiskV);
+        if constexpr (Defocus == Switch::Runtime)
+        {
+            return (m_defocusAngle > 0) ? selectKernel<Switch::On, DepthLimit, Lights, Diffuse>(world, lights)
+                                        : selectKernel<Switch::Off, DepthLimit, Lights, Diffuse>(world, lights);
+        }
+        else if constexpr (DepthLimit == Switch::Runtime)
+        {
+            return (m_maxReflection >= 0) ? selectKernel<Defocus, Switch::On, Lights, Diffuse>(world, lights)
+                                          : selectKernel<Defocus, Switch::Off, Lights, Diffuse>(world, lights);
+        }
+        else if constexpr (Lights == Switch::Runtime)
+        {
+            return !lights.isEmpty() ? selectKernel<Defocus, DepthLimit, Switch::On, Diffuse>(world, lights)
+                                     : selectKernel<Defocus, DepthLimit, Switch::Off, Diffuse>(world, lights);
+        }
+        else if constexpr (Diffuse == Switch::Runtime)
+        {
+            // The material set of the scene, asked once per render rather than at every hit
+            return world.onlyDiffuse() ? selectKernel<Defocus, DepthLimit, Lights, Switch::On>(world, lights)
+                                       : selectKernel<Defocus, DepthLimit, Lights, Switch::Off>(world, lights);
+        }
+        else
+        {
+            return &Camera::traceTile<KernelConfig{Defocus, DepthLimit, Lights, Diffuse}>;
+        }
     }
 
-    Color<T> rayColor(const Ray<T> &r, const Hittable<T> &world, int reflectionCount = 0) const
+    // Calls traceTile(tile) for every tile on the render threads: those of threadPool if given,
+    // otherwise numThreads started for this call (0 for one per hardware thread). Threads take
+    // the next tile from a shared counter. Progress is logged if a start time is given.
+    static void runTiles(
+        ThreadPool *threadPool,
+        int numThreads,
+        std::size_t numTiles,
+        const std::function<void(std::size_t)> &traceTile,
+        std::optional<std::chrono::steady_clock::time_point> startTime)
     {
-        constexpr auto black = Color<T>(0.0, 0.0, 0.0);
-        if (reflectionCount > m_maxReflection)
+        std::atomic<std::size_t> nextTile{0};
+        std::atomic<std::size_t> tilesDone{0};
+
+        const auto work = [&](bool logProgress)
         {
-            return black;
+            for (std::size_t tile = nextTile++; tile < numTiles; tile = nextTile++)
+            {
+                traceTile(tile);
+                const std::size_t done = ++tilesDone;
+
+                // Only the calling thread logs progress
+                if (logProgress && startTime)
+                {
+                    logTileProgress(static_cast<int>(done), static_cast<int>(numTiles), *startTime);
+                }
+            }
+        };
+
+        if (threadPool != nullptr)
+        {
+            threadPool->run(work);
+            return;
         }
 
-        HitRecord<T> record;
+        numThreads = (numThreads > 0) ? numThreads
+                                      : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::jthread> workers;
+        workers.reserve(static_cast<std::size_t>(numThreads - 1));
+        for (int i = 1; i < numThreads; ++i)
+        {
+            workers.emplace_back(work, false);
+        }
+        work(true);
+    }
+
+    // Trains a path guide for the frame. Every training pass traces one path per pixel, guided
+    // by the passes before it, and adds the light each path brought back from every non-specular
+    // bounce to the guide. Tiles add their samples in any order; the guide's sums do not depend
+    // on it.
+    std::shared_ptr<const PathGuide<T>> trainPathGuide(const Hittable<T> &world, const LightList<T> &lights)
+    {
+        auto guide = std::make_shared<PathGuide<T>>(*m_pathGuiding, visibleBounds(world));
+        const int tilesX = (m_imageWidth + m_tileSize - 1) / m_tileSize;
+        const int tilesY = (m_imageHeight + m_tileSize - 1) / m_tileSize;
+        const auto numTiles = static_cast<std::size_t>(tilesX) * static_cast<std::size_t>(tilesY);
+
+        for (int pass = 0; pass < m_pathGuiding->numTrainingPasses; ++pass)
+        {
+            // Lookups while tracing see the guide as built after the pass before
+            m_pathGuide = guide;
+            runTiles(m_threadPool.get(), m_numThreads, numTiles, [&](std::size_t tile)
+                     {
+                         const int tileX = static_cast<int>(tile % static_cast<std::size_t>(tilesX)) * m_tileSize;
+                         const int tileY = static_cast<int>(tile / static_cast<std::size_t>(tilesX)) * m_tileSize;
+                         trainTile(*guide, tileX, tileY, static_cast<std::uint64_t>(pass), world, lights);
+                     },
+                     std::nullopt);
+            m_pathGuide.reset();
+            guide->build();
+        }
+        return guide;
+    }
 
+    // Bounds of the surfaces that the camera sees, from the rays through a coarse grid of pixel
+    // centers. Scenes often sit on a huge ground or inside a large enclosure, whose bounds would
+    // spread the guide's grid far too thin.
+    AABB<T> visibleBounds(const Hittable<T> &world) const
+    {
         constexpr T eps = static_cast<T>(0.001);
+        constexpr int stride = 4;
 
-        if (world.hit(r, Interval<T>(eps, infinity<T>), record))
+        AABB<T> bounds;
+        bool empty = true;
+        const auto half = static_cast<T>(0.5);
+        for (int i = 0; i < m_imageHeight; i += stride)
         {
-            Ray<T> scattered;
-            Color<T> attenuation;
+            for (int j = 0; j < m_imageWidth; j += stride)
+            {
+                HitRecord<T> record;
+                if (world.hit(getRay<s_genericKernel>(i, j, half, half, 0, 0), Interval<T>(eps, infinity<T>), record))
+                {
+                    const AABB<T> point(record.point(), record.point());
+                    bounds = empty ? point : AABB<T>(bounds, point);
+                    empty = false;
+                }
+            }
+        }
+        return empty ? world.boundingBox() : bounds;
+    }
+
+    void trainTile(PathGuide<T> &guide, int tileX, int tileY, std::uint64_t pass, const Hittable<T> &world, const LightList<T> &lights) const
+    {
+        // Where a path left a non-specular surface: the radiance it had gathered and its
+        // throughput right after the bounce, from which the light it brings back is recovered
+        struct Bounce
+        {
+            Ray<T> ray;
+            Vector3<T> normal;
+            T pdf;
+            Color<T> radiance;
+            Color<T> throughput;
+        };
+
+        thread_local std::vector<Bounce> bounces;
+        thread_local std::vector<typename PathGuide<T>::Sample> samples;
+        samples.clear();
 
-            if (record.material() && record.material()->scatter(r, record, attenuation, scattered))
+        const int endX = std::min(tileX + m_tileSize, m_imageWidth);
+        const int endY = std::min(tileY + m_tileSize, m_imageHeight);
+        for (int i = tileY; i < endY; ++i)
+        {
+            for (int j = tileX; j < endX; ++j)
             {
-                return attenuation * rayColor(scattered, world, reflectionCount + 1);
+                const auto pixel = static_cast<std::uint64_t>(i) * static_cast<std::uint64_t>(m_imageWidth) + static_cast<std::uint64_t>(j);
+                const auto key = Sampling::sampleKey(m_seed ^ s_guideSeed, pixel, pass);
+                std::array<T, 2> lens{0, 0};
+                const T lensU = Sampling::toUnit<T>(Sampling::counterHash(key, s_lensDimension));
+                const T lensV = Sampling::toUnit<T>(Sampling::counterHash(key, s_lensDimension + 1));
+                Sampling::toUnitDisk(&lensU, &lensV, &lens[0], &lens[1], 1);
+
+                PathState path;
+                path.ray = getRay<s_genericKernel>(i, j,
+                                                   Sampling::toUnit<T>(Sampling::counterHash(key, s_pixelOffsetDimension)),
+                                                   Sampling::toUnit<T>(Sampling::counterHash(key, s_pixelOffsetDimension + 1)),
+                                                   lens[0], lens[1]);
+                path.key = key;
+
+                bounces.clear();
+                while (traceSegment<s_genericKernel>(path, world, lights, nullptr))
+                {
+                    if (!path.previousSpecular && path.previousPdf > 0)
+                    {
+                        bounces.push_back(Bounce{path.ray, path.normal, path.previousPdf, path.radiance, path.throughput});
+                    }
+                }
+
+                for (const auto &bounce : bounces)
+                {
+                    // Light brought back through the bounce, divided by the throughput up to
+                    // it, estimates the radiance arriving from the scattered direction
+                    const auto gathered = path.radiance - bounce.radiance;
+                    T incident = 0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        incident += (bounce.throughput[c] > 0) ? gathered[c] / bounce.throughput[c] : 0;
+                    }
+                    incident /= 3;
+                    samples.push_back({bounce.ray.origin(), bounce.normal, guide.bin(unitVector(bounce.ray.direction())), incident / bounce.pdf});
+                }
             }
-            else
+        }
+        guide.add(samples);
+    }
+
+    // A diffuse surface as the camera sees it, directly or through specular surfaces
+    struct CachePoint
+    {
+        Point3<T> point;
+        Vector3<T> normal;
+        T distance; // Along the path from the camera
+    };
+
+    // Fills an irradiance cache for the frame in passes over ever finer grids of pixels, from
+    // s_cachePrepassStride px apart down to every pixel. A pass follows the ray through the
+    // center of each of its pixels to the first diffuse surface and makes a record there if the
+    // cache has none valid yet. The records of a pass are made in parallel against the cache of
+    // the passes before it and added in pixel order, so the cache does not depend on the threads.
+    std::shared_ptr<const IrradianceCache<T>> fillIrradianceCache(const Hittable<T> &world, const LightList<T> &lights) const
+    {
+        auto cache = std::make_shared<IrradianceCache<T>>(*m_irradianceCacheSettings);
+
+        // Angle a pixel subtends, which gives the record spacing bounds in pixels
+        const T pixelAngle = m_pixelSpread;
+
+        // Records are only made for a few of the pixels, so each row of a pass keeps its own
+        // in pixel order, and the rows are added one after another
+        std::vector<std::vector<typename IrradianceCache<T>::Record>> rowRecords;
+        for (int stride = s_cachePrepassStride; stride >= 1; stride /= 2)
+        {
+            const auto numRows = static_cast<std::size_t>((m_imageHeight + stride - 1) / stride);
+            rowRecords.resize(numRows);
+            runTiles(m_threadPool.get(), m_numThreads, numRows, [&](std::size_t row)
+                     {
+                         auto &records = rowRecords[row];
+                         records.clear();
+
+                         // Pixels of this pass that the coarser passes did not visit
+                         const int i = static_cast<int>(row) * stride;
+                         const bool coarseRow = stride != s_cachePrepassStride && i % (2 * stride) == 0;
+                         for (int j = coarseRow ? stride : 0; j < m_imageWidth; j += coarseRow ? 2 * stride : stride)
+                         {
+                             const auto pixel = static_cast<std::uint64_t>(i) * static_cast<std::uint64_t>(m_imageWidth) + static_cast<std::uint64_t>(j);
+                             const auto key = Sampling::sampleKey(m_seed ^ s_cacheSeed, pixel, 0);
+                             const auto half = static_cast<T>(0.5);
+                             const auto point = cachePoint(world, getRay<s_genericKernel>(i, j, half, half, 0, 0), key);
+                             if (point && !cache->covers(point->point, point->normal))
+                             {
+                                 records.push_back(irradianceRecord(world, lights, *point, key, point->distance * pixelAngle));
+                             }
+                         }
+                     },
+                     std::nullopt);
+
+            for (const auto &records : rowRecords)
+            {
+                for (const auto &record : records)
+                {
+                    cache->insert(record);
+                }
+            }
+        }
+        return cache;
+    }
+
+    // Follows a camera ray through specular surfaces to the diffuse surface that the render
+    // would shade from the cache, drawing the same kind of random decisions as a path does
+    std::optional<CachePoint> cachePoint(const Hittable<T> &world, Ray<T> ray, std::uint64_t key) const
+    {
+        constexpr T eps = static_cast<T>(0.001);
+
+        T distance = 0;
+        for (int depth = 0; m_maxReflection < 0 || depth <= m_maxReflection; ++depth)
+        {
+            Sampling::threadStream<T>().restart(key, s_pathDimension + static_cast<std::uint64_t>(depth) * s_bounceDimensions);
+
+            HitRecord<T> record;
+            if (!world.hit(ray, Interval<T>(eps, infinity<T>), record))
+            {
+                return std::nullopt;
+            }
+            distance += record.t() * ray.direction().length();
+
+            const auto &material = *record.material();
+            if (material.isDiffuse())
+            {
+                return CachePoint{record.point(), record.normal(), distance};
+            }
+
+            Ray<T> scattered;
+            Color<T> attenuation;
+            if (!material.isSpecular() || !material.scatter(ray, record, attenuation, scattered) ||
+                depth >= s_maxCachePointDepth)
             {
-                return black;
+                return std::nullopt;
             }
+            ray = scattered;
+        }
+        return std::nullopt;
+    }
+
+    // A new record at a cache point: every stratum of its hemisphere is traced as a path of its
+    // own, on a stream keyed by the record and the stratum
+    typename IrradianceCache<T>::Record irradianceRecord(
+        const Hittable<T> &world,
+        const LightList<T> &lights,
+        const CachePoint &at,
+        std::uint64_t key,
+        T pixelSize) const
+    {
+        const auto &settings = *m_irradianceCacheSettings;
+        const ONB<T> frame(at.normal);
+        const auto numSamples = static_cast<std::size_t>(settings.numThetaStrata) * static_cast<std::size_t>(settings.numPhiStrata);
+
+        std::vector<Color<T>> radiance(numSamples);
+        std::vector<T> distances(numSamples);
+        std::vector<std::array<T, 2>> jitter(numSamples);
+        for (int j = 0; j < settings.numThetaStrata; ++j)
+        {
+            for (int k = 0; k < settings.numPhiStrata; ++k)
+            {
+                const auto index = static_cast<std::size_t>(j) * static_cast<std::size_t>(settings.numPhiStrata) + static_cast<std::size_t>(k);
+                const auto stream = Sampling::sampleKey(key, index, 1);
+                jitter[index] = {Sampling::toUnit<T>(Sampling::counterHash(stream, s_pixelOffsetDimension)),
+                                 Sampling::toUnit<T>(Sampling::counterHash(stream, s_pixelOffsetDimension + 1))};
+                const auto direction = IrradianceCache<T>::sampleDirection(frame, j, k, jitter[index][0], jitter[index][1], settings);
+
+                // The samples stand in for the diffuse bounce at the point, so emitters they hit
+                // are weighted against light sampling as that bounce would be
+                PathState path;
+                path.ray = Ray<T>(at.point, direction);
+                path.key = stream;
+                path.depth = 1;
+                path.previousSpecular = false;
+                path.previousPdf = std::max(dot(at.normal, direction), static_cast<T>(0)) / pi<T>;
+                path.diffuseBounce = true;
+
+                bool tracing = traceSegment<s_genericKernel>(path, world, lights, nullptr);
+                distances[index] = path.hitDistance;
+                while (tracing)
+                {
+                    tracing = traceSegment<s_genericKernel>(path, world, lights, nullptr);
+                }
+                radiance[index] = path.radiance;
+            }
+        }
+
+        return IrradianceCache<T>::makeRecord(at.point, frame, radiance, distances, jitter, pixelSize, settings);
+    }
+
+    template <KernelConfig Config>
+    void traceTile(RenderPass &pass, std::size_t tile) const
+    {
+        const auto &cell = pass.tiles[tile];
+        Footprint *footprint = pass.footprints ? &(*pass.footprints)[static_cast<std::size_t>(cell[1]) * static_cast<std::size_t>(pass.tilesX) + cell[0]]
+                                               : nullptr;
+        renderTile<Config>(static_cast<int>(cell[0]) * m_tileSize, static_cast<int>(cell[1]) * m_tileSize, pass.world, pass.lights, pass.framebuffer, pass.firstRow, footprint);
+    }
+
+    template <KernelConfig Config>
+    void renderTile(
+        int tileX,
+        int tileY,
+        const Hittable<T> &world,
+        const LightList<T> &lights,
+        std::vector<Color<T>> &framebuffer,
+        int firstRow,
+        Footprint *footprint) const
+    {
+        const int endX = (tileX + m_tileSize < m_imageWidth) ? tileX + m_tileSize : m_imageWidth;
+        const int endY = (tileY + m_tileSize < m_imageHeight) ? tileY + m_tileSize : m_imageHeight;
+
+        // Pixels of the tile inside the image, as {row, column}
+        thread_local std::vector<std::array<int, 2>> pixels;
+        pixels.clear();
+        for (const auto &offset : m_tilePixels)
+        {
+            const int i = tileY + static_cast<int>(offset[1]);
+            const int j = tileX + static_cast<int>(offset[0]);
+            if (i < endY && j < endX)
+            {
+                pixels.push_back({i, j});
+            }
+        }
+
+        // Every sample of a pixel has its own counter-based stream. The first dimensions are
+        // the pixel offset and lens sample, generated for the whole tile in one batch; every
+        // bounce of the path then continues on the same stream through the thread's sample
+        // stream.
+        thread_local std::vector<std::uint64_t> keys;
+        thread_local Sampling::SampleBlock<T> pixelOffsets;
+        thread_local Sampling::SampleBlock<T> lensSamples;
+
+        keys.clear();
+        for (const auto &[i, j] : pixels)
+        {
+            const auto pixel = static_cast<std::uint64_t>(i) * static_cast<std::uint64_t>(m_imageWidth) + static_cast<std::uint64_t>(j);
+            for (int s = 0; s < m_numSamplesPerPixel; ++s)
+            {
+                keys.push_back(Sampling::sampleKey(m_seed, pixel, static_cast<std::uint64_t>(s)));
+            }
+        }
+
+        const bool defocus = enabled<Config.defocus>(m_defocusAngle > 0);
+
+        Sampling::fillUniform2D(keys.data(), s_pixelOffsetDimension, pixelOffsets, keys.size());
+        if (defocus)
+        {
+            Sampling::fillUnitDisk(keys.data(), s_lensDimension, lensSamples, keys.size());
+        }
+
+        thread_local std::vector<PathState> paths;
+        paths.clear();
+
+        std::size_t sampleIndex = 0;
+        for (const auto &[i, j] : pixels)
+        {
+            for (int s = 0; s < m_numSamplesPerPixel; ++s)
+            {
+                T offsetX, offsetY;
+                pixelOffsets.next(offsetX, offsetY);
+
+                T lensX = 0, lensY = 0;
+                if (defocus)
+                {
+                    lensSamples.next(lensX, lensY);
+                }
+
+                PathState path;
+                path.ray = getRay<Config>(i, j, offsetX, offsetY, lensX, lensY);
+                path.key = keys[sampleIndex++];
+                paths.push_back(path);
+            }
+        }
+
+        if (footprint)
+        {
+            footprint->clear();
+        }
+
+        if (m_rayReordering || world.prefersBatches())
+        {
+            traceReordered<Config>(paths, world, lights, footprint);
+        }
+        else
+        {
+            for (auto &path : paths)
+            {
+                while (traceSegment<Config>(path, world, lights, footprint))
+                {
+                }
+            }
+        }
+
+        if (footprint)
+        {
+            std::sort(footprint->begin(), footprint->end());
+            footprint->erase(std::unique(footprint->begin(), footprint->end()), footprint->end());
+        }
+
+        // Samples are summed in the same order in both modes, so that they give the same image
+        sampleIndex = 0;
+        for (const auto &[i, j] : pixels)
+        {
+            Color<T> pixelColor(0.0, 0.0, 0.0);
+            for (int s = 0; s < m_numSamplesPerPixel; ++s)
+            {
+                pixelColor += paths[sampleIndex++].radiance;
+            }
+            pixelColor *= m_pixelSampleScale;
+
+            framebuffer[static_cast<std::size_t>(i - firstRow) * static_cast<std::size_t>(m_imageWidth) + static_cast<std::size_t>(j)] = pixelColor;
+        }
+    }
+
+    // Traces the paths of a tile one bounce at a time. Camera rays of a tile are coherent
+    // already, but after a diffuse bounce consecutive rays head anywhere. Before every further
+    // bounce the surviving paths are therefore sorted by the direction octant and the Morton
+    // code of the origin, so that rays leaving the same region in similar directions are traced
+    // one after another and find the same nodes of the scene in cache. The paths themselves are
+    // moved into that order, which keeps reading them sequential; finished ones leave their
+    // radiance in `paths`.
+    template <KernelConfig Config>
+    void traceReordered(std::vector<PathState> &paths, const Hittable<T> &world, const LightList<T> &lights, Footprint *footprint) const
+    {
+        thread_local std::vector<PathState> batch;
+        thread_local std::vector<PathState> sortedBatch;
+        thread_local std::vector<std::uint32_t> order;
+        thread_local std::vector<Ray<T>> rays;
+        thread_local std::vector<std::optional<HitRecord<T>>> hits;
+
+        batch = paths;
+        for (std::size_t p = 0; p < batch.size(); ++p)
+        {
+            batch[p].sample = static_cast<std::uint32_t>(p);
+        }
+
+        for (bool cameraRays = true; !batch.empty(); cameraRays = false)
+        {
+            if (!cameraRays)
+            {
+                order.resize(batch.size());
+                for (std::size_t p = 0; p < batch.size(); ++p)
+                {
+                    order[p] = static_cast<std::uint32_t>(p);
+                }
+                sortByRayKey(batch, order);
+                sortedBatch.resize(batch.size());
+                for (std::size_t k = 0; k < order.size(); ++k)
+                {
+                    sortedBatch[k] = batch[order[k]];
+                }
+                batch.swap(sortedBatch);
+            }
+
+            // Worlds that trace many rays better than one (see Hittable::hitBatch) find the hits
+            // of the whole bounce first
+            const bool batchHits = world.prefersBatches();
+            if (batchHits)
+            {
+                rays.resize(batch.size());
+                for (std::size_t k = 0; k < batch.size(); ++k)
+                {
+                    rays[k] = batch[k].ray;
+                }
+                hits.resize(batch.size());
+                world.hitBatch(rays, Interval<T>(static_cast<T>(0.001), infinity<T>), hits);
+            }
+
+            std::size_t numActive = 0;
+            for (std::size_t k = 0; k < batch.size(); ++k)
+            {
+                if (traceSegment<Config>(batch[k], world, lights, footprint, batchHits ? &hits[k] : nullptr))
+                {
+                    batch[numActive++] = batch[k];
+                }
+                else
+                {
+                    paths[batch[k].sample].radiance = batch[k].radiance;
+                }
+            }
+            batch.resize(numActive);
+        }
+    }
+
+    // Sorts the indices in `active` into paths by ray origin and direction
+    static void sortByRayKey(const std::vector<PathState> &paths, std::vector<std::uint32_t> &active)
+    {
+        // The grid of the Morton code spans the origins of the rays being sorted. A batch is a
+        // few thousand rays, for which 128 cells per axis separate neighbourhoods well enough.
+        std::array<T, 3> low{infinity<T>, infinity<T>, infinity<T>};
+        std::array<T, 3> high{-infinity<T>, -infinity<T>, -infinity<T>};
+        for (const auto p : active)
+        {
+            const auto &origin = paths[p].ray.origin();
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const auto a = static_cast<std::size_t>(axis);
+                low[a] = std::min(low[a], origin[axis]);
+                high[a] = std::max(high[a], origin[axis]);
+            }
+        }
+
+        std::array<T, 3> scale{};
+        for (std::size_t axis = 0; axis < 3; ++axis)
+        {
+            scale[axis] = (high[axis] > low[axis]) ? static_cast<T>(127) / (high[axis] - low[axis]) : 0;
+        }
+
+        // 24-bit keys, the octant in the top bits so that each direction class is one run
+        // ordered along the curve
+        thread_local std::vector<std::uint32_t> keys;
+        keys.resize(active.size());
+        for (std::size_t k = 0; k < active.size(); ++k)
+        {
+            const auto &ray = paths[active[k]].ray;
+            std::array<std::uint32_t, 3> cell{};
+            std::uint32_t octant = 0;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const auto a = static_cast<std::size_t>(axis);
+                cell[a] = static_cast<std::uint32_t>((ray.origin()[axis] - low[a]) * scale[a]);
+                octant |= static_cast<std::uint32_t>(ray.direction()[axis] < 0) << axis;
+            }
+            keys[k] = (octant << 21) | SpaceFillingCurve::mortonEncode(cell[0], cell[1], cell[2]);
+        }
+
+        // Stable LSD radix sort, one byte per pass
+        thread_local std::vector<std::uint32_t> sortedKeys;
+        thread_local std::vector<std::uint32_t> sortedActive;
+        sortedKeys.resize(active.size());
+        sortedActive.resize(active.size());
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            std::array<std::uint32_t, 257> offsets{};
+            for (const auto key : keys)
+            {
+                ++offsets[((key >> shift) & 0xFF) + 1];
+            }
+            for (std::size_t digit = 1; digit < offsets.size(); ++digit)
+            {
+                offsets[digit] += offsets[digit - 1];
+            }
+            for (std::size_t k = 0; k < keys.size(); ++k)
+            {
+                const auto position = offsets[(keys[k] >> shift) & 0xFF]++;
+                sortedKeys[position] = keys[k];
+                sortedActive[position] = active[k];
+            }
+            keys.swap(sortedKeys);
+            active.swap(sortedActive);
+        }
+    }
+
+    FrameSettings frameSettings(const Hittable<T> &world, const LightList<T> &lights) const
+    {
+        return FrameSettings{&world, &lights, m_imageWidth, m_imageHeight, m_numSamplesPerPixel, m_maxReflection,
+                             m_tileSize, m_seed, m_background, m_center, m_pixel00Center, m_pixelDeltaHorizontal,
+                             m_pixelDeltaVertical, m_w, m_defocusDiskU, m_defocusDiskV};
+    }
+
+    // Pixels of the kept frame whose camera rays can reach a box, as {minX, minY, maxX, maxY},
+    // or nothing if none can. The corners are projected through the lens center onto the
+    // focus plane; the rectangle is then widened by the pixel filter and the defocus blur,
+    // which is largest at the nearest and farthest corner.
+    std::optional<std::array<int, 4>> imageFootprint(const AABB<T> &box) const
+    {
+        const auto &frame = m_frame->settings;
+        const std::array<int, 4> wholeImage{0, 0, frame.imageWidth - 1, frame.imageHeight - 1};
+
+        const T focusDist = dot(frame.pixel00Center - frame.center, -frame.w);
+        const T lensRadius = frame.defocusDiskU.length();
+        const T deltaX2 = frame.pixelDeltaHorizontal.squaredNorm();
+        const T deltaY2 = frame.pixelDeltaVertical.squaredNorm();
+
+        T minX = infinity<T>, minY = infinity<T>, maxX = -infinity<T>, maxY = -infinity<T>;
+        T blur = 0;
+        int numBehind = 0;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const Point3<T> point((corner & 1) ? box.x().max() : box.x().min(),
+                                  (corner & 2) ? box.y().max() : box.y().min(),
+                                  (corner & 4) ? box.z().max() : box.z().min());
+            const auto offset = point - frame.center;
+            const T depth = dot(offset, -frame.w);
+            if (depth <= 0)
+            {
+                ++numBehind;
+                continue;
+            }
+
+            const auto onFocusPlane = frame.center + offset * (focusDist / depth) - frame.pixel00Center;
+            const T x = dot(onFocusPlane, frame.pixelDeltaHorizontal) / deltaX2;
+            const T y = dot(onFocusPlane, frame.pixelDeltaVertical) / deltaY2;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            blur = std::max(blur, lensRadius * std::abs(depth - focusDist) / depth);
+        }
+
+        if (numBehind == 8)
+        {
+            return std::nullopt;
+        }
+        if (numBehind > 0)
+        {
+            // The box reaches behind the lens, where the projection breaks down
+            return wholeImage;
+        }
+
+        const T marginX = static_cast<T>(0.5) + blur / std::sqrt(deltaX2);
+        const T marginY = static_cast<T>(0.5) + blur / std::sqrt(deltaY2);
+        const T lowX = std::max(std::floor(minX - marginX), static_cast<T>(0));
+        const T lowY = std::max(std::floor(minY - marginY), static_cast<T>(0));
+        const T highX = std::min(std::ceil(maxX + marginX), static_cast<T>(wholeImage[2]));
+        const T highY = std::min(std::ceil(maxY + marginY), static_cast<T>(wholeImage[3]));
+        if (lowX > highX || lowY > highY)
+        {
+            return std::nullopt;
+        }
+        return std::array<int, 4>{static_cast<int>(lowX), static_cast<int>(lowY), static_cast<int>(highX), static_cast<int>(highY)};
+    }
+
+    static void logDone(std::chrono::steady_clock::time_point startTime)
+    {
+        const auto endTime = std::chrono::steady_clock::now();
+        const auto totalSeconds = std::chrono::duration<double>(endTime - startTime).count();
+        const int totalH = static_cast<int>(totalSeconds) / 3600;
+        const int totalM = (static_cast<int>(totalSeconds) % 3600) / 60;
+        const int totalS = static_cast<int>(totalSeconds) % 60;
+
+        std::clog << "\rDone. Total time: "
+                  << std::setfill('0')
+                  << std::setw(2) << totalH << ":"
+                  << std::setw(2) << totalM << ":"
+                  << std::setw(2) << totalS
+                  << "                    \n";
+    }
+
+    static void logTileProgress(int tilesDone, int numTiles, std::chrono::steady_clock::time_point startTime)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration<double>(now - startTime).count();
+        const double avgTimePerTile = elapsed / tilesDone;
+        const int tilesRemaining = numTiles - tilesDone;
+        const double etaSeconds = avgTimePerTile * tilesRemaining;
+
+        const int etaH = static_cast<int>(etaSeconds) / 3600;
+        const int etaM = (static_cast<int>(etaSeconds) % 3600) / 60;
+        const int etaS = static_cast<int>(etaSeconds) % 60;
+
+        std::clog << "\rRendering... Progress: " << tilesDone << "/" << numTiles
+                  << " tiles | ETA: " << std::setfill('0')
+                  << std::setw(2) << etaH << ":"
+                  << std::setw(2) << etaM << ":"
+                  << std::setw(2) << etaS
+                  << "    " << std::flush;
+    }
+
+    template <KernelConfig Config>
+    Ray<T> getRay(int i, int j, T offsetX, T offsetY, T lensX, T lensY) const
+    {
+        // Construct a camera ray originating from the origin (defocus disk) and directed at a
+        // sampled point around the pixel (i, j). The offsets are uniform in [0, 1) and are
+        // shifted to the [-0.5, -0.5] x [+0.5, +0.5] square around the pixel center; the lens
+        // sample is a point in the unit disk.
+
+        const auto pixelSample = m_pixel00Center +
+                                 ((i + offsetY - static_cast<T>(0.5)) * m_pixelDeltaVertical) +
+                                 ((j + offsetX - static_cast<T>(0.5)) * m_pixelDeltaHorizontal);
+
+        const auto rayOrigin = enabled<Config.defocus>(m_defocusAngle > 0) ? defocusDiskPoint(lensX, lensY) : m_center;
+        const auto rayDirection = pixelSample - rayOrigin;
+
+        return Ray<T>(rayOrigin, rayDirection);
+    }
+
+    Point3<T> defocusDiskPoint(T lensX, T lensY) const
+    {
+        return m_center + (lensX * m_defocusDiskU) + (lensY * m_defocusDiskV);
+    }
+
+    // Advances a path by one segment: finds the next hit, adds emission and a light sample
+    // there and scatters. Returns false once the path has ended. The objects that the first two
+    // segments hit or sample as lights are added to footprint, if given.
+    template <KernelConfig Config>
+    bool traceSegment(PathState &path, const Hittable<T> &world, const LightList<T> &lights, Footprint *footprint,
+                      const std::optional<HitRecord<T>> *batchHit = nullptr) const
+    {
+        // Next-event estimation at every non-specular bounce samples one light directly, and
+        // light and BSDF samples are weighted against each other with the power heuristic
+        // (multiple importance sampling). batchHit, if given, is the hit of path.ray found
+        // ahead by Hittable::hitBatch.
+        constexpr T eps = static_cast<T>(0.001);
+
+        const bool depthLimit = enabled<Config.depthLimit>(m_maxReflection >= 0);
+        const bool nextEvent = enabled<Config.lights>(!lights.isEmpty());
+        const bool onlyDiffuse = enabled<Config.diffuse>(false);
+
+        if (depthLimit && path.depth > m_maxReflection)
+        {
+            return false;
+        }
+
+        // Every bounce draws from its own range of the sample's stream, so that a path sees the
+        // same numbers however its bounces are scheduled
+        Sampling::threadStream<T>().restart(path.key, s_pathDimension + static_cast<std::uint64_t>(path.depth) * s_bounceDimensions);
+
+        const Ray<T> &ray = path.ray;
+        HitRecord<T> record;
+        if (batchHit ? !batchHit->has_value() : !world.hit(ray, Interval<T>(eps, infinity<T>), record))
+        {
+            if (const auto *environment = lights.environment())
+            {
+                // The environment is a light, weighted against sampling it like the others
+                const T weight = path.previousSpecular ? 1 : powerHeuristic(path.previousPdf, nextEvent ? lights.environmentPdf(ray.direction()) : 0);
+                path.radiance += weight * (path.throughput * environment->radiance(ray.direction()));
+            }
+            else
+            {
+                path.radiance += path.throughput * backgroundColor(ray);
+            }
+            path.hitDistance = infinity<T>;
+            return false;
+        }
+        if (batchHit)
+        {
+            record = **batchHit;
+        }
+        path.hitDistance = record.t();
+        path.normal = record.normal();
+
+        // Textures are filtered over the ray's footprint, which camera rays widen by a pixel's
+        // angle and rough bounces by s_roughSpread
+        path.rayWidth += ((path.depth == 0) ? m_pixelSpread : path.raySpread) * record.t() * ray.direction().length();
+        record.setRayWidth(path.rayWidth);
+
+        if (path.depth > 1)
+        {
+            footprint = nullptr;
+        }
+        if (footprint && (footprint->empty() || footprint->back() != record.object()))
+        {
+            footprint->push_back(record.object());
+        }
+
+        // Every hit object has a material, the constructors reject null ones
+        const auto &material = *record.material();
+        const bool specular = !onlyDiffuse && material.isSpecular();
+
+        // Diffuse materials do not emit
+        const auto emitted = onlyDiffuse ? Color<T>(0.0, 0.0, 0.0) : material.emitted(ray, record);
+        if (!emitted.nearZero())
+        {
+            T weight = 1;
+            if (!path.previousSpecular)
+            {
+                const T lightPdf = nextEvent ? lights.pdfValue(record.object(), ray.origin(), ray.direction()) : 0;
+                weight = powerHeuristic(path.previousPdf, lightPdf);
+            }
+            path.radiance += weight * (path.throughput * emitted);
+        }
+
+        // Where the guide knows the light around the point, scattering draws from it or from the
+        // BSDF, and both light and scattering samples are weighted with the density of that mix
+        const T *guide = (m_pathGuide && !specular) ? m_pathGuide->find(record.point(), record.normal()) : nullptr;
+
+        if (nextEvent && !specular)
+        {
+            path.radiance += path.throughput * sampleLight(ray, record, material, guide, world, lights, footprint);
+        }
+
+        // With an irradiance cache, the first diffuse surface along the path takes its indirect
+        // light from the cache where there is a record instead of scattering on
+        if (m_irradianceCache && !path.diffuseBounce && (onlyDiffuse || material.isDiffuse()))
+        {
+            Color<T> irradiance;
+            if (m_irradianceCache->lookup(record.point(), record.normal(), irradiance))
+            {
+                path.radiance += path.throughput * material.evaluate(ray, record, record.normal()) * irradiance;
+                return false;
+            }
+        }
+
+        Ray<T> scattered;
+        Color<T> attenuation;
+        if (guide)
+        {
+            if (Util::random<T>() < m_pathGuide->settings().guidedFraction)
+            {
+                const T u = Util::random<T>();
+                const T v = Util::random<T>();
+                const T w = Util::random<T>();
+                scattered = Ray<T>(record.point(), m_pathGuide->sample(guide, u, v, w));
+                path.previousPdf = scatterPdf(ray, record, material, guide, scattered.direction());
+                const auto f = material.evaluate(ray, record, scattered.direction());
+                if (path.previousPdf <= 0 || f.nearZero())
+                {
+                    return false;
+                }
+                attenuation = f / path.previousPdf;
+            }
+            else
+            {
+                // The material's weight f / pdf, reweighted to the density of the mix
+                if (!material.scatter(ray, record, attenuation, scattered))
+                {
+                    return false;
+                }
+                const T bsdfPdf = material.pdf(ray, record, scattered.direction());
+                const T guidedFraction = m_pathGuide->settings().guidedFraction;
+                path.previousPdf = guidedFraction * m_pathGuide->pdf(guide, scattered.direction()) + (1 - guidedFraction) * bsdfPdf;
+                if (path.previousPdf <= 0)
+                {
+                    return false;
+                }
+                attenuation = attenuation * (bsdfPdf / path.previousPdf);
+            }
+        }
+        else if (!material.scatter(ray, record, attenuation, scattered))
+        {
+            return false;
+        }
+        else
+        {
+            path.previousPdf = specular ? 0 : material.pdf(ray, record, scattered.direction());
+        }
+
+        path.previousSpecular = specular;
+        path.diffuseBounce = path.diffuseBounce || !path.previousSpecular;
+        path.raySpread = path.previousSpecular ? ((path.depth == 0) ? m_pixelSpread : path.raySpread) : s_roughSpread;
+        path.throughput = path.throughput * attenuation;
+        path.ray = scattered;
+
+        if (!depthLimit && path.depth >= s_rouletteDepth)
+        {
+            // Survivors are weighted up by the inverse probability, which keeps the estimate
+            // unbiased
+            const auto &throughput = path.throughput;
+            const T survival = std::min(std::max({throughput.r(), throughput.g(), throughput.b()}), s_maxSurvival);
+            if (Util::random<T>() >= survival)
+            {
+                return false;
+            }
+            path.throughput = throughput / survival;
+        }
+
+        ++path.depth;
+        return true;
+    }
+
+    // Density with which a bounce scatters into direction: the material's, or its mix with the
+    // guide's where there is a guide distribution
+    T scatterPdf(const Ray<T> &rIn, const HitRecord<T> &record, const Material<T> &material, const T *guide, const Vector3<T> &direction) const
+    {
+        const T bsdfPdf = material.pdf(rIn, record, direction);
+        if (!guide)
+        {
+            return bsdfPdf;
+        }
+        const T guidedFraction = m_pathGuide->settings().guidedFraction;
+        return guidedFraction * m_pathGuide->pdf(guide, direction) + (1 - guidedFraction) * bsdfPdf;
+    }
+
+    Color<T> sampleLight(
+        const Ray<T> &rIn,
+        const HitRecord<T> &record,
+        const Material<T> &material,
+        const T *guide,
+        const Hittable<T> &world,
+        const LightList<T> &lights,
+        Footprint *footprint) const
+    {
+        constexpr auto black = Color<T>(0.0, 0.0, 0.0);
+        constexpr T eps = static_cast<T>(0.001);
+
+        const auto lightIndex = lights.sample(Util::random<T>());
+        if (lights.isEnvironment(lightIndex))
+        {
+            return sampleEnvironment(rIn, record, material, guide, world, lights);
+        }
+
+        const auto &light = lights.light(lightIndex);
+        if (footprint)
+        {
+            footprint->push_back(&light);
+        }
+        const auto direction = light.sampleDirection(record.point());
+
+        const T lightPdf = lights.selectionProbability(lightIndex) * light.pdfValue(record.point(), direction);
+        if (lightPdf <= 0)
+        {
+            return black;
+        }
+
+        const auto f = material.evaluate(rIn, record, direction);
+        if (f.nearZero())
+        {
+            return black;
+        }
+
+        // Find the sampled point on the light itself, then check that nothing blocks the
+        // segment up to it with an any-hit query
+        const Ray<T> shadowRay(record.point(), direction);
+        HitRecord<T> lightRecord;
+        if (!light.hit(shadowRay, Interval<T>(eps, infinity<T>), lightRecord))
+        {
+            return black;
+        }
+
+        const auto emitted = lightRecord.material()->emitted(shadowRay, lightRecord);
+        if (emitted.nearZero() || world.occluded(shadowRay, Interval<T>(eps, lightRecord.t() * (1 - eps))))
+        {
+            return black;
+        }
+
+        const T weight = powerHeuristic(lightPdf, scatterPdf(rIn, record, material, guide, direction));
+        return (weight / lightPdf) * (f * emitted);
+    }
+
+    // Light from a direction drawn from the environment, if nothing blocks it
+    Color<T> sampleEnvironment(
+        const Ray<T> &rIn,
+        const HitRecord<T> &record,
+        const Material<T> &material,
+        const T *guide,
+        const Hittable<T> &world,
+        const LightList<T> &lights) const
+    {
+        constexpr auto black = Color<T>(0.0, 0.0, 0.0);
+        constexpr T eps = static_cast<T>(0.001);
+
+        const auto &environment = *lights.environment();
+        const T u = Util::random<T>();
+        const T v = Util::random<T>();
+        const T w = Util::random<T>();
+        const auto direction = environment.sample(u, v, w);
+
+        const T lightPdf = lights.environmentPdf(direction);
+        if (lightPdf <= 0)
+        {
+            return black;
+        }
+
+        const auto f = material.evaluate(rIn, record, direction);
+        const auto emitted = environment.radiance(direction);
+        if (f.nearZero() || emitted.nearZero() || world.occluded(Ray<T>(record.point(), direction), Interval<T>(eps, infinity<T>)))
+        {
+            return black;
+        }
+
+        const T weight = powerHeuristic(lightPdf, scatterPdf(rIn, record, material, guide, direction));
+        return (weight / lightPdf) * (f * emitted);
+    }
+
+    static T powerHeuristic(T pdf, T otherPdf)
+    {
+        const T pdf2 = pdf * pdf;
+        const T otherPdf2 = otherPdf * otherPdf;
+        return (pdf2 + otherPdf2) > 0 ? pdf2 / (pdf2 + otherPdf2) : 0;
+    }
+
+    Color<T> backgroundColor(const Ray<T> &r) const
+    {
+        if (m_background)
+        {
+            return *m_background;
         }
 
         const auto unitDirection = unitVector(r.direction());
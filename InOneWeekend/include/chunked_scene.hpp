@@ -0,0 +1,706 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_CHUNKED_SCENE_HPP
+#define INONEWEEKEND_INCLUDE_CHUNKED_SCENE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "aabb.hpp"
+#include "bvh_tree.hpp"
+#include "hittable.hpp"
+#include "hittable_list.hpp"
+#include "interval.hpp"
+#include "mapped_file.hpp"
+#include "material_forward_decl.hpp"
+#include "ray.hpp"
+#include "space_filling_curve.hpp"
+#include "sphere.hpp"
+#include "vector3.hpp"
+
+// A sphere as stored in a chunk file, its material an index into the palette the file is
+// opened with
+template <std::floating_point T = double>
+struct PackedSphere
+{
+    std::array<T, 3> center{};
+    T radius{0};
+    std::uint32_t material{0};
+    std::uint32_t padding{0};
+};
+
+// Fixed-size start of a chunk file. The chunk table follows at tableOffset; every chunk is a
+// block of its spheres, the nodes of its tree and the tree's primitive indices, starting at an
+// offset that can be mapped on its own.
+struct ChunkedSceneHeader
+{
+    std::array<char, 8> magic{};
+    std::uint32_t version{0};
+    std::uint32_t byteOrder{0};   // s_byteOrder as written, tells a file from another endianness
+    std::uint32_t scalarBytes{0}; // sizeof(T) of the spheres and bounds
+    std::uint32_t nodeBytes{0};
+    std::uint64_t chunkCount{0};
+    std::uint64_t sphereCount{0};
+    std::uint64_t paletteSize{0}; // Materials the spheres index
+    std::uint64_t tableOffset{0};
+};
+
+// Spheres streamed from a file, for scenes whose objects do not fit in memory. The writer
+// partitions the spheres spatially into chunks and saves each with its own BVH; a render keeps
+// only the chunk table and a tree over the chunk bounds resident and maps chunks in when rays
+// reach them, dropping the least recently used ones beyond a memory budget.
+//
+// Rays traced one at a time page chunks in as they go, which is fine while the chunks the rays
+// of a tile reach fit in the budget. The camera instead hands over all the rays of a bounce at
+// once (see hitBatch): every ray is queued on the chunks its path crosses, the queues of
+// resident chunks are run first, and every other chunk is then loaded once for all the rays
+// waiting on it, the longest queue first, instead of once per ray that happens to reach it.
+//
+// Hits are returned with their shading attributes computed while the chunk was mapped, so
+// shading never needs a chunk again. The spheres hit are this object to the rest of the
+// renderer: they are not lights, and textures see them with a fixed level of detail.
+template <std::floating_point T = double>
+class ChunkedScene : public Hittable<T>
+{
+public:
+    static constexpr std::array<char, 8> s_magic{'R', 'T', 'C', 'H', 'U', 'N', 'K', '\0'};
+    static constexpr std::uint32_t s_version = 1;
+    static constexpr std::uint32_t s_byteOrder = 0x01020304;
+
+    // Chunk blocks start on multiples of this, which is a multiple of every common page size
+    static constexpr std::uint64_t s_chunkAlignment = 1 << 16;
+
+    static_assert(std::is_trivially_copyable_v<PackedSphere<T>> && std::is_trivially_copyable_v<BVHNode<T>>,
+                  "Chunks are written as raw bytes");
+
+    struct Statistics
+    {
+        std::uint64_t hits{0};      // Chunks found mapped
+        std::uint64_t loads{0};     // Chunks mapped from the file
+        std::uint64_t evictions{0};
+        std::uint64_t queuedRays{0}; // Ray-chunk pairs queued by hitBatch
+        std::uint64_t batches{0};    // Chunk queues run by hitBatch
+        std::size_t residentBytes{0};
+        std::size_t peakBytes{0};
+        std::uint64_t loadedBytes{0};
+
+        double hitRate() const { return (hits + loads > 0) ? static_cast<double>(hits) / static_cast<double>(hits + loads) : 1.0; }
+    };
+
+    // Opens a file written by write(), with the materials its spheres index and the bytes of
+    // chunks that may stay mapped. A chunk larger than the budget is still loaded when needed.
+    ChunkedScene(std::string path, std::vector<std::shared_ptr<Material<T>>> palette, std::size_t budgetBytes)
+        : m_path(std::move(path)), m_palette(std::move(palette)), m_budget(budgetBytes)
+    {
+        std::ifstream in(m_path, std::ios::binary);
+        ChunkedSceneHeader header;
+        if (!in || !in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        {
+            throw std::runtime_error("ChunkedScene: cannot read " + m_path);
+        }
+        if (header.magic != s_magic || header.version != s_version || header.byteOrder != s_byteOrder ||
+            header.scalarBytes != sizeof(T) || header.nodeBytes != sizeof(BVHNode<T>))
+        {
+            throw std::runtime_error("ChunkedScene: " + m_path + " is not a chunk file of this build");
+        }
+        if (header.paletteSize > m_palette.size() || std::any_of(m_palette.begin(), m_palette.end(), [](const auto &m)
+                                                                 { return !m; }))
+        {
+            throw std::invalid_argument("ChunkedScene: the palette does not cover the materials of " + m_path);
+        }
+
+        m_chunks.resize(header.chunkCount);
+        in.seekg(static_cast<std::streamoff>(header.tableOffset));
+        if (!in.read(reinterpret_cast<char *>(m_chunks.data()), static_cast<std::streamsize>(m_chunks.size() * sizeof(ChunkRecord))))
+        {
+            throw std::runtime_error("ChunkedScene: " + m_path + " is truncated");
+        }
+
+        std::vector<AABB<T>> chunkBounds;
+        chunkBounds.reserve(m_chunks.size());
+        std::uint64_t firstSphere = 0;
+        for (const auto &chunk : m_chunks)
+        {
+            if (chunk.firstSphere != firstSphere || chunk.offset % s_chunkAlignment != 0)
+            {
+                throw std::runtime_error("ChunkedScene: " + m_path + " has a damaged chunk table");
+            }
+            firstSphere += chunk.sphereCount;
+            chunkBounds.push_back(chunk.bounds);
+        }
+        if (firstSphere != header.sphereCount)
+        {
+            throw std::runtime_error("ChunkedScene: " + m_path + " has a damaged chunk table");
+        }
+        m_topLevel = BVHTree<T>(chunkBounds);
+    }
+
+    virtual ~ChunkedScene() override = default;
+
+    ChunkedScene(const ChunkedScene &) = delete;
+    ChunkedScene &operator=(const ChunkedScene &) = delete;
+
+    std::size_t chunkCount() const { return m_chunks.size(); }
+    std::size_t budget() const { return m_budget; }
+
+    // Whether the camera should trace with hitBatch, off to compare with paging on demand
+    void setBatching(bool batching) { m_batching = batching; }
+    virtual bool prefersBatches() const override { return m_batching; }
+
+    Statistics statistics() const
+    {
+        const std::scoped_lock lock(m_mutex);
+        return m_statistics;
+    }
+
+    // Writes the spheres of objects, which may hold nothing else, in chunks of about
+    // spheresPerChunk neighbouring spheres. Returns the palette to open the file with: the
+    // distinct materials of the spheres, in the order the file indexes them.
+    static std::vector<std::shared_ptr<Material<T>>> write(const std::string &path, const HittableList<T> &objects, std::size_t spheresPerChunk)
+    {
+        std::vector<PackedSphere<T>> spheres;
+        std::vector<std::shared_ptr<Material<T>>> palette;
+        std::unordered_map<const Material<T> *, std::uint32_t> paletteIndex;
+        spheres.reserve(objects.objects().size());
+        for (const auto &object : objects.objects())
+        {
+            const auto *sphere = dynamic_cast<const Sphere<T> *>(object.get());
+            if (sphere == nullptr)
+            {
+                throw std::invalid_argument("ChunkedScene: only spheres can be written");
+            }
+            const auto [entry, added] = paletteIndex.try_emplace(sphere->material().get(), static_cast<std::uint32_t>(palette.size()));
+            if (added)
+            {
+                palette.push_back(sphere->material());
+            }
+            const auto &center = sphere->center();
+            spheres.push_back(PackedSphere<T>{{center.x(), center.y(), center.z()}, sphere->radius(), entry->second, 0});
+        }
+
+        const auto chunks = partition(spheres, std::max<std::size_t>(spheresPerChunk, 1));
+
+        ChunkedSceneHeader header;
+        header.magic = s_magic;
+        header.version = s_version;
+        header.byteOrder = s_byteOrder;
+        header.scalarBytes = sizeof(T);
+        header.nodeBytes = sizeof(BVHNode<T>);
+        header.chunkCount = chunks.size();
+        header.sphereCount = spheres.size();
+        header.paletteSize = palette.size();
+        header.tableOffset = sizeof(header);
+
+        const std::string temporaryPath = path + ".tmp" + std::to_string(::getpid());
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        std::vector<ChunkRecord> table(chunks.size());
+        std::uint64_t offset = alignUp(sizeof(header) + table.size() * sizeof(ChunkRecord), s_chunkAlignment);
+        for (std::size_t c = 0; c < chunks.size(); ++c)
+        {
+            const auto [begin, end] = chunks[c];
+            const std::span<const PackedSphere<T>> chunkSpheres(spheres.data() + begin, end - begin);
+            const BVHTree<T> tree(sphereBounds(chunkSpheres));
+
+            auto &record = table[c];
+            record.bounds = tree.bounds();
+            record.offset = offset;
+            record.firstSphere = begin;
+            record.sphereCount = static_cast<std::uint32_t>(chunkSpheres.size());
+            record.nodeCount = static_cast<std::uint32_t>(tree.nodes().size());
+
+            const std::array<char, s_chunkAlignment> padding{};
+            file.seekp(static_cast<std::streamoff>(offset));
+            file.write(reinterpret_cast<const char *>(chunkSpheres.data()), static_cast<std::streamsize>(chunkSpheres.size_bytes()));
+            file.write(padding.data(), static_cast<std::streamsize>(record.nodeOffset() - chunkSpheres.size_bytes()));
+            file.write(reinterpret_cast<const char *>(tree.nodes().data()), static_cast<std::streamsize>(tree.nodes().size_bytes()));
+            file.write(reinterpret_cast<const char *>(tree.primitiveIndices().data()), static_cast<std::streamsize>(tree.primitiveIndices().size_bytes()));
+            offset = alignUp(offset + record.bytes(), s_chunkAlignment);
+        }
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(ChunkRecord)));
+        if (!file.flush())
+        {
+            std::filesystem::remove(temporaryPath);
+            throw std::runtime_error("ChunkedScene: cannot write " + temporaryPath);
+        }
+        file.close();
+        std::filesystem::rename(temporaryPath, path);
+        return palette;
+    }
+
+    virtual bool intersect(
+        const Ray<T> &r,
+        Interval<T> rayT,
+        SurfaceHit<T> &surface) const override
+    {
+        // Chunks are entered front to back and a hit culls the chunks behind it
+        return m_topLevel.traverse(r, rayT, [&](std::uint32_t chunkIndex, Interval<T> &interval)
+                                   {
+                                       const auto chunk = acquire(chunkIndex);
+                                       return chunk->tree.traverse(r, interval, [&](std::uint32_t sphere, Interval<T> &sphereInterval)
+                                                                   {
+                                                                       T t;
+                                                                       if (!intersectSphere(chunk->spheres[sphere], r, sphereInterval, t))
+                                                                       {
+                                                                           return false;
+                                                                       }
+                                                                       surface = SurfaceHit<T>{t, this, m_chunks[chunkIndex].firstSphere + sphere};
+                                                                       sphereInterval = Interval<T>(sphereInterval.min(), t);
+                                                                       interval = Interval<T>(interval.min(), t);
+                                                                       return true;
+                                                                   });
+                                   });
+    }
+
+    virtual void surfaceAttributes(
+        const Ray<T> &r,
+        const SurfaceHit<T> &surface,
+        HitRecord<T> &record) const override
+    {
+        // The chunk was just traversed, so it is nearly always still mapped
+        const auto chunkIndex = static_cast<std::uint32_t>(
+            std::upper_bound(m_chunks.begin(), m_chunks.end(), surface.primitive, [](std::uint32_t sphere, const ChunkRecord &chunk)
+                             { return sphere < chunk.firstSphere; }) -
+            m_chunks.begin() - 1);
+        const auto chunk = acquire(chunkIndex);
+        setAttributes(chunk->spheres[surface.primitive - m_chunks[chunkIndex].firstSphere], r, surface.t, record);
+    }
+
+    virtual bool occluded(
+        const Ray<T> &r,
+        Interval<T> rayT) const override
+    {
+        return m_topLevel.traverseAny(r, rayT, [&](std::uint32_t chunkIndex, Interval<T> &interval)
+                                      {
+                                          const auto chunk = acquire(chunkIndex);
+                                          return chunk->tree.traverseAny(r, interval, [&](std::uint32_t sphere, Interval<T> &sphereInterval)
+                                                                         {
+                                                                             T t;
+                                                                             return intersectSphere(chunk->spheres[sphere], r, sphereInterval, t);
+                                                                         });
+                                      });
+    }
+
+    virtual void hitBatch(
+        std::span<const Ray<T>> rays,
+        Interval<T> rayT,
+        std::span<std::optional<HitRecord<T>>> hits) const override
+    {
+        // The chunks every ray crosses, nearest first, as rays[i] holds [first[i], first[i + 1])
+        thread_local std::vector<std::pair<T, std::uint32_t>> crossed;
+        thread_local std::vector<std::size_t> first;
+        thread_local std::vector<std::size_t> next;
+        thread_local std::vector<T> closest;
+        crossed.clear();
+        first.assign(1, 0);
+        for (std::size_t i = 0; i < rays.size(); ++i)
+        {
+            hits[i].reset();
+            const auto &r = rays[i];
+            m_topLevel.traverse(r, rayT, [&](std::uint32_t chunkIndex, Interval<T> &)
+                                {
+                                    crossed.emplace_back(entryDistance(m_chunks[chunkIndex].bounds, r, rayT), chunkIndex);
+                                    return false;
+                                });
+            std::sort(crossed.begin() + static_cast<std::ptrdiff_t>(first.back()), crossed.end());
+            first.push_back(crossed.size());
+        }
+        next.assign(first.begin(), first.end() - 1);
+        closest.assign(rays.size(), rayT.max());
+
+        // Every round queues each ray on the nearest chunk it has not searched yet, and a ray is
+        // done once its closest hit lies before the next chunk. Rays thus search the chunks a
+        // one-by-one traversal would, while every round maps each chunk once for all its rays.
+        thread_local std::vector<std::vector<std::uint32_t>> queues;
+        thread_local std::vector<std::uint32_t> active;
+        thread_local std::vector<std::uint32_t> reached;
+        thread_local std::vector<std::pair<bool, std::uint32_t>> order;
+        queues.resize(m_chunks.size());
+        active.clear();
+        for (std::size_t i = 0; i < rays.size(); ++i)
+        {
+            if (next[i] < first[i + 1])
+            {
+                active.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+
+        std::uint64_t queued = 0;
+        std::uint64_t batches = 0;
+        while (!active.empty())
+        {
+            reached.clear();
+            for (const auto i : active)
+            {
+                const auto chunkIndex = crossed[next[i]++].second;
+                if (queues[chunkIndex].empty())
+                {
+                    reached.push_back(chunkIndex);
+                }
+                queues[chunkIndex].push_back(i);
+            }
+            queued += active.size();
+            batches += reached.size();
+
+            // Chunks already mapped first, they cost nothing; then the rest, longest queue first
+            order.clear();
+            {
+                const std::scoped_lock lock(m_mutex);
+                for (const auto chunkIndex : reached)
+                {
+                    order.emplace_back(!m_resident.contains(chunkIndex), chunkIndex);
+                }
+            }
+            std::stable_sort(order.begin(), order.end(), [&](const auto &a, const auto &b)
+                             { return (a.first != b.first) ? !a.first : queues[a.second].size() > queues[b.second].size(); });
+
+            for (const auto &[missing, chunkIndex] : order)
+            {
+                const auto chunk = acquire(chunkIndex);
+                auto &queue = queues[chunkIndex];
+                for (const auto i : queue)
+                {
+                    const auto &r = rays[i];
+                    chunk->tree.traverse(r, Interval<T>(rayT.min(), closest[i]), [&](std::uint32_t sphere, Interval<T> &sphereInterval)
+                                         {
+                                             T t;
+                                             if (!intersectSphere(chunk->spheres[sphere], r, sphereInterval, t))
+                                             {
+                                                 return false;
+                                             }
+                                             sphereInterval = Interval<T>(sphereInterval.min(), t);
+                                             closest[i] = t;
+                                             setAttributes(chunk->spheres[sphere], r, t, hits[i].emplace());
+                                             return true;
+                                         });
+                }
+                queue.clear();
+            }
+
+            std::erase_if(active, [&](std::uint32_t i)
+                          { return next[i] == first[i + 1] || crossed[next[i]].first >= closest[i]; });
+        }
+
+        const std::scoped_lock lock(m_mutex);
+        m_statistics.queuedRays += queued;
+        m_statistics.batches += batches;
+    }
+
+    // Every sphere has a material of the palette
+    virtual bool onlyDiffuse() const override
+    {
+        return std::all_of(m_palette.begin(), m_palette.end(), [](const auto &material)
+                           { return material->isDiffuse(); });
+    }
+
+    virtual AABB<T> boundingBox() const override
+    {
+        return m_topLevel.bounds();
+    }
+
+    virtual TextureCoordinates<T> textureCoordinates(const HitRecord<T> &record) const override
+    {
+        // Longitude and latitude as on a Sphere. The radius is gone with the chunk, so the scale
+        // is left at 0 and textures filter on their finest level.
+        const auto p = record.frontFace() ? record.normal() : -record.normal();
+        const T theta = std::acos(std::clamp(-p.y(), static_cast<T>(-1), static_cast<T>(1)));
+        const T phi = std::atan2(-p.z(), p.x()) + pi<T>;
+        return {phi / (2 * pi<T>), theta / pi<T>, 0};
+    }
+
+private:
+    // Where a chunk lies in the file and what it holds
+    struct ChunkRecord
+    {
+        AABB<T> bounds{};
+        std::uint64_t offset{0};
+        std::uint32_t firstSphere{0}; // Index of its first sphere in the whole scene
+        std::uint32_t sphereCount{0};
+        std::uint32_t nodeCount{0};
+        std::uint32_t padding{0};
+
+        std::uint64_t nodeOffset() const { return alignUp(sphereCount * sizeof(PackedSphere<T>), alignof(BVHNode<T>)); }
+        std::uint64_t indexOffset() const { return nodeOffset() + nodeCount * sizeof(BVHNode<T>); }
+        std::uint64_t bytes() const { return indexOffset() + sphereCount * sizeof(std::uint32_t); }
+    };
+
+    static_assert(std::is_trivially_copyable_v<ChunkRecord>, "The chunk table is written as raw bytes");
+
+    // A chunk mapped into memory, viewed in place
+    struct Chunk
+    {
+        std::span<const PackedSphere<T>> spheres{};
+        BVHTree<T> tree{};
+        std::size_t bytes{0};
+    };
+
+    std::string m_path;
+    std::vector<std::shared_ptr<Material<T>>> m_palette;
+    std::size_t m_budget;
+    std::vector<ChunkRecord> m_chunks{};
+    BVHTree<T> m_topLevel{};
+    bool m_batching{true};
+
+    mutable std::mutex m_mutex{};
+    mutable std::list<std::pair<std::uint32_t, std::shared_ptr<const Chunk>>> m_order{}; // Most recently used first
+    mutable std::unordered_map<std::uint32_t, typename decltype(m_order)::iterator> m_resident{};
+    mutable Statistics m_statistics{};
+
+    static constexpr std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static std::vector<AABB<T>> sphereBounds(std::span<const PackedSphere<T>> spheres)
+    {
+        std::vector<AABB<T>> bounds;
+        bounds.reserve(spheres.size());
+        for (const auto &sphere : spheres)
+        {
+            const Point3<T> center(sphere.center[0], sphere.center[1], sphere.center[2]);
+            const Vector3<T> extent(sphere.radius, sphere.radius, sphere.radius);
+            bounds.emplace_back(center - extent, center + extent);
+        }
+        return bounds;
+    }
+
+    // Sorts spheres into chunks of neighbours, as [begin, end) ranges. Spheres along a Morton
+    // curve over their centers make compact chunks; spheres much larger than a chunk, such as a
+    // ground sphere, would make the bounds of any chunk they join cover the scene and are
+    // chunked among themselves instead.
+    static std::vector<std::pair<std::uint32_t, std::uint32_t>> partition(std::vector<PackedSphere<T>> &spheres, std::size_t spheresPerChunk)
+    {
+        if (spheres.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::invalid_argument("ChunkedScene: too many spheres");
+        }
+
+        // Bounds of the centers: of all spheres to tell the large ones, then of the others for
+        // the grid of the curve
+        const auto centerBounds = [&](const auto &include)
+        {
+            std::array<T, 3> low{infinity<T>, infinity<T>, infinity<T>};
+            std::array<T, 3> high{-infinity<T>, -infinity<T>, -infinity<T>};
+            for (std::size_t i = 0; i < spheres.size(); ++i)
+            {
+                if (include(i))
+                {
+                    for (std::size_t axis = 0; axis < 3; ++axis)
+                    {
+                        low[axis] = std::min(low[axis], spheres[i].center[axis]);
+                        high[axis] = std::max(high[axis], spheres[i].center[axis]);
+                    }
+                }
+            }
+            return std::pair(low, high);
+        };
+
+        const auto [sceneLow, sceneHigh] = centerBounds([](std::size_t)
+                                                        { return true; });
+        const auto numChunks = static_cast<T>((spheres.size() + spheresPerChunk - 1) / spheresPerChunk);
+        const T chunkSize = std::max({sceneHigh[0] - sceneLow[0], sceneHigh[1] - sceneLow[1], sceneHigh[2] - sceneLow[2]}) /
+                            std::max(std::cbrt(numChunks), static_cast<T>(1));
+        const auto isLarge = [&](std::size_t i)
+        { return 2 * spheres[i].radius > chunkSize; };
+
+        const auto [low, high] = centerBounds([&](std::size_t i)
+                                              { return !isLarge(i); });
+        // Cubic cells, so that a flat scene is cut into tiles rather than layers
+        const T extent = std::max({high[0] - low[0], high[1] - low[1], high[2] - low[2]});
+        std::vector<std::uint64_t> keys(spheres.size());
+        for (std::size_t i = 0; i < spheres.size(); ++i)
+        {
+            std::array<std::uint32_t, 3> cell{};
+            for (std::size_t axis = 0; axis < 3; ++axis)
+            {
+                const T position = (extent > 0) ? (spheres[i].center[axis] - low[axis]) / extent : 0;
+                cell[axis] = static_cast<std::uint32_t>(std::clamp(position, static_cast<T>(0), static_cast<T>(1)) * 1023);
+            }
+            keys[i] = (static_cast<std::uint64_t>(isLarge(i)) << 32) | SpaceFillingCurve::mortonEncode(cell[0], cell[1], cell[2]);
+        }
+
+        std::vector<std::uint32_t> order(spheres.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = static_cast<std::uint32_t>(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+                         { return keys[a] < keys[b]; });
+
+        std::vector<PackedSphere<T>> sorted;
+        sorted.reserve(spheres.size());
+        for (const auto i : order)
+        {
+            sorted.push_back(spheres[i]);
+        }
+        spheres.swap(sorted);
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> chunks;
+        std::size_t begin = 0;
+        while (begin < spheres.size())
+        {
+            // A chunk never mixes large spheres with small ones
+            const bool large = (keys[order[begin]] >> 32) != 0;
+            std::size_t end = std::min(begin + spheresPerChunk, spheres.size());
+            if (!large)
+            {
+                const auto firstLarge = std::find_if(order.begin() + static_cast<std::ptrdiff_t>(begin), order.begin() + static_cast<std::ptrdiff_t>(end),
+                                                     [&](std::uint32_t i)
+                                                     { return (keys[i] >> 32) != 0; });
+                end = static_cast<std::size_t>(firstLarge - order.begin());
+            }
+            chunks.emplace_back(static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end));
+            begin = end;
+        }
+        return chunks;
+    }
+
+    // The mapped chunk, loaded from the file if it is not, which may evict others
+    std::shared_ptr<const Chunk> acquire(std::uint32_t chunkIndex) const
+    {
+        {
+            const std::scoped_lock lock(m_mutex);
+            if (const auto found = m_resident.find(chunkIndex); found != m_resident.end())
+            {
+                m_order.splice(m_order.begin(), m_order, found->second);
+                ++m_statistics.hits;
+                return found->second->second;
+            }
+        }
+
+        auto loaded = load(chunkIndex);
+
+        const std::scoped_lock lock(m_mutex);
+        ++m_statistics.loads;
+        m_statistics.loadedBytes += loaded->bytes;
+        if (const auto found = m_resident.find(chunkIndex); found != m_resident.end())
+        {
+            m_order.splice(m_order.begin(), m_order, found->second);
+            return found->second->second;
+        }
+
+        m_order.emplace_front(chunkIndex, loaded);
+        m_resident.emplace(chunkIndex, m_order.begin());
+        m_statistics.residentBytes += loaded->bytes;
+
+        // The new chunk stays even if it alone exceeds the budget
+        while (m_statistics.residentBytes > m_budget && m_order.size() > 1)
+        {
+            const auto &[oldIndex, oldChunk] = m_order.back();
+            m_statistics.residentBytes -= oldChunk->bytes;
+            ++m_statistics.evictions;
+            m_resident.erase(oldIndex);
+            m_order.pop_back();
+        }
+        m_statistics.peakBytes = std::max(m_statistics.peakBytes, m_statistics.residentBytes);
+        return loaded;
+    }
+
+    std::shared_ptr<const Chunk> load(std::uint32_t chunkIndex) const
+    {
+        const auto &record = m_chunks[chunkIndex];
+        auto file = std::make_shared<const MappedFile>(m_path, record.offset, record.bytes());
+        if (file->size() != record.bytes())
+        {
+            throw std::runtime_error("ChunkedScene: " + m_path + " is truncated");
+        }
+
+        // The mapping is page aligned, so the arrays are as aligned as their offsets
+        const std::span<const PackedSphere<T>> spheres(reinterpret_cast<const PackedSphere<T> *>(file->data()), record.sphereCount);
+        const std::span<const BVHNode<T>> nodes(reinterpret_cast<const BVHNode<T> *>(file->data() + record.nodeOffset()), record.nodeCount);
+        const std::span<const std::uint32_t> indices(reinterpret_cast<const std::uint32_t *>(file->data() + record.indexOffset()), record.sphereCount);
+        if (!BVHTree<T>::isValid(nodes, indices, record.sphereCount) ||
+            std::any_of(spheres.begin(), spheres.end(), [&](const PackedSphere<T> &sphere)
+                        { return sphere.material >= m_palette.size(); }))
+        {
+            throw std::runtime_error("ChunkedScene: " + m_path + " has a damaged chunk");
+        }
+
+        const auto bytes = file->size();
+        return std::make_shared<const Chunk>(Chunk{spheres, BVHTree<T>(std::move(file), nodes, indices), bytes});
+    }
+
+    // Where a ray enters a box, rayT.min() if it starts inside. Only called for boxes the ray hits.
+    static T entryDistance(const AABB<T> &box, const Ray<T> &r, const Interval<T> &rayT)
+    {
+        T entry = rayT.min();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const Interval<T> &slab = box.axisInterval(axis);
+            const T invDirection = 1 / r.direction()[axis];
+            const T t0 = (slab.min() - r.origin()[axis]) * invDirection;
+            const T t1 = (slab.max() - r.origin()[axis]) * invDirection;
+            entry = std::max(entry, std::min(t0, t1));
+        }
+        return entry;
+    }
+
+    // The same arithmetic as Sphere::intersect, so that both find the same hits
+    static bool intersectSphere(const PackedSphere<T> &sphere, const Ray<T> &r, const Interval<T> &rayT, T &t)
+    {
+        const Point3<T> center(sphere.center[0], sphere.center[1], sphere.center[2]);
+        const auto oc = center - r.origin();
+        const auto a = r.direction().squaredNorm();
+        const auto h = dot(r.direction(), oc);
+        const auto c = oc.squaredNorm() - sphere.radius * sphere.radius;
+        const auto discriminant = h * h - a * c;
+
+        if (discriminant < 0)
+        {
+            return false;
+        }
+
+        const auto sqrtD = std::sqrt(discriminant);
+        t = (h - sqrtD) / a;
+        if (!rayT.surrounds(t))
+        {
+            t = (h + sqrtD) / a;
+            if (!rayT.surrounds(t))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void setAttributes(const PackedSphere<T> &sphere, const Ray<T> &r, T t, HitRecord<T> &record) const
+    {
+        const Point3<T> center(sphere.center[0], sphere.center[1], sphere.center[2]);
+        record.setT(t);
+        record.setPoint(r.at(t));
+        record.setNormal(r, (record.point() - center) / sphere.radius);
+        record.setMaterial(m_palette[sphere.material].get());
+        record.setObject(this);
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_CHUNKED_SCENE_HPP */
@@ -8,10 +8,13 @@
 #ifndef INONEWEEKEND_INCLUDE_COLOR_HPP
 #define INONEWEEKEND_INCLUDE_COLOR_HPP
 
+#include <array>
 #include <concepts>
+#include <cstdint>
 #include <iostream>
 #include <limits>
 
+#include "fast_math.hpp"
 #include "vector3.hpp"
 #include "interval.hpp"
 
@@ -34,13 +37,13 @@ using ColorF = Color<float>;
 template <std::floating_point T>
 inline constexpr T linearToGamma(T value, T gamma)
 {
-    return value > 0 ? std::pow(value, static_cast<T>(1.0) / gamma) : 0;
+    return value > 0 ? FastMath::pow(value, static_cast<T>(1.0) / gamma) : 0;
 }
 
 template <std::floating_point T>
 inline constexpr T gammaToLinear(T value, T gamma)
 {
-    return value > 0 ? std::pow(value, gamma) : 0;
+    return value > 0 ? FastMath::pow(value, gamma) : 0;
 }
 
 template <std::floating_point T>
@@ -60,7 +63,7 @@ inline constexpr Color<T> gammaToLinear(const Color<T> &color, T gamma)
 }
 
 template <std::floating_point T>
-inline void writeColor(std::ostream &out, const Color<T> &pixelColor)
+inline std::array<std::uint8_t, 3> toBytes(const Color<T> &pixelColor)
 {
     // Transform into Gamma Space with gamma = 2.2
     const auto color = linearToGamma(pixelColor, static_cast<T>(2.2));
@@ -70,13 +73,17 @@ inline void writeColor(std::ostream &out, const Color<T> &pixelColor)
     constexpr T almostOne = static_cast<T>(0.999);
     constexpr Interval<T> intensity(zero, almostOne);
 
-    // Write the translated [0,255] value of each color component
-    const auto rByte = static_cast<int>(256 * intensity.clamp(color.r()));
-    const auto gByte = static_cast<int>(256 * intensity.clamp(color.g()));
-    const auto bByte = static_cast<int>(256 * intensity.clamp(color.b()));
+    return {static_cast<std::uint8_t>(256 * intensity.clamp(color.r())),
+            static_cast<std::uint8_t>(256 * intensity.clamp(color.g())),
+            static_cast<std::uint8_t>(256 * intensity.clamp(color.b()))};
+}
 
+template <std::floating_point T>
+inline void writeColor(std::ostream &out, const Color<T> &pixelColor)
+{
     // Write the translated [0,255] value of each color component
-    out << rByte << ' ' << gByte << ' ' << bByte << '\n';
+    const auto bytes = toBytes(pixelColor);
+    out << static_cast<int>(bytes[0]) << ' ' << static_cast<int>(bytes[1]) << ' ' << static_cast<int>(bytes[2]) << '\n';
 }
 
 #endif /* INONEWEEKEND_SRC_COLOR_HPP */
@@ -0,0 +1,235 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_ENVIRONMENT_MAP_HPP
+#define INONEWEEKEND_INCLUDE_ENVIRONMENT_MAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "alias_table.hpp"
+#include "color.hpp"
+#include "util.hpp"
+#include "vector3.hpp"
+
+// Radiance arriving from infinitely far away, as a latitude-longitude image: rows go from the
+// top (+y) to the bottom (-y) and columns once around the y axis, starting at -x.
+//
+// Directions are importance sampled in constant time: an alias table picks a texel with
+// probability proportional to its luminance times the solid angle it covers, and the direction
+// is then uniform within the texel. A small bright sun is found by nearly every light sample
+// instead of by the few scattered rays that happen to hit it.
+template <std::floating_point T = double>
+class EnvironmentMap
+{
+public:
+    // How light sampling draws directions, uniform over the sphere only for comparison
+    enum class Strategy
+    {
+        Importance,
+        Uniform
+    };
+
+    EnvironmentMap(int width, int height, std::vector<Color<T>> texels, Strategy strategy = Strategy::Importance)
+        : m_width(width), m_height(height), m_texels(std::move(texels)), m_strategy(strategy)
+    {
+        if (m_width < 1 || m_height < 1 || m_texels.size() != static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_height))
+        {
+            throw std::invalid_argument("EnvironmentMap: texels do not match the size");
+        }
+
+        std::vector<T> weights(m_texels.size());
+        for (int row = 0; row < m_height; ++row)
+        {
+            const T sinTheta = std::sin(pi<T> * (static_cast<T>(row) + static_cast<T>(0.5)) / static_cast<T>(m_height));
+            for (int column = 0; column < m_width; ++column)
+            {
+                const auto index = texelIndex(row, column);
+                weights[index] = luminance(m_texels[index]) * sinTheta;
+            }
+        }
+        m_table.build(weights);
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    Strategy strategy() const { return m_strategy; }
+
+    Color<T> radiance(const Vector3<T> &direction) const
+    {
+        const auto [row, column] = texel(unitVector(direction));
+        return m_texels[texelIndex(row, column)];
+    }
+
+    // Draws a unit direction from three uniform numbers in [0, 1)
+    Vector3<T> sample(T u, T v, T w) const
+    {
+        if (m_strategy == Strategy::Uniform)
+        {
+            const T z = 1 - 2 * v;
+            const T r = std::sqrt(std::max(static_cast<T>(0), 1 - z * z));
+            const T phi = 2 * pi<T> * w;
+            return Vector3<T>(r * std::cos(phi), z, r * std::sin(phi));
+        }
+
+        const auto index = m_table.sample(u);
+        const auto row = static_cast<T>(index / static_cast<std::size_t>(m_width));
+        const auto column = static_cast<T>(index % static_cast<std::size_t>(m_width));
+        return direction((row + v) / static_cast<T>(m_height), (column + w) / static_cast<T>(m_width));
+    }
+
+    // Solid angle density with which sample() draws direction
+    T pdf(const Vector3<T> &direction) const
+    {
+        if (m_strategy == Strategy::Uniform)
+        {
+            return 1 / (4 * pi<T>);
+        }
+
+        const auto unit = unitVector(direction);
+        const T sinTheta = std::sqrt(std::max(static_cast<T>(0), 1 - unit.y() * unit.y()));
+        if (sinTheta <= 0)
+        {
+            return 0;
+        }
+
+        // Uniform over a texel in (theta, phi), which covers 2 pi^2 sin(theta) / (width * height)
+        const auto [row, column] = texel(unit);
+        const auto numTexels = static_cast<T>(m_width) * static_cast<T>(m_height);
+        return m_table.pmf(texelIndex(row, column)) * numTexels / (2 * pi<T> * pi<T> * sinTheta);
+    }
+
+    // Reads a Portable Float Map, color ("PF") with 32-bit floats. Its rows are stored from the
+    // bottom up, in the byte order given by the sign of the scale.
+    static EnvironmentMap loadPFM(const std::string &path, Strategy strategy = Strategy::Importance)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("EnvironmentMap: cannot open " + path);
+        }
+
+        std::string magic;
+        int width = 0;
+        int height = 0;
+        double scale = 0;
+        if (!(in >> magic >> width >> height >> scale) || magic != "PF" || width < 1 || height < 1 || scale == 0)
+        {
+            throw std::runtime_error("EnvironmentMap: " + path + " is not a color PFM image");
+        }
+        in.get(); // The single whitespace before the data
+
+        const bool littleEndian = scale < 0;
+        std::vector<Color<T>> texels(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+        std::vector<char> row(12 * static_cast<std::size_t>(width));
+        for (int y = height - 1; y >= 0; --y)
+        {
+            if (!in.read(row.data(), static_cast<std::streamsize>(row.size())))
+            {
+                throw std::runtime_error("EnvironmentMap: " + path + " is truncated");
+            }
+            for (int x = 0; x < width; ++x)
+            {
+                std::array<T, 3> channels{};
+                for (std::size_t c = 0; c < 3; ++c)
+                {
+                    std::uint32_t bits;
+                    std::memcpy(&bits, row.data() + 12 * static_cast<std::size_t>(x) + 4 * c, sizeof(bits));
+                    if (littleEndian != (std::endian::native == std::endian::little))
+                    {
+                        bits = byteSwap(bits);
+                    }
+                    const auto value = static_cast<T>(std::bit_cast<float>(bits));
+                    channels[c] = std::isfinite(value) ? std::max(value, static_cast<T>(0)) : 0;
+                }
+                texels[static_cast<std::size_t>(y) * static_cast<std::size_t>(width) + static_cast<std::size_t>(x)] =
+                    Color<T>(channels[0], channels[1], channels[2]);
+            }
+        }
+        return EnvironmentMap(width, height, std::move(texels), strategy);
+    }
+
+    // Writes a little-endian color Portable Float Map
+    static void savePFM(const std::string &path, int width, int height, const std::vector<Color<T>> &texels)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "PF\n" << width << ' ' << height << "\n-1.0\n";
+        for (int y = height - 1; y >= 0; --y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const auto &texel = texels[static_cast<std::size_t>(y) * static_cast<std::size_t>(width) + static_cast<std::size_t>(x)];
+                for (const T channel : {texel.r(), texel.g(), texel.b()})
+                {
+                    auto bits = std::bit_cast<std::uint32_t>(static_cast<float>(channel));
+                    if constexpr (std::endian::native != std::endian::little)
+                    {
+                        bits = byteSwap(bits);
+                    }
+                    out.write(reinterpret_cast<const char *>(&bits), sizeof(bits));
+                }
+            }
+        }
+        if (!out.flush())
+        {
+            throw std::runtime_error("EnvironmentMap: cannot write " + path);
+        }
+    }
+
+    // Unit direction through a point of the image, in fractions of its height and width
+    static Vector3<T> direction(T rowFraction, T columnFraction)
+    {
+        const T theta = pi<T> * rowFraction;
+        const T phi = 2 * pi<T> * columnFraction - pi<T>;
+        const T sinTheta = std::sin(theta);
+        return Vector3<T>(sinTheta * std::cos(phi), std::cos(theta), sinTheta * std::sin(phi));
+    }
+
+private:
+    int m_width;
+    int m_height;
+    std::vector<Color<T>> m_texels; // Row by row, from the top
+    Strategy m_strategy;
+    AliasTable<T> m_table{};
+
+    static T luminance(const Color<T> &color)
+    {
+        return static_cast<T>(0.2126) * color.r() + static_cast<T>(0.7152) * color.g() + static_cast<T>(0.0722) * color.b();
+    }
+
+    static std::uint32_t byteSwap(std::uint32_t bits)
+    {
+        return (bits >> 24) | ((bits >> 8) & 0xFF00u) | ((bits << 8) & 0xFF0000u) | (bits << 24);
+    }
+
+    std::size_t texelIndex(int row, int column) const
+    {
+        return static_cast<std::size_t>(row) * static_cast<std::size_t>(m_width) + static_cast<std::size_t>(column);
+    }
+
+    std::pair<int, int> texel(const Vector3<T> &unit) const
+    {
+        const T theta = std::acos(std::clamp(unit.y(), static_cast<T>(-1), static_cast<T>(1)));
+        const T phi = std::atan2(unit.z(), unit.x()) + pi<T>;
+        const int row = std::min(static_cast<int>(theta / pi<T> * static_cast<T>(m_height)), m_height - 1);
+        const int column = std::min(static_cast<int>(phi / (2 * pi<T>) * static_cast<T>(m_width)), m_width - 1);
+        return {std::max(row, 0), std::max(column, 0)};
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_ENVIRONMENT_MAP_HPP */
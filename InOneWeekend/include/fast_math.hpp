@@ -0,0 +1,143 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_FAST_MATH_HPP
+#define INONEWEEKEND_INCLUDE_FAST_MATH_HPP
+
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+// Set by the RAYTRACER_FAST_MATH CMake option
+#ifndef RAYTRACER_FAST_MATH
+#define RAYTRACER_FAST_MATH 0
+#endif
+
+// Quality tiers of the math in the shading code: vector normalization, Fresnel and gamma. The
+// precise tier, the default, calls libm and gives the reference images. The fast tier, chosen
+// at compile time, swaps in approximations good to about float precision, far below what an
+// 8-bit pixel shows; `RayTracerBenchmark --check-image <precise reference> --tolerance <rmse>`
+// holds a fast build to an error budget. Divisions stay exact in both tiers, since the pdf
+// ratios and MIS weights they form compound over every bounce of a path.
+//
+// The approximations are compiled in both tiers, so that their error and speed can be measured
+// against libm in one binary (`RayTracerBenchmark --fast-math`).
+namespace FastMath
+{
+    inline constexpr bool s_enabled = RAYTRACER_FAST_MATH != 0;
+
+    inline constexpr const char *tierName()
+    {
+        return s_enabled ? "fast" : "precise";
+    }
+
+    // 1 / sqrt(x) for positive normal floats x: the hardware estimate, or an integer guess from
+    // the bit pattern without SSE, refined by Newton steps to a relative error below 5e-7
+    template <std::floating_point T>
+    inline T approxRsqrt(T x)
+    {
+#if defined(__SSE__)
+        const T y = static_cast<T>(_mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(static_cast<float>(x)))));
+        return y * (static_cast<T>(1.5) - static_cast<T>(0.5) * x * y * y);
+#else
+        const auto bits = std::bit_cast<std::uint32_t>(static_cast<float>(x));
+        T y = static_cast<T>(std::bit_cast<float>(0x5F375A86u - (bits >> 1)));
+        y *= static_cast<T>(1.5) - static_cast<T>(0.5) * x * y * y;
+        y *= static_cast<T>(1.5) - static_cast<T>(0.5) * x * y * y;
+        return y * (static_cast<T>(1.5) - static_cast<T>(0.5) * x * y * y);
+#endif
+    }
+
+    // log2 of a positive normal float: exponent bits plus a degree 5 fit of log2 on the
+    // mantissa, absolute error below 2e-5. Like approxExp2 it moves between integers and floats
+    // through the bit pattern only, since GCC does not if-convert loops that mix selects with
+    // conversion instructions (ToneMapper's transfer functions rely on this to vectorize).
+    inline float approxLog2(float x)
+    {
+        const auto bits = std::bit_cast<std::int32_t>(x);
+        const float exponent = std::bit_cast<float>(((bits >> 23) & 0xFF) | 0x4B000000) - (8388608.0f + 127.0f);
+        const float t = std::bit_cast<float>((bits & 0x007FFFFF) | 0x3F800000) - 1;
+        return exponent + t * (1.4418799f + t * (-0.70886522f + t * (0.41524556f + t * (-0.19351653f + t * 0.045268294f))));
+    }
+
+    // 2^y for -126 < y < 128: integer part into the exponent bits, a degree 4 fit of 2^f on the
+    // fraction, relative error below 5e-6
+    inline float approxExp2(float y)
+    {
+        // Adding 1.5 * 2^23 rounds to an integer that can be read from the low mantissa bits,
+        // which avoids a float to int conversion. Rounding y - 0.5 gives floor(y) except at
+        // ties, where the fraction becomes one, still inside the fitted range.
+        constexpr float magic = 12582912.0f;
+        const float shifted = (y - 0.5f) + magic;
+        const std::int32_t whole = std::bit_cast<std::int32_t>(shifted) - std::bit_cast<std::int32_t>(magic);
+        const float f = y - (shifted - magic);
+        const float p = 1 + f * (0.69301751f + f * (0.24144866f + f * (0.051947953f + f * 0.013581664f)));
+        return std::bit_cast<float>(std::bit_cast<std::int32_t>(p) + whole * (1 << 23));
+    }
+
+    // x^y for x > 0, relative error about 1e-4 for the exponents of gamma curves. Values too
+    // small for a normal float give 0.
+    template <std::floating_point T>
+    inline T approxPow(T x, T y)
+    {
+        if (!(x > static_cast<T>(1e-30)))
+        {
+            return 0;
+        }
+        const float exponent = static_cast<float>(y) * approxLog2(static_cast<float>(x));
+        return static_cast<T>(approxExp2(std::fmin(std::fmax(exponent, -125.0f), 127.0f)));
+    }
+
+    // What the shading code calls: libm in the precise tier, the approximations in the fast one
+
+    template <std::floating_point T>
+    inline T pow5(T x)
+    {
+        if constexpr (s_enabled)
+        {
+            const T x2 = x * x;
+            return x2 * x2 * x;
+        }
+        else
+        {
+            return std::pow(x, 5);
+        }
+    }
+
+    template <std::floating_point T>
+    inline T inverseSqrt(T x)
+    {
+        if constexpr (s_enabled)
+        {
+            return approxRsqrt(x);
+        }
+        else
+        {
+            return 1 / std::sqrt(x);
+        }
+    }
+
+    template <std::floating_point T>
+    inline T pow(T x, T y)
+    {
+        if constexpr (s_enabled)
+        {
+            return approxPow(x, y);
+        }
+        else
+        {
+            return std::pow(x, y);
+        }
+    }
+}
+
+#endif /* INONEWEEKEND_INCLUDE_FAST_MATH_HPP */
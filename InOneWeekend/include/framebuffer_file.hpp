@@ -0,0 +1,205 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_FRAMEBUFFER_FILE_HPP
+#define INONEWEEKEND_INCLUDE_FRAMEBUFFER_FILE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "color.hpp"
+#include "tone_mapper.hpp"
+
+// Image file that a render writes into band by band, for images too large to be held in
+// memory (see Camera::renderBands). The file is allocated at its full size up front, so a full
+// disk fails before the render rather than in the middle of it. Each band of finished rows is
+// mapped, converted straight into the file and unmapped again, so the process never holds more
+// than one band of it.
+//
+// Written under a temporary name and renamed by finish(), so an interrupted render leaves no
+// image that looks complete.
+template <std::floating_point T = double>
+class FramebufferFile
+{
+public:
+    enum class Format
+    {
+        BinaryPPM, // P6, three tone mapped bytes per pixel, rows from the top
+        PFM,       // Little-endian color Portable Float Map of the radiance, rows from the bottom
+    };
+
+    FramebufferFile(std::string path, int width, int height, Format format, const ToneMapper &toneMapper = ToneMapper())
+        : m_path(std::move(path)), m_temporaryPath(m_path + ".tmp" + std::to_string(::getpid())),
+          m_width(width), m_height(height), m_format(format), m_toneMapper(toneMapper)
+    {
+        if (m_width < 1 || m_height < 1)
+        {
+            throw std::invalid_argument("FramebufferFile: empty image");
+        }
+
+        const std::string header = (m_format == Format::PFM ? "PF\n" : "P6\n") + std::to_string(m_width) + ' ' +
+                                   std::to_string(m_height) + (m_format == Format::PFM ? "\n-1.0\n" : "\n255\n");
+        m_headerBytes = header.size();
+        m_rowBytes = static_cast<std::size_t>(m_width) * ((m_format == Format::PFM) ? 12 : 3);
+        m_fileBytes = m_headerBytes + m_rowBytes * static_cast<std::size_t>(m_height);
+
+        m_fd = ::open(m_temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("FramebufferFile: cannot create " + m_temporaryPath);
+        }
+        if (::posix_fallocate(m_fd, 0, static_cast<off_t>(m_fileBytes)) != 0 ||
+            ::pwrite(m_fd, header.data(), header.size(), 0) != static_cast<ssize_t>(header.size()))
+        {
+            discard();
+            throw std::runtime_error("FramebufferFile: cannot allocate " + std::to_string(m_fileBytes) + " bytes for " + m_path);
+        }
+    }
+
+    ~FramebufferFile()
+    {
+        discard();
+    }
+
+    FramebufferFile(const FramebufferFile &) = delete;
+    FramebufferFile &operator=(const FramebufferFile &) = delete;
+
+    const std::string &path() const { return m_path; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    Format format() const { return m_format; }
+    std::size_t fileBytes() const { return m_fileBytes; }
+
+    // Largest part of the file mapped at once
+    std::size_t peakMappedBytes() const { return m_peakMappedBytes; }
+
+    // Writes whole rows, starting at row firstRow counted from the top, from row-major pixels
+    void writeRows(int firstRow, std::span<const Color<T>> pixels)
+    {
+        const auto width = static_cast<std::size_t>(m_width);
+        const auto numRows = pixels.size() / width;
+        if (m_fd < 0 || pixels.size() % width != 0 || firstRow < 0 ||
+            static_cast<std::size_t>(firstRow) + numRows > static_cast<std::size_t>(m_height))
+        {
+            throw std::invalid_argument("FramebufferFile: rows outside the image");
+        }
+        if (numRows == 0)
+        {
+            return;
+        }
+
+        // The rows are contiguous in the file in either order. The mapping starts at the page
+        // they begin in.
+        const auto first = static_cast<std::size_t>(firstRow);
+        const auto firstFileRow = (m_format == Format::PFM) ? static_cast<std::size_t>(m_height) - first - numRows : first;
+        const std::size_t begin = m_headerBytes + firstFileRow * m_rowBytes;
+        const auto pageBytes = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t mapBegin = begin - begin % pageBytes;
+        const std::size_t mapBytes = begin + numRows * m_rowBytes - mapBegin;
+
+        void *mapping = ::mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, static_cast<off_t>(mapBegin));
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("FramebufferFile: cannot map rows of " + m_temporaryPath);
+        }
+        m_peakMappedBytes = std::max(m_peakMappedBytes, mapBytes);
+
+        auto *rows = static_cast<std::uint8_t *>(mapping) + (begin - mapBegin);
+        for (std::size_t row = 0; row < numRows; ++row)
+        {
+            const Color<T> *source = pixels.data() + row * width;
+            const auto fileRow = (m_format == Format::PFM) ? numRows - 1 - row : row;
+            auto *out = rows + fileRow * m_rowBytes;
+            if (m_format == Format::PFM)
+            {
+                writeFloats(source, out);
+            }
+            else
+            {
+                m_toneMapper.mapRow(source, width, first + row, out);
+            }
+        }
+
+        ::munmap(mapping, mapBytes);
+    }
+
+    // Flushes the file and gives it its final name. Rows never written stay black.
+    void finish()
+    {
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("FramebufferFile: finished twice");
+        }
+
+        const bool synced = ::fsync(m_fd) == 0;
+        ::close(m_fd);
+        m_fd = -1;
+        if (!synced)
+        {
+            std::filesystem::remove(m_temporaryPath);
+            throw std::runtime_error("FramebufferFile: cannot write " + m_temporaryPath);
+        }
+        std::filesystem::rename(m_temporaryPath, m_path);
+    }
+
+private:
+    std::string m_path;
+    std::string m_temporaryPath;
+    int m_width;
+    int m_height;
+    Format m_format;
+    ToneMapper m_toneMapper;
+    int m_fd{-1};
+    std::size_t m_headerBytes{0};
+    std::size_t m_rowBytes{0};
+    std::size_t m_fileBytes{0};
+    std::size_t m_peakMappedBytes{0};
+
+    // Closes and removes the file if it was not finished
+    void discard()
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+            std::error_code error;
+            std::filesystem::remove(m_temporaryPath, error);
+        }
+    }
+
+    void writeFloats(const Color<T> *pixels, std::uint8_t *out) const
+    {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(m_width); ++i)
+        {
+            for (const T channel : {pixels[i].r(), pixels[i].g(), pixels[i].b()})
+            {
+                auto bits = std::bit_cast<std::uint32_t>(static_cast<float>(channel));
+                if constexpr (std::endian::native != std::endian::little)
+                {
+                    bits = (bits >> 24) | ((bits >> 8) & 0xFF00u) | ((bits << 8) & 0xFF0000u) | (bits << 24);
+                }
+                std::memcpy(out, &bits, sizeof(bits));
+                out += sizeof(bits);
+            }
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_FRAMEBUFFER_FILE_HPP */
@@ -9,13 +9,41 @@
 #define INONEWEEKEND_INCLUDE_HITTABLE_HPP
 
 #include <concepts>
-#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
 
+#include "aabb.hpp"
 #include "ray.hpp"
 #include "interval.hpp"
 #include "material_forward_decl.hpp"
 #include "vector3.hpp"
 
+template <std::floating_point T>
+class Hittable;
+
+// First phase of a closest-hit query: how far along the ray, and which primitive. Traversal
+// only carries this much from candidate to candidate; see Hittable::hit.
+template <std::floating_point T = double>
+struct SurfaceHit
+{
+    T t{0};
+    const Hittable<T> *object{nullptr}; // Primitive that computes the shading attributes
+    std::uint32_t primitive{0};         // Part of that object that was hit, e.g. a mesh triangle
+};
+
+// Where a hit lies in its object's texture: (u, v) in [0, 1]^2, and how fast they change along
+// the surface, in texture units per unit of distance, for choosing the level of detail
+template <std::floating_point T = double>
+struct TextureCoordinates
+{
+    T u{0};
+    T v{0};
+    T scale{0};
+};
+
+// Shading attributes of the closest hit, computed once per query for the winning primitive
 template <std::floating_point T = double>
 class HitRecord
 {
@@ -25,18 +53,26 @@ public:
     constexpr HitRecord(
         const Point3<T> &point,
         const Vector3<T> &normal,
-        std::shared_ptr<Material<T>> material,
+        const Material<T> *material,
         T t,
         bool frontFace)
-        : m_point(point), m_normal(normal), m_material(material), m_t(t), m_frontFace(frontFace)
+        : m_point(point), m_normal(normal), m_material(material), m_object(nullptr), m_t(t), m_frontFace(frontFace), m_rayWidth(0)
     {
     }
 
+    constexpr HitRecord(const HitRecord &) = default;
+    constexpr HitRecord(HitRecord &&) = default;
+    constexpr HitRecord &operator=(const HitRecord &) = default;
+    constexpr HitRecord &operator=(HitRecord &&) = default;
+    ~HitRecord() = default;
+
     constexpr const Point3<T> &point() const { return m_point; }
     constexpr const Vector3<T> &normal() const { return m_normal; }
-    constexpr std::shared_ptr<Material<T>> material() const { return m_material; }
+    constexpr const Material<T> *material() const { return m_material; }
+    constexpr const Hittable<T> *object() const { return m_object; }
     constexpr T t() const { return m_t; }
     constexpr bool frontFace() const { return m_frontFace; }
+    constexpr T rayWidth() const { return m_rayWidth; }
 
     void setPoint(const Point3<T> &p) { m_point = p; }
     void setNormal(const Ray<T> &r, const Vector3<T> &outwardNormal)
@@ -45,15 +81,19 @@ public:
         m_frontFace = dot(r.direction(), outwardNormal) < 0;
         m_normal = m_frontFace ? outwardNormal : -outwardNormal;
     }
-    void setMaterial(std::shared_ptr<Material<T>> material) { m_material = material; }
+    void setMaterial(const Material<T> *material) { m_material = material; }
+    void setObject(const Hittable<T> *object) { m_object = object; }
     void setT(T t) { m_t = t; }
+    void setRayWidth(T width) { m_rayWidth = width; }
 
 private:
     Point3<T> m_point;
     Vector3<T> m_normal;
-    std::shared_ptr<Material<T>> m_material;
+    const Material<T> *m_material; // Owned by the object that was hit
+    const Hittable<T> *m_object; // Primitive that was hit, identifies lights for sampling
     T m_t;
     bool m_frontFace;
+    T m_rayWidth; // Width of the ray's footprint at the hit, set by the camera for texture filtering
 };
 
 template <std::floating_point T = double>
@@ -61,10 +101,96 @@ class Hittable
 {
 public:
     virtual ~Hittable() = default;
-    virtual bool hit(
+
+    // Closest hit within rayT, in two phases: intersect() narrows the interval down to the
+    // nearest primitive, and only that primitive then computes point, normal and material
+    bool hit(
         const Ray<T> &r,
         Interval<T> rayT,
-        HitRecord<T> &record) const = 0;
+        HitRecord<T> &record) const
+    {
+        SurfaceHit<T> surface;
+        if (!intersect(r, rayT, surface))
+        {
+            return false;
+        }
+        surface.object->surfaceAttributes(r, surface, record);
+        return true;
+    }
+
+    // Closest intersection within rayT. Sets surface and returns true on a hit, leaves surface
+    // alone otherwise, so aggregates can pass the same one to each of their children.
+    virtual bool intersect(
+        const Ray<T> &r,
+        Interval<T> rayT,
+        SurfaceHit<T> &surface) const = 0;
+
+    // Shading attributes of a hit that intersect() reported on this object. Only primitives
+    // name themselves in a SurfaceHit, so aggregates need not implement this.
+    virtual void surfaceAttributes(
+        [[maybe_unused]] const Ray<T> &r,
+        [[maybe_unused]] const SurfaceHit<T> &surface,
+        [[maybe_unused]] HitRecord<T> &record) const
+    {
+    }
+
+    // Any-hit query for shadow and visibility rays: true if anything intersects the ray within
+    // rayT. Implementations return on the first intersection found and skip shading attributes.
+    virtual bool occluded(
+        const Ray<T> &r,
+        Interval<T> rayT) const = 0;
+
+    // Closest hits of many rays within the same rayT, hits[i] for rays[i] and empty on a miss.
+    // Worlds that gain from seeing the rays together, such as a ChunkedScene that loads each of
+    // its chunks once for all the rays reaching it, override this and prefersBatches().
+    virtual void hitBatch(
+        std::span<const Ray<T>> rays,
+        Interval<T> rayT,
+        std::span<std::optional<HitRecord<T>>> hits) const
+    {
+        for (std::size_t i = 0; i < rays.size(); ++i)
+        {
+            HitRecord<T> record;
+            if (hit(rays[i], rayT, record))
+            {
+                hits[i] = record;
+            }
+            else
+            {
+                hits[i].reset();
+            }
+        }
+    }
+
+    // True if the camera should trace a bounce of many paths with one hitBatch call
+    virtual bool prefersBatches() const { return false; }
+
+    // True if every surface has a diffuse material (Material::isDiffuse), so that the camera
+    // can trace the scene with a kernel that skips emission and specular bounces. Objects that
+    // cannot tell say false.
+    virtual bool onlyDiffuse() const { return false; }
+
+    virtual AABB<T> boundingBox() const = 0;
+
+    // Texture coordinates of a hit on this object. Only asked for by textured materials, so
+    // untextured renders never pay for them. Objects without a parameterization map every point
+    // to (0, 0).
+    virtual TextureCoordinates<T> textureCoordinates([[maybe_unused]] const HitRecord<T> &record) const
+    {
+        return {};
+    }
+
+    // Light sampling interface. Hittables that can act as lights return the solid angle density
+    // of sampling the given direction from origin, and draw directions with that density.
+    virtual T pdfValue([[maybe_unused]] const Point3<T> &origin, [[maybe_unused]] const Vector3<T> &direction) const
+    {
+        return 0;
+    }
+
+    virtual Vector3<T> sampleDirection([[maybe_unused]] const Point3<T> &origin) const
+    {
+        return Vector3<T>(1, 0, 0);
+    }
 
 private:
 };
@@ -8,10 +8,12 @@
 #ifndef INONEWEEKEND_INCLUDE_HITTABLE_LIST_HPP
 #define INONEWEEKEND_INCLUDE_HITTABLE_LIST_HPP
 
+#include <algorithm>
 #include <vector>
 #include <concepts>
 #include <memory>
 
+#include "aabb.hpp"
 #include "hittable.hpp"
 #include "interval.hpp"
 
@@ -19,10 +21,17 @@ template <std::floating_point T = double>
 class HittableList : public Hittable<T>
 {
 public:
-    HittableList() : m_objects() {}
+    HittableList() : m_objects(), m_bbox() {}
     HittableList(const std::vector<std::shared_ptr<Hittable<T>>> &objects)
-        : m_objects(objects) {}
+        : m_objects(), m_bbox()
+    {
+        for (const auto &object : objects)
+        {
+            add(object);
+        }
+    }
     HittableList(std::shared_ptr<Hittable<T>> object)
+        : m_objects(), m_bbox()
     {
         add(object);
     }
@@ -30,37 +39,66 @@ public:
     void add(std::shared_ptr<Hittable<T>> object)
     {
         m_objects.push_back(object);
+        m_bbox = AABB<T>(m_bbox, object->boundingBox());
     }
 
     void clear()
     {
         m_objects.clear();
+        m_bbox = AABB<T>();
     }
 
-    virtual bool hit(
+    const std::vector<std::shared_ptr<Hittable<T>>> &objects() const { return m_objects; }
+
+    virtual bool intersect(
         const Ray<T> &r,
         Interval<T> rayT,
-        HitRecord<T> &record) const override
+        SurfaceHit<T> &surface) const override
     {
-        HitRecord<T> tempRecord;
         bool hitAnything = false;
         T closestSoFar = rayT.max();
 
         for (const auto &object : m_objects)
         {
-            if (object->hit(r, Interval<T>(rayT.min(), closestSoFar), tempRecord))
+            if (object->intersect(r, Interval<T>(rayT.min(), closestSoFar), surface))
             {
                 hitAnything = true;
-                closestSoFar = tempRecord.t();
-                record = tempRecord;
+                closestSoFar = surface.t;
             }
         }
 
         return hitAnything;
     }
 
+    virtual bool occluded(
+        const Ray<T> &r,
+        Interval<T> rayT) const override
+    {
+        for (const auto &object : m_objects)
+        {
+            if (object->occluded(r, rayT))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    virtual bool onlyDiffuse() const override
+    {
+        return std::all_of(m_objects.begin(), m_objects.end(), [](const auto &object)
+                           { return object->onlyDiffuse(); });
+    }
+
+    virtual AABB<T> boundingBox() const override
+    {
+        return m_bbox;
+    }
+
 private:
     std::vector<std::shared_ptr<Hittable<T>>> m_objects;
+    AABB<T> m_bbox;
 };
 
 #endif /* INONEWEEKEND_INCLUDE_HITTABLE_LIST_HPP */
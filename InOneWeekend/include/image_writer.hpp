@@ -0,0 +1,197 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_IMAGE_WRITER_HPP
+#define INONEWEEKEND_INCLUDE_IMAGE_WRITER_HPP
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bounded_queue.hpp"
+#include "color.hpp"
+#include "thread_pool.hpp"
+#include "tone_mapper.hpp"
+
+// Output stage of the renderer. Frames are handed over through a bounded queue to a thread of
+// their own, which converts them to display values, encodes and writes them while the render
+// threads carry on with the next frame.
+template <std::floating_point T = double>
+class ImageWriter
+{
+public:
+    enum class Format
+    {
+        PlainPPM,  // P3, one text line per pixel
+        BinaryPPM, // P6, three bytes per pixel
+    };
+
+    // A finished render in linear radiance, row-major
+    struct Frame
+    {
+        std::string path{}; // Written to standard output if empty
+        int width{0};
+        int height{0};
+        std::vector<Color<T>> pixels{};
+        Format format{Format::PlainPPM};
+        ToneMapper toneMapper{}; // Conversion to display values
+    };
+
+    // At most queueCapacity frames wait for encoding before submit() blocks
+    explicit ImageWriter(std::size_t queueCapacity = 2)
+        : m_queue(queueCapacity), m_thread([this]
+                                           { run(); })
+    {
+    }
+
+    ~ImageWriter()
+    {
+        // Frames still queued are written before the thread is joined
+        m_queue.close();
+    }
+
+    ImageWriter(const ImageWriter &) = delete;
+    ImageWriter &operator=(const ImageWriter &) = delete;
+
+    // Queues a frame and returns as soon as there is room for it
+    void submit(Frame frame)
+    {
+        if (!m_queue.push(std::move(frame)))
+        {
+            throw std::runtime_error("ImageWriter: submit after finish");
+        }
+    }
+
+    // Writes all queued frames and stops the output thread. Throws if a frame could not be
+    // written.
+    void finish()
+    {
+        m_queue.close();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+        std::lock_guard lock(m_mutex);
+        if (!m_error.empty())
+        {
+            throw std::runtime_error(m_error);
+        }
+    }
+
+    // Time the output thread spent encoding and writing
+    double busySeconds() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_busySeconds;
+    }
+
+    // Encodes and writes a frame on the calling thread, converting it to display values on
+    // the threads of threadPool if there is one
+    static void write(std::ostream &out, const Frame &frame, ThreadPool *threadPool = nullptr)
+    {
+        const std::string encoded = encode(frame, threadPool);
+        out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+        out.flush();
+    }
+
+    static void write(const Frame &frame, ThreadPool *threadPool = nullptr)
+    {
+        if (frame.path.empty())
+        {
+            write(std::cout, frame, threadPool);
+            return;
+        }
+
+        std::ofstream out(frame.path, std::ios::binary);
+        if (!out)
+        {
+            throw std::runtime_error("Cannot open file: " + frame.path);
+        }
+        write(out, frame, threadPool);
+        if (!out)
+        {
+            throw std::runtime_error("Cannot write file: " + frame.path);
+        }
+    }
+
+    // Whole file in memory, so that writing is a single call
+    static std::string encode(const Frame &frame, ThreadPool *threadPool = nullptr)
+    {
+        const bool binary = (frame.format == Format::BinaryPPM);
+        std::string encoded = (binary ? "P6\n" : "P3\n") + std::to_string(frame.width) + ' ' +
+                              std::to_string(frame.height) + "\n255\n";
+        encoded.reserve(encoded.size() + frame.pixels.size() * (binary ? 3 : 12));
+
+        const auto bytes = frame.toneMapper.map(frame.pixels, static_cast<std::size_t>(frame.width), threadPool);
+        if (binary)
+        {
+            encoded.append(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+            return encoded;
+        }
+
+        // Same text as writeColor, without a formatted stream per value
+        for (std::size_t i = 0; i < bytes.size(); ++i)
+        {
+            const int value = bytes[i];
+            if (value >= 100)
+            {
+                encoded.push_back(static_cast<char>('0' + value / 100));
+            }
+            if (value >= 10)
+            {
+                encoded.push_back(static_cast<char>('0' + (value / 10) % 10));
+            }
+            encoded.push_back(static_cast<char>('0' + value % 10));
+            encoded.push_back((i % 3 == 2) ? '\n' : ' ');
+        }
+        return encoded;
+    }
+
+private:
+    BoundedQueue<Frame> m_queue;
+    mutable std::mutex m_mutex{};
+    std::string m_error{};
+    double m_busySeconds{0};
+    std::jthread m_thread; // Last, so that it starts after and is joined before the rest
+
+    void run()
+    {
+        while (auto frame = m_queue.pop())
+        {
+            const auto start = std::chrono::steady_clock::now();
+            std::string error;
+            try
+            {
+                write(*frame);
+            }
+            catch (const std::exception &e)
+            {
+                error = e.what();
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard lock(m_mutex);
+            m_busySeconds += seconds;
+            if (m_error.empty())
+            {
+                m_error = error;
+            }
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_IMAGE_WRITER_HPP */
@@ -19,6 +19,11 @@ public:
     constexpr Interval() : Interval(infinity<T>, -infinity<T>) {}
     constexpr Interval(T min, T max) : m_min(min), m_max(max) {}
 
+    // Tightest interval enclosing both input intervals
+    constexpr Interval(const Interval<T> &a, const Interval<T> &b)
+        : m_min(a.m_min <= b.m_min ? a.m_min : b.m_min),
+          m_max(a.m_max >= b.m_max ? a.m_max : b.m_max) {}
+
     constexpr T min() const { return m_min; }
     constexpr T max() const { return m_max; }
 
@@ -55,6 +60,12 @@ public:
         }
     }
 
+    constexpr Interval<T> expand(T delta) const
+    {
+        const T padding = delta / 2;
+        return Interval<T>(m_min - padding, m_max + padding);
+    }
+
     static constexpr Interval<T> empty()
     {
         return s_empty;
@@ -0,0 +1,338 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_IRRADIANCE_CACHE_HPP
+#define INONEWEEKEND_INCLUDE_IRRADIANCE_CACHE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "color.hpp"
+#include "onb.hpp"
+#include "sampling.hpp"
+#include "util.hpp"
+#include "vector3.hpp"
+
+// Irradiance at sparse surface points, with gradients, from which the irradiance anywhere
+// nearby is interpolated (Ward's irradiance caching with Ward and Heckbert's gradients).
+// Indirect light on diffuse surfaces changes slowly, so one well-sampled record can stand in
+// for the many paths that every pixel would otherwise trace through the hemisphere.
+//
+// A record is valid at a point as long as Ward's error estimate
+//     |p - p_i| / R_i + sqrt(1 - n . n_i)
+// stays below the error bound, where R_i is the harmonic mean distance to the surfaces seen
+// from the record. Records are kept in hash grids, one per power-of-two cell size, each record
+// in the grid whose cells are at least twice its radius of validity, so a lookup only visits
+// the eight cells around the point on every level.
+template <std::floating_point T = double>
+class IrradianceCache
+{
+public:
+    struct Settings
+    {
+        T errorBound{0.5};       // Largest accepted error estimate, smaller gives more records
+        int numThetaStrata{8};   // Hemisphere samples of a record: theta strata...
+        int numPhiStrata{24};    // ...times phi strata
+        T minSpacing_px{1.5};    // Bounds of the harmonic mean distance R_i, in pixels at the
+        T maxSpacing_px{30};     // record, which keep records from crowding or spreading too far
+    };
+
+    struct Record
+    {
+        Point3<T> point{};
+        Vector3<T> normal{};
+        Color<T> irradiance{};
+        std::array<Vector3<T>, 3> rotationalGradient{};    // Per color channel
+        std::array<Vector3<T>, 3> translationalGradient{}; // Per color channel
+        T harmonicDistance{0};                             // R_i
+    };
+
+    explicit IrradianceCache(const Settings &settings)
+        : m_settings(settings)
+    {
+    }
+
+    const Settings &settings() const { return m_settings; }
+    std::size_t size() const { return m_records.size(); }
+    std::span<const Record> records() const { return m_records; }
+
+    // Interpolates the irradiance at a point from the records valid there. Returns false if
+    // there are none.
+    bool lookup(const Point3<T> &point, const Vector3<T> &normal, Color<T> &irradiance) const
+    {
+        Color<T> sum(0.0, 0.0, 0.0);
+        T weightSum = 0;
+        forEachValid(point, normal, [&](const Record &record, T weight)
+                     {
+                         const auto offset = point - record.point;
+                         const auto rotation = cross(record.normal, normal);
+                         Color<T> extrapolated;
+                         for (int c = 0; c < 3; ++c)
+                         {
+                             const auto channel = static_cast<std::size_t>(c);
+                             extrapolated[c] = record.irradiance[c] +
+                                               dot(rotation, record.rotationalGradient[channel]) +
+                                               dot(offset, record.translationalGradient[channel]);
+                         }
+                         sum += weight * extrapolated;
+                         weightSum += weight;
+                         return true;
+                     });
+
+        if (weightSum <= 0)
+        {
+            return false;
+        }
+        irradiance = sum / weightSum;
+        for (int c = 0; c < 3; ++c)
+        {
+            irradiance[c] = std::max(irradiance[c], static_cast<T>(0));
+        }
+        return true;
+    }
+
+    // True if a lookup at the point would find a record
+    bool covers(const Point3<T> &point, const Vector3<T> &normal) const
+    {
+        bool found = false;
+        forEachValid(point, normal, [&](const Record &, T)
+                     {
+                         found = true;
+                         return false;
+                     });
+        return found;
+    }
+
+    void insert(const Record &record)
+    {
+        const int level = levelOf(record.harmonicDistance);
+        const auto index = static_cast<std::uint32_t>(m_records.size());
+        m_records.push_back(record);
+        m_cells[cellKey(level, cellOf(record.point, level))].push_back(index);
+        if (!std::binary_search(m_levels.begin(), m_levels.end(), level))
+        {
+            m_levels.insert(std::upper_bound(m_levels.begin(), m_levels.end(), level), level);
+        }
+    }
+
+    // Direction of hemisphere sample (j, k) about the normal in frame, jittered by (u, v)
+    // within its stratum. Strata are equal in cosine-weighted solid angle.
+    static Vector3<T> sampleDirection(const ONB<T> &frame, int j, int k, T u, T v, const Settings &settings)
+    {
+        const T sinTheta = std::sqrt((static_cast<T>(j) + u) / static_cast<T>(settings.numThetaStrata));
+        const T cosTheta = std::sqrt(std::max(static_cast<T>(1) - sinTheta * sinTheta, static_cast<T>(0)));
+        const T phi = 2 * pi<T> * (static_cast<T>(k) + v) / static_cast<T>(settings.numPhiStrata);
+        return frame.transform(Vector3<T>(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta));
+    }
+
+    // A record from the radiance arriving along the hemisphere samples (j, k) and the distance
+    // to what each of them hit (infinite if nothing), both indexed j * numPhiStrata + k, with
+    // the jitter the directions were drawn with. pixelSize is the size of a pixel at the point.
+    static Record makeRecord(const Point3<T> &point, const ONB<T> &frame,
+                             std::span<const Color<T>> radiance, std::span<const T> distances,
+                             std::span<const std::array<T, 2>> jitter, T pixelSize, const Settings &settings)
+    {
+        const int numTheta = settings.numThetaStrata;
+        const int numPhi = settings.numPhiStrata;
+        const auto at = [numPhi](int j, int k)
+        {
+            return static_cast<std::size_t>(j * numPhi + ((k + numPhi) % numPhi));
+        };
+        const auto sinThetaAt = [numTheta](T j)
+        {
+            return std::sqrt(j / static_cast<T>(numTheta));
+        };
+        const auto cosThetaAt = [&](T j)
+        {
+            return std::sqrt(std::max(static_cast<T>(1) - j / static_cast<T>(numTheta), static_cast<T>(0)));
+        };
+
+        Record record;
+        record.point = point;
+        record.normal = frame.w();
+
+        // Cosine-weighted samples, the irradiance is pi times their mean radiance
+        const T sampleWeight = pi<T> / static_cast<T>(numTheta * numPhi);
+        Color<T> sum(0.0, 0.0, 0.0);
+        T inverseDistanceSum = 0;
+        for (std::size_t i = 0; i < radiance.size(); ++i)
+        {
+            sum += radiance[i];
+            inverseDistanceSum += std::isfinite(distances[i]) ? static_cast<T>(1) / distances[i] : 0;
+        }
+        record.irradiance = sampleWeight * sum;
+
+        // Rotational gradient: how the irradiance changes as the normal tilts
+        for (int k = 0; k < numPhi; ++k)
+        {
+            for (int j = 0; j < numTheta; ++j)
+            {
+                const auto &[u, v] = jitter[at(j, k)];
+                const T sinTheta = sinThetaAt(static_cast<T>(j) + u);
+                const T tanTheta = sinTheta / std::max(cosThetaAt(static_cast<T>(j) + u), static_cast<T>(1e-6));
+                const T phi = 2 * pi<T> * (static_cast<T>(k) + v) / static_cast<T>(numPhi);
+                const auto tangent = frame.transform(Vector3<T>(-std::sin(phi), std::cos(phi), 0));
+                for (int c = 0; c < 3; ++c)
+                {
+                    record.rotationalGradient[static_cast<std::size_t>(c)] += (-sampleWeight * tanTheta * radiance[at(j, k)][c]) * tangent;
+                }
+            }
+        }
+
+        // Translational gradient: how the irradiance changes as the point moves, from the
+        // radiance differences across the boundaries between neighbouring strata and the
+        // distance to what is seen through them
+        const auto nearer = [&](std::size_t a, std::size_t b)
+        {
+            return std::min(distances[a], distances[b]);
+        };
+        for (int k = 0; k < numPhi; ++k)
+        {
+            const T phiCenter = 2 * pi<T> * (static_cast<T>(k) + static_cast<T>(0.5)) / static_cast<T>(numPhi);
+            const T phiBoundary = 2 * pi<T> * static_cast<T>(k) / static_cast<T>(numPhi);
+            const auto across = frame.transform(Vector3<T>(std::cos(phiCenter), std::sin(phiCenter), 0));
+            const auto around = frame.transform(Vector3<T>(-std::sin(phiBoundary), std::cos(phiBoundary), 0));
+
+            for (int j = 0; j < numTheta; ++j)
+            {
+                if (j > 0)
+                {
+                    // Boundary between theta strata j - 1 and j
+                    const T sinTheta = sinThetaAt(static_cast<T>(j));
+                    const T cosTheta = cosThetaAt(static_cast<T>(j));
+                    const T scale = 2 * pi<T> / static_cast<T>(numPhi) * sinTheta * cosTheta * cosTheta /
+                                    nearer(at(j, k), at(j - 1, k));
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        record.translationalGradient[static_cast<std::size_t>(c)] +=
+                            (scale * (radiance[at(j, k)][c] - radiance[at(j - 1, k)][c])) * across;
+                    }
+                }
+
+                // Boundary between phi strata k - 1 and k
+                const T scale = (cosThetaAt(static_cast<T>(j)) - cosThetaAt(static_cast<T>(j + 1))) /
+                                (sinThetaAt(static_cast<T>(j) + static_cast<T>(0.5)) * nearer(at(j, k), at(j, k - 1)));
+                for (int c = 0; c < 3; ++c)
+                {
+                    record.translationalGradient[static_cast<std::size_t>(c)] +=
+                        (scale * (radiance[at(j, k)][c] - radiance[at(j, k - 1)][c])) * around;
+                }
+            }
+        }
+
+        // Harmonic mean distance, shortened where the translational gradient says the
+        // irradiance would otherwise be extrapolated past zero, then kept within the spacing
+        // bounds
+        T distance = (inverseDistanceSum > 0) ? static_cast<T>(radiance.size()) / inverseDistanceSum : infinity<T>;
+        for (int c = 0; c < 3; ++c)
+        {
+            const T gradient = record.translationalGradient[static_cast<std::size_t>(c)].length();
+            if (gradient > 0)
+            {
+                distance = std::min(distance, record.irradiance[c] / gradient);
+            }
+        }
+        record.harmonicDistance = std::clamp(distance, settings.minSpacing_px * pixelSize, settings.maxSpacing_px * pixelSize);
+        return record;
+    }
+
+private:
+    Settings m_settings;
+    std::vector<Record> m_records{};
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> m_cells{}; // Record indices per cell
+    std::vector<int> m_levels{};                                             // Levels holding records, ascending
+
+    // Cells of level l are 2^l wide
+    int levelOf(T harmonicDistance) const
+    {
+        return static_cast<int>(std::ceil(std::log2(2 * m_settings.errorBound * harmonicDistance)));
+    }
+
+    static std::array<std::int64_t, 3> cellOf(const Point3<T> &point, int level)
+    {
+        const T inverseSize = std::ldexp(static_cast<T>(1), -level);
+        return {static_cast<std::int64_t>(std::floor(point.x() * inverseSize)),
+                static_cast<std::int64_t>(std::floor(point.y() * inverseSize)),
+                static_cast<std::int64_t>(std::floor(point.z() * inverseSize))};
+    }
+
+    static std::uint64_t cellKey(int level, const std::array<std::int64_t, 3> &cell)
+    {
+        std::uint64_t key = static_cast<std::uint64_t>(static_cast<std::int64_t>(level));
+        for (const auto coordinate : cell)
+        {
+            key = Sampling::mix64(key ^ static_cast<std::uint64_t>(coordinate));
+        }
+        return key;
+    }
+
+    // Calls visit(record, weight) for every record valid at the point until it returns false.
+    // The weight falls to zero at the error bound, so records fade out instead of leaving seams.
+    template <typename Visit>
+    void forEachValid(const Point3<T> &point, const Vector3<T> &normal, Visit &&visit) const
+    {
+        const T inverseBound = static_cast<T>(1) / m_settings.errorBound;
+        for (const int level : m_levels)
+        {
+            // A record valid here lies within half a cell of the point, so in the cell of the
+            // point or the neighbour towards the nearer face along each axis
+            const T size = std::ldexp(static_cast<T>(1), level);
+            const auto cell = cellOf(point, level);
+            std::array<std::int64_t, 3> neighbour{};
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const auto a = static_cast<std::size_t>(axis);
+                const T within = point[axis] / size - static_cast<T>(cell[a]);
+                neighbour[a] = cell[a] + ((within < static_cast<T>(0.5)) ? -1 : 1);
+            }
+
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                const std::array<std::int64_t, 3> visited{(corner & 1) ? neighbour[0] : cell[0],
+                                                          (corner & 2) ? neighbour[1] : cell[1],
+                                                          (corner & 4) ? neighbour[2] : cell[2]};
+                const auto found = m_cells.find(cellKey(level, visited));
+                if (found == m_cells.end())
+                {
+                    continue;
+                }
+
+                for (const auto index : found->second)
+                {
+                    const auto &record = m_records[index];
+                    const auto offset = point - record.point;
+
+                    // Records in front of the point see a different hemisphere
+                    if (dot(offset, record.normal + normal) < -static_cast<T>(0.1) * record.harmonicDistance)
+                    {
+                        continue;
+                    }
+
+                    const T error = offset.length() / record.harmonicDistance +
+                                    std::sqrt(std::max(static_cast<T>(1) - dot(normal, record.normal), static_cast<T>(0)));
+                    if (error >= m_settings.errorBound)
+                    {
+                        continue;
+                    }
+                    if (!visit(record, static_cast<T>(1) / std::max(error, static_cast<T>(1e-6)) - inverseBound))
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_IRRADIANCE_CACHE_HPP */
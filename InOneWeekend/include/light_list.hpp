@@ -0,0 +1,110 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_LIGHT_LIST_HPP
+#define INONEWEEKEND_INCLUDE_LIGHT_LIST_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "alias_table.hpp"
+#include "environment_map.hpp"
+#include "hittable.hpp"
+#include "vector3.hpp"
+
+// Emissive objects that are sampled directly at every bounce, and optionally an environment
+// map lighting the scene from infinitely far away. A light is picked with probability
+// proportional to its power through an alias table, so the cost of choosing one does not grow
+// with the number of lights. The environment takes part as one more entry, after the objects.
+template <std::floating_point T = double>
+class LightList
+{
+public:
+    LightList() = default;
+
+    LightList(const std::vector<std::shared_ptr<Hittable<T>>> &lights, const std::vector<T> &powers)
+        : m_lights(lights), m_powers(powers), m_indices(), m_table()
+    {
+        for (std::size_t i = 0; i < m_lights.size(); ++i)
+        {
+            m_indices.emplace(m_lights[i].get(), static_cast<std::uint32_t>(i));
+        }
+        rebuildTable();
+    }
+
+    void add(std::shared_ptr<Hittable<T>> light, T power = 1)
+    {
+        // Rebuilds the selection table, use the bulk constructor for many lights
+        m_indices.emplace(light.get(), static_cast<std::uint32_t>(m_lights.size()));
+        m_lights.push_back(light);
+        m_powers.push_back(power);
+        rebuildTable();
+    }
+
+    void setEnvironment(std::shared_ptr<const EnvironmentMap<T>> environment, T power = 1)
+    {
+        // Replaces the sky of escaping rays; pass nullptr to remove it
+        m_environment = std::move(environment);
+        m_environmentPower = power;
+        rebuildTable();
+    }
+
+    std::size_t size() const { return m_lights.size(); } // Objects, without the environment
+    bool isEmpty() const { return m_lights.empty() && !m_environment; }
+
+    const EnvironmentMap<T> *environment() const { return m_environment.get(); }
+    bool isEnvironment(std::size_t i) const { return i == m_lights.size(); } // Index that sample() returns for it
+
+    const Hittable<T> &light(std::size_t i) const { return *m_lights[i]; }
+
+    // Picks a light from a uniform random number in [0, 1)
+    std::size_t sample(T u) const { return m_table.sample(u); }
+
+    T selectionProbability(std::size_t i) const { return m_table.pmf(i); }
+
+    // Solid angle density with which light sampling produces the given direction towards the
+    // hit object. Zero if the object is not one of the lights.
+    T pdfValue(const Hittable<T> *object, const Point3<T> &origin, const Vector3<T> &direction) const
+    {
+        const auto it = m_indices.find(object);
+        if (it == m_indices.end())
+        {
+            return 0;
+        }
+        return m_table.pmf(it->second) * m_lights[it->second]->pdfValue(origin, direction);
+    }
+
+    // Solid angle density with which light sampling draws the given direction from the
+    // environment, zero without one
+    T environmentPdf(const Vector3<T> &direction) const
+    {
+        return m_environment ? m_table.pmf(m_lights.size()) * m_environment->pdf(direction) : 0;
+    }
+
+private:
+    std::vector<std::shared_ptr<Hittable<T>>> m_lights{};
+    std::vector<T> m_powers{};
+    std::unordered_map<const Hittable<T> *, std::uint32_t> m_indices{};
+    std::shared_ptr<const EnvironmentMap<T>> m_environment{};
+    T m_environmentPower{1};
+    AliasTable<T> m_table{};
+
+    void rebuildTable()
+    {
+        auto powers = m_powers;
+        if (m_environment)
+        {
+            powers.push_back(m_environmentPower);
+        }
+        m_table.build(powers);
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_LIGHT_LIST_HPP */
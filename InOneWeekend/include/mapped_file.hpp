@@ -0,0 +1,138 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_MAPPED_FILE_HPP
+#define INONEWEEKEND_INCLUDE_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file, or of a range of it. The contents are paged in by
+// the OS on first access, so large assets can be parsed without first copying them into a heap
+// buffer.
+class MappedFile
+{
+public:
+    // How the contents will be read, which decides the OS readahead
+    enum class Access
+    {
+        Sequential, // Streamed front to back, as by parsers
+        Prefetch    // All of it, in any order; paging in starts right away
+    };
+
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path, Access access = Access::Sequential)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+
+        struct stat status{};
+        if (::fstat(fd, &status) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file: " + path);
+        }
+
+        m_size = static_cast<std::size_t>(status.st_size);
+        if (m_size > 0)
+        {
+            void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file: " + path);
+            }
+            m_data = static_cast<const char *>(data);
+
+            ::madvise(data, m_size, (access == Access::Sequential) ? MADV_SEQUENTIAL : MADV_WILLNEED);
+        }
+
+        ::close(fd);
+    }
+
+    // Bytes [offset, offset + length) of a file, read in before the constructor returns, for
+    // parts of a file that are paged in and out explicitly (see ChunkedScene). offset must be a
+    // multiple of the page size.
+    MappedFile(const std::string &path, std::size_t offset, std::size_t length)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+
+        if (length > 0)
+        {
+            void *data = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, static_cast<off_t>(offset));
+            if (data == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file: " + path);
+            }
+            m_data = static_cast<const char *>(data);
+            m_size = length;
+        }
+
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    const char *data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    std::string_view view() const { return std::string_view(m_data, m_size); }
+
+private:
+    const char *m_data{nullptr};
+    std::size_t m_size{0};
+
+    void unmap()
+    {
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<char *>(m_data), m_size);
+            m_data = nullptr;
+            m_size = 0;
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_MAPPED_FILE_HPP */
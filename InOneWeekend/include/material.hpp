@@ -10,11 +10,16 @@
 
 #include <concepts>
 #include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <utility>
 
 #include "hittable.hpp"
 #include "ray.hpp"
 #include "color.hpp"
+#include "fast_math.hpp"
 #include "material_forward_decl.hpp"
+#include "texture.hpp"
 
 template <std::floating_point T>
 class Material
@@ -27,6 +32,46 @@ public:
         const HitRecord<T> &record,
         Color<T> &attenuation,
         Ray<T> &scattered) const = 0;
+
+    virtual Color<T> emitted(
+        [[maybe_unused]] const Ray<T> &rIn,
+        [[maybe_unused]] const HitRecord<T> &record) const
+    {
+        return Color<T>(0.0, 0.0, 0.0);
+    }
+
+    // True if scatter() draws from a distribution that evaluate() and pdf() cannot describe,
+    // such as mirror reflection. Light sampling is skipped at such surfaces.
+    virtual bool isSpecular() const
+    {
+        return true;
+    }
+
+    // True if the BSDF is a constant, so that the light leaving the surface only depends on the
+    // irradiance, which the camera can then take from an irradiance cache. Diffuse materials
+    // are not specular and emit nothing, which kernels for all-diffuse scenes rely on.
+    virtual bool isDiffuse() const
+    {
+        return false;
+    }
+
+    // BSDF times the cosine of the angle between the normal and the given outgoing direction
+    virtual Color<T> evaluate(
+        [[maybe_unused]] const Ray<T> &rIn,
+        [[maybe_unused]] const HitRecord<T> &record,
+        [[maybe_unused]] const Vector3<T> &direction) const
+    {
+        return Color<T>(0.0, 0.0, 0.0);
+    }
+
+    // Solid angle density with which scatter() produces the given outgoing direction
+    virtual T pdf(
+        [[maybe_unused]] const Ray<T> &rIn,
+        [[maybe_unused]] const HitRecord<T> &record,
+        [[maybe_unused]] const Vector3<T> &direction) const
+    {
+        return 0;
+    }
 };
 
 template <std::floating_point T = double>
@@ -35,6 +80,15 @@ class Lambertial : public Material<T>
 public:
     constexpr Lambertial(const Color<T> &albedo) : m_albedo(albedo) {}
 
+    // Albedo read from a texture at every hit
+    Lambertial(std::shared_ptr<const Texture<T>> albedo) : m_albedo(0.0, 0.0, 0.0), m_texture(std::move(albedo))
+    {
+        if (!m_texture)
+        {
+            throw std::invalid_argument("Lambertial: null texture");
+        }
+    }
+
     virtual ~Lambertial() override = default;
 
     virtual bool scatter(
@@ -52,12 +106,47 @@ public:
         }
 
         scattered = Ray<T>(record.point(), scatterDirection);
-        attenuation = m_albedo;
+        attenuation = albedo(record);
         return true;
     }
 
+    virtual bool isSpecular() const override
+    {
+        return false;
+    }
+
+    virtual bool isDiffuse() const override
+    {
+        return true;
+    }
+
+    virtual Color<T> evaluate(
+        [[maybe_unused]] const Ray<T> &rIn,
+        const HitRecord<T> &record,
+        const Vector3<T> &direction) const override
+    {
+        const T cosTheta = dot(record.normal(), unitVector(direction));
+        return cosTheta > 0 ? Color<T>(albedo(record) * (cosTheta / pi<T>)) : Color<T>(0.0, 0.0, 0.0);
+    }
+
+    virtual T pdf(
+        [[maybe_unused]] const Ray<T> &rIn,
+        const HitRecord<T> &record,
+        const Vector3<T> &direction) const override
+    {
+        // Normal plus a random unit vector is cosine distributed about the normal
+        const T cosTheta = dot(record.normal(), unitVector(direction));
+        return cosTheta > 0 ? cosTheta / pi<T> : 0;
+    }
+
 private:
     Color<T> m_albedo;
+    std::shared_ptr<const Texture<T>> m_texture{}; // Replaces m_albedo if set
+
+    Color<T> albedo(const HitRecord<T> &record) const
+    {
+        return m_texture ? m_texture->value(record) : m_albedo;
+    }
 };
 
 template <std::floating_point T = double>
@@ -66,6 +155,16 @@ class Metal : public Material<T>
 public:
     constexpr Metal(const Color<T> &albedo, T fuzz) : m_albedo(albedo), m_fuzz(fuzz < 1 ? fuzz : 1) {}
 
+    // Albedo read from a texture at every hit
+    Metal(std::shared_ptr<const Texture<T>> albedo, T fuzz)
+        : m_albedo(0.0, 0.0, 0.0), m_fuzz(fuzz < 1 ? fuzz : 1), m_texture(std::move(albedo))
+    {
+        if (!m_texture)
+        {
+            throw std::invalid_argument("Metal: null texture");
+        }
+    }
+
     virtual ~Metal() override = default;
 
     virtual bool scatter(
@@ -77,13 +176,19 @@ public:
         auto reflected = reflect(unitVector(rIn.direction()), record.normal());
         reflected += unitVector<T>(reflected) + (m_fuzz * randomUnitVector<T>());
         scattered = Ray<T>(record.point(), reflected);
-        attenuation = m_albedo;
+        attenuation = albedo(record);
         return (dot(scattered.direction(), record.normal()) > 0);
     }
 
 private:
     Color<T> m_albedo;
     T m_fuzz;
+    std::shared_ptr<const Texture<T>> m_texture{}; // Replaces m_albedo if set
+
+    Color<T> albedo(const HitRecord<T> &record) const
+    {
+        return m_texture ? m_texture->value(record) : m_albedo;
+    }
 };
 
 template <std::floating_point T = double>
@@ -132,8 +237,39 @@ private:
         // Use Schlick's approximation for reflectance
         T r0 = (static_cast<T>(1.0) - refractionIndex) / (static_cast<T>(1.0) + refractionIndex);
         r0 = r0 * r0;
-        return r0 + (static_cast<T>(1.0) - r0) * std::pow((static_cast<T>(1.0) - cosine), 5);
+        return r0 + (static_cast<T>(1.0) - r0) * FastMath::pow5(static_cast<T>(1.0) - cosine);
     }
 };
 
+template <std::floating_point T = double>
+class DiffuseLight : public Material<T>
+{
+public:
+    constexpr DiffuseLight(const Color<T> &emit) : m_emit(emit) {}
+
+    virtual ~DiffuseLight() override = default;
+
+    constexpr const Color<T> &emit() const { return m_emit; }
+
+    virtual bool scatter(
+        [[maybe_unused]] const Ray<T> &rIn,
+        [[maybe_unused]] const HitRecord<T> &record,
+        [[maybe_unused]] Color<T> &attenuation,
+        [[maybe_unused]] Ray<T> &scattered) const override
+    {
+        return false;
+    }
+
+    virtual Color<T> emitted(
+        [[maybe_unused]] const Ray<T> &rIn,
+        const HitRecord<T> &record) const override
+    {
+        // Lights only emit from their front face
+        return record.frontFace() ? m_emit : Color<T>(0.0, 0.0, 0.0);
+    }
+
+private:
+    Color<T> m_emit;
+};
+
 #endif /* INONEWEEKEND_INCLUDE_MATERIAL_HPP */
@@ -0,0 +1,263 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_OBJ_LOADER_HPP
+#define INONEWEEKEND_INCLUDE_OBJ_LOADER_HPP
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "triangle_mesh.hpp"
+#include "vector3.hpp"
+
+// Wavefront OBJ loader for triangle meshes. Only vertex positions ("v") and faces ("f") are
+// read; polygons are fan-triangulated and all other statements are skipped.
+//
+// The file is memory-mapped and split into chunks at line boundaries, and each chunk is parsed
+// by its own thread. Face indices may be relative to the vertices seen so far, so chunks keep
+// them chunk-local and they are resolved once the vertex counts of all chunks are known.
+namespace ObjLoader
+{
+    namespace Detail
+    {
+        struct FaceIndices
+        {
+            std::array<std::int64_t, 3> indices;
+            std::uint8_t relativeMask; // Bit i set if indices[i] is relative to the chunk start
+        };
+
+        template <std::floating_point T>
+        struct Chunk
+        {
+            std::vector<Point3<T>> vertices{};
+            std::vector<FaceIndices> faces{};
+            std::uint64_t numLines{0};
+            std::string error{};        // Without the line number, which only the loader knows
+            std::uint64_t errorLine{0}; // Chunk-local
+        };
+
+        inline void skipSpaces(const char *&p, const char *end)
+        {
+            while (p < end && (*p == ' ' || *p == '\t'))
+            {
+                ++p;
+            }
+        }
+
+        template <std::floating_point T>
+        inline bool parseReal(const char *&p, const char *end, T &value)
+        {
+            skipSpaces(p, end);
+            if (p < end && *p == '+')
+            {
+                ++p;
+            }
+            const auto result = std::from_chars(p, end, value);
+            if (result.ec != std::errc())
+            {
+                return false;
+            }
+            p = result.ptr;
+            return true;
+        }
+
+        inline bool parseIndex(const char *&p, const char *end, std::int64_t &value)
+        {
+            skipSpaces(p, end);
+            if (p >= end || *p == '\r' || *p == '\n')
+            {
+                return false;
+            }
+            const auto result = std::from_chars(p, end, value);
+            if (result.ec != std::errc() || value == 0)
+            {
+                return false;
+            }
+            p = result.ptr;
+
+            // Skip texture coordinate and normal references of "v/vt/vn"
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+            {
+                ++p;
+            }
+            return true;
+        }
+
+        // True if nothing but spaces and a carriage return is left of the line
+        inline bool atLineEnd(const char *p, const char *lineEnd)
+        {
+            skipSpaces(p, lineEnd);
+            if (p < lineEnd && *p == '\r')
+            {
+                ++p;
+            }
+            return p == lineEnd;
+        }
+
+        template <std::floating_point T>
+        inline void parseChunk(const char *begin, const char *end, Chunk<T> &chunk)
+        {
+            std::vector<std::int64_t> polygon;
+
+            for (const char *line = begin; line < end;)
+            {
+                const char *lineEnd = std::find(line, end, '\n');
+                const auto lineNumber = ++chunk.numLines;
+
+                const char *p = line;
+                skipSpaces(p, lineEnd);
+
+                if (lineEnd - p > 1 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+                {
+                    p += 1;
+                    T x, y, z;
+                    if (!parseReal(p, lineEnd, x) || !parseReal(p, lineEnd, y) || !parseReal(p, lineEnd, z))
+                    {
+                        chunk.error = "malformed vertex";
+                        chunk.errorLine = lineNumber;
+                        return;
+                    }
+                    chunk.vertices.emplace_back(x, y, z);
+                }
+                else if (lineEnd - p > 1 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+                {
+                    p += 1;
+                    polygon.clear();
+                    std::int64_t index;
+                    while (parseIndex(p, lineEnd, index))
+                    {
+                        polygon.push_back(index);
+                    }
+                    // An index that does not parse, such as 0 or a word, ends the list early
+                    if (polygon.size() < 3 || !atLineEnd(p, lineEnd))
+                    {
+                        chunk.error = "malformed face";
+                        chunk.errorLine = lineNumber;
+                        return;
+                    }
+
+                    // Resolve relative indices against the chunk-local vertex count. The result
+                    // may be negative, i.e. point into an earlier chunk.
+                    std::uint8_t relativeMask = 0;
+                    const auto localCount = static_cast<std::int64_t>(chunk.vertices.size());
+                    auto toChunkIndex = [localCount](std::int64_t index, bool &relative)
+                    {
+                        relative = index < 0;
+                        return relative ? localCount + index : index - 1;
+                    };
+
+                    bool relative0;
+                    const auto i0 = toChunkIndex(polygon[0], relative0);
+                    for (std::size_t k = 1; k + 1 < polygon.size(); ++k)
+                    {
+                        bool relative1, relative2;
+                        const auto i1 = toChunkIndex(polygon[k], relative1);
+                        const auto i2 = toChunkIndex(polygon[k + 1], relative2);
+                        relativeMask = static_cast<std::uint8_t>((relative0 ? 1 : 0) |
+                                                                 (relative1 ? 2 : 0) |
+                                                                 (relative2 ? 4 : 0));
+                        chunk.faces.push_back(FaceIndices{{i0, i1, i2}, relativeMask});
+                    }
+                }
+
+                line = lineEnd + 1;
+            }
+        }
+    } // namespace Detail
+
+    template <std::floating_point T = double>
+    std::shared_ptr<MeshData<T>> load(const std::string &path, unsigned numThreads = std::thread::hardware_concurrency())
+    {
+        const MappedFile file(path);
+        const char *const data = file.data();
+        const std::size_t size = file.size();
+
+        // Small files are not worth the thread start-up cost
+        constexpr std::size_t minChunkSize = 1 << 20;
+        numThreads = std::max(1u, numThreads);
+        const std::size_t numChunks = std::clamp<std::size_t>(size / minChunkSize, 1, numThreads);
+
+        // Split at line boundaries so that no statement straddles two chunks
+        std::vector<const char *> bounds(numChunks + 1, data + size);
+        bounds[0] = data;
+        for (std::size_t c = 1; c < numChunks; ++c)
+        {
+            const char *split = std::max(bounds[c - 1], data + c * (size / numChunks));
+            split = std::find(split, data + size, '\n');
+            bounds[c] = (split < data + size) ? split + 1 : split;
+        }
+
+        std::vector<Detail::Chunk<T>> chunks(numChunks);
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(numChunks - 1);
+            for (std::size_t c = 1; c < numChunks; ++c)
+            {
+                workers.emplace_back([&, c]
+                                     { Detail::parseChunk(bounds[c], bounds[c + 1], chunks[c]); });
+            }
+            Detail::parseChunk(bounds[0], bounds[1], chunks[0]);
+        }
+
+        // Prefix sums of vertex counts give every chunk its global vertex offset, and those of
+        // line counts the file line of an error
+        std::vector<std::int64_t> vertexOffsets(numChunks + 1, 0);
+        std::uint64_t lineOffset = 0;
+        std::size_t numFaces = 0;
+        for (std::size_t c = 0; c < numChunks; ++c)
+        {
+            if (!chunks[c].error.empty())
+            {
+                throw std::runtime_error(path + ": " + chunks[c].error + " on line " +
+                                         std::to_string(lineOffset + chunks[c].errorLine));
+            }
+            lineOffset += chunks[c].numLines;
+            vertexOffsets[c + 1] = vertexOffsets[c] + static_cast<std::int64_t>(chunks[c].vertices.size());
+            numFaces += chunks[c].faces.size();
+        }
+
+        auto mesh = std::make_shared<MeshData<T>>();
+        const std::int64_t numVertices = vertexOffsets[numChunks];
+        mesh->vertices.reserve(static_cast<std::size_t>(numVertices));
+        mesh->triangles.reserve(numFaces);
+
+        for (std::size_t c = 0; c < numChunks; ++c)
+        {
+            mesh->vertices.insert(mesh->vertices.end(), chunks[c].vertices.begin(), chunks[c].vertices.end());
+
+            for (const auto &face : chunks[c].faces)
+            {
+                typename MeshData<T>::Triangle triangle;
+                for (std::size_t k = 0; k < 3; ++k)
+                {
+                    const bool relative = (face.relativeMask >> k) & 1;
+                    const std::int64_t index = face.indices[k] + (relative ? vertexOffsets[c] : 0);
+                    if (index < 0 || index >= numVertices)
+                    {
+                        throw std::runtime_error(path + ": face references missing vertex");
+                    }
+                    triangle[k] = static_cast<std::uint32_t>(index);
+                }
+                mesh->triangles.push_back(triangle);
+            }
+        }
+
+        return mesh;
+    }
+} // namespace ObjLoader
+
+#endif /* INONEWEEKEND_INCLUDE_OBJ_LOADER_HPP */
@@ -0,0 +1,46 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_ONB_HPP
+#define INONEWEEKEND_INCLUDE_ONB_HPP
+
+#include <cmath>
+#include <concepts>
+
+#include "vector3.hpp"
+
+// Orthonormal basis with w along a given direction, used to map samples from a local frame
+// (z up) into world space
+template <std::floating_point T = double>
+class ONB
+{
+public:
+    explicit ONB(const Vector3<T> &n)
+        : m_u(), m_v(), m_w(unitVector(n))
+    {
+        const Vector3<T> a = (std::fabs(m_w.x()) > static_cast<T>(0.9)) ? Vector3<T>(0, 1, 0) : Vector3<T>(1, 0, 0);
+        m_v = unitVector(cross(m_w, a));
+        m_u = cross(m_w, m_v);
+    }
+
+    constexpr const Vector3<T> &u() const { return m_u; }
+    constexpr const Vector3<T> &v() const { return m_v; }
+    constexpr const Vector3<T> &w() const { return m_w; }
+
+    constexpr Vector3<T> transform(const Vector3<T> &local) const
+    {
+        // Transform from basis coordinates to world space
+        return (local.x() * m_u) + (local.y() * m_v) + (local.z() * m_w);
+    }
+
+private:
+    Vector3<T> m_u;
+    Vector3<T> m_v;
+    Vector3<T> m_w;
+};
+
+#endif /* INONEWEEKEND_INCLUDE_ONB_HPP */
@@ -0,0 +1,280 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_PATH_GUIDE_HPP
+#define INONEWEEKEND_INCLUDE_PATH_GUIDE_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "aabb.hpp"
+#include "util.hpp"
+#include "vector3.hpp"
+
+// Incident radiance learned from the paths of training passes, for sampling scattering
+// directions towards where light actually comes from (path guiding). BSDF sampling only knows
+// the surface, so a small bright opening in the sky is found by luck; the guide knows it from
+// the paths that found it before.
+//
+// Space is divided into grids over the scene bounds, from one cell down to gridResolution cells
+// along the longest side, halving the cell size from one level to the next. Every cell that
+// training paths scatter in holds a histogram over the sphere of directions for each of the six
+// main directions of the surface normal, so that the walls and floor meeting in a cell do not
+// guide each other into the surface. A point is guided
+// by the finest cell around it with enough samples, so the guide refines where paths go often
+// and stays coarse elsewhere, as the spatial tree of an SD-tree would. The bins are equal in
+// solid angle: equal steps in z = cos(theta) times equal steps in phi.
+//
+// Training adds the estimate L / pdf of each scattered direction to its bin, as fixed-point
+// integers, so the sums do not depend on the order in which the render threads add them.
+template <std::floating_point T = double>
+class PathGuide
+{
+public:
+    struct Settings
+    {
+        int numTrainingPasses{3};      // Passes of one sample per pixel that train the guide
+        int gridResolution{16};        // Cells along the longest side of the scene bounds, finest level
+        int numZBins{8};               // Directions of a cell: steps in cos(theta)...
+        int numPhiBins{16};            // ...times steps in phi
+        T guidedFraction{0.5};         // Probability of sampling the guide instead of the BSDF
+        std::uint64_t minSamples{4096}; // Training samples before a cell guides
+    };
+
+    // Training samples of one tile, added to the guide at once
+    struct Sample
+    {
+        Point3<T> point;
+        Vector3<T> normal;
+        std::uint32_t bin;
+        T value; // L / pdf of the direction
+    };
+
+    PathGuide(const Settings &settings, const AABB<T> &bounds)
+        : m_settings(settings)
+    {
+        m_settings.numZBins = std::max(m_settings.numZBins, 1);
+        m_settings.numPhiBins = std::max(m_settings.numPhiBins, 1);
+        m_numBins = static_cast<std::size_t>(m_settings.numZBins) * static_cast<std::size_t>(m_settings.numPhiBins);
+
+        const std::array<T, 3> sizes{bounds.x().size(), bounds.y().size(), bounds.z().size()};
+        const T extent = std::max({sizes[0], sizes[1], sizes[2], static_cast<T>(1e-6)});
+        m_numLevels = static_cast<int>(std::bit_width(static_cast<unsigned>(std::clamp(m_settings.gridResolution, 1, s_maxResolution)) - 1)) + 1;
+        m_cellSize = extent / static_cast<T>(1 << (m_numLevels - 1));
+        m_origin = Point3<T>(bounds.x().min(), bounds.y().min(), bounds.z().min());
+    }
+
+    const Settings &settings() const { return m_settings; }
+    std::size_t numCells() const { return m_cells.size(); } // That guide, on all levels
+
+    // Cell around a point on the finest level, for surfaces facing along normal: the level in
+    // the top 4 bits, then the main axis and sign of the normal in 3 bits and 19 bits per axis.
+    // Points outside the bounds fall into the border cells.
+    std::uint64_t cellKey(const Point3<T> &point, const Vector3<T> &normal) const
+    {
+        int mainAxis = 0;
+        for (int axis = 1; axis < 3; ++axis)
+        {
+            if (std::abs(normal[axis]) > std::abs(normal[mainAxis]))
+            {
+                mainAxis = axis;
+            }
+        }
+
+        const auto maxCell = static_cast<T>((1 << (m_numLevels - 1)) - 1);
+        auto key = (static_cast<std::uint64_t>(m_numLevels - 1) << 3) | static_cast<std::uint64_t>(2 * mainAxis + (normal[mainAxis] < 0));
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const T cell = std::clamp(std::floor((point[axis] - m_origin[axis]) / m_cellSize), static_cast<T>(0), maxCell);
+            key = (key << 19) | static_cast<std::uint64_t>(cell);
+        }
+        return key;
+    }
+
+    // The cell on a coarser level that contains a finest-level cell
+    std::uint64_t coarsen(std::uint64_t key, int level) const
+    {
+        constexpr std::uint64_t mask = (1u << 19) - 1;
+        const int shift = m_numLevels - 1 - level;
+        auto coarse = (static_cast<std::uint64_t>(level) << 3) | ((key >> 57) & 7);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            coarse = (coarse << 19) | (((key >> (19 * (2 - axis))) & mask) >> shift);
+        }
+        return coarse;
+    }
+
+    std::uint32_t bin(const Vector3<T> &unitDirection) const
+    {
+        const T z = std::clamp(unitDirection.z(), static_cast<T>(-1), static_cast<T>(1));
+        const T phi = std::atan2(unitDirection.y(), unitDirection.x()) + pi<T>;
+        const int zBin = std::min(static_cast<int>((z + 1) / 2 * static_cast<T>(m_settings.numZBins)), m_settings.numZBins - 1);
+        const int phiBin = std::min(static_cast<int>(phi / (2 * pi<T>) * static_cast<T>(m_settings.numPhiBins)), m_settings.numPhiBins - 1);
+        return static_cast<std::uint32_t>(std::max(zBin, 0) * m_settings.numPhiBins + std::max(phiBin, 0));
+    }
+
+    // Adds the samples of a tile to the sums of their finest cells; thread-safe. Lookups see
+    // the distributions of the last build() until the next one.
+    void add(const std::vector<Sample> &samples)
+    {
+        const std::scoped_lock lock(m_mutex);
+        for (const auto &sample : samples)
+        {
+            auto &sums = m_sums[cellKey(sample.point, sample.normal)];
+            if (sums.bins.empty())
+            {
+                sums.bins.assign(m_numBins, 0);
+            }
+            sums.bins[sample.bin] += static_cast<std::uint64_t>(std::clamp(sample.value, static_cast<T>(0), s_maxValue) * s_fixedPointScale);
+            ++sums.count;
+        }
+    }
+
+    // Turns the sums of all training so far into the distributions sampled from: sums the
+    // finest cells into their coarser ones, makes a distribution for every cell with enough
+    // samples and resolves each finest cell to its finest ancestor that has one. Not
+    // thread-safe, call between passes.
+    void build()
+    {
+        std::unordered_map<std::uint64_t, Sums> levels;
+        for (const auto &[key, sums] : m_sums)
+        {
+            for (int level = 0; level < m_numLevels; ++level)
+            {
+                auto &coarse = levels[coarsen(key, level)];
+                coarse.bins.resize(m_numBins, 0);
+                for (std::size_t b = 0; b < m_numBins; ++b)
+                {
+                    coarse.bins[b] += sums.bins[b];
+                }
+                coarse.count += sums.count;
+            }
+        }
+
+        m_cells.clear();
+        m_cdf.clear();
+        for (const auto &[key, sums] : levels)
+        {
+            std::uint64_t total = 0;
+            for (const auto sum : sums.bins)
+            {
+                total += sum;
+            }
+            if (sums.count < m_settings.minSamples || total == 0)
+            {
+                continue;
+            }
+
+            m_cells.emplace(key, static_cast<std::uint32_t>(m_cdf.size() / m_numBins));
+            std::uint64_t running = 0;
+            for (const auto sum : sums.bins)
+            {
+                running += sum;
+                m_cdf.push_back(static_cast<T>(running) / static_cast<T>(total));
+            }
+        }
+
+        m_finestCells.clear();
+        for (const auto &entry : m_sums)
+        {
+            if (const auto cell = guidingAncestor(entry.first, m_numLevels - 1); cell != m_cells.end())
+            {
+                m_finestCells.emplace(entry.first, cell->second);
+            }
+        }
+    }
+
+    // Distribution of the finest cell around point that guides, or nullptr where the guide
+    // knows too little
+    const T *find(const Point3<T> &point, const Vector3<T> &normal) const
+    {
+        const auto key = cellKey(point, normal);
+        auto found = m_finestCells.find(key);
+        if (found == m_finestCells.end())
+        {
+            // No training sample landed in the cell itself
+            found = guidingAncestor(key, m_numLevels - 2);
+            if (found == m_cells.end())
+            {
+                return nullptr;
+            }
+        }
+        return m_cdf.data() + static_cast<std::size_t>(found->second) * m_numBins;
+    }
+
+    // Draws a unit direction from the distribution of a cell, given three uniform numbers
+    Vector3<T> sample(const T *cdf, T u, T v, T w) const
+    {
+        const auto found = std::upper_bound(cdf, cdf + m_numBins, u);
+        const auto index = static_cast<int>(std::min<std::ptrdiff_t>(found - cdf, static_cast<std::ptrdiff_t>(m_numBins) - 1));
+        const int zBin = index / m_settings.numPhiBins;
+        const int phiBin = index % m_settings.numPhiBins;
+
+        const T z = -1 + 2 * (static_cast<T>(zBin) + v) / static_cast<T>(m_settings.numZBins);
+        const T phi = 2 * pi<T> * (static_cast<T>(phiBin) + w) / static_cast<T>(m_settings.numPhiBins) - pi<T>;
+        const T r = std::sqrt(std::max(static_cast<T>(0), 1 - z * z));
+        return Vector3<T>(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    // Solid angle density with which sample() draws a direction
+    T pdf(const T *cdf, const Vector3<T> &direction) const
+    {
+        const auto index = bin(unitVector(direction));
+        const T probability = cdf[index] - ((index > 0) ? cdf[index - 1] : 0);
+        return probability * static_cast<T>(m_numBins) / (4 * pi<T>);
+    }
+
+private:
+    // Finest grid whose cells, with their level, fit a 64-bit key
+    static constexpr int s_maxResolution = 1 << 15;
+
+    // Fixed point of the sums: fine enough for the dimmest light that matters, while a sample
+    // clamped to s_maxValue cannot overflow a bin before 2^24 of them land in it
+    static constexpr T s_fixedPointScale = static_cast<T>(1 << 20);
+    static constexpr T s_maxValue = static_cast<T>(1 << 20);
+
+    struct Sums
+    {
+        std::vector<std::uint64_t> bins{};
+        std::uint64_t count{0};
+    };
+
+    // The finest cell on level or coarser that contains a finest-level cell and guides
+    typename std::unordered_map<std::uint64_t, std::uint32_t>::const_iterator guidingAncestor(std::uint64_t key, int level) const
+    {
+        for (; level >= 0; --level)
+        {
+            if (const auto found = m_cells.find(coarsen(key, level)); found != m_cells.end())
+            {
+                return found;
+            }
+        }
+        return m_cells.end();
+    }
+
+    Settings m_settings;
+    std::size_t m_numBins{1};
+    int m_numLevels{1};
+    Point3<T> m_origin{};
+    T m_cellSize{1}; // On the finest level
+
+    std::mutex m_mutex{};
+    std::unordered_map<std::uint64_t, Sums> m_sums{};                  // Training so far, per finest cell
+    std::unordered_map<std::uint64_t, std::uint32_t> m_cells{};        // Guiding cell to its distribution
+    std::unordered_map<std::uint64_t, std::uint32_t> m_finestCells{};  // Trained finest cell to the distribution it uses
+    std::vector<T> m_cdf{};                                       // numBins per distribution
+};
+
+#endif /* INONEWEEKEND_INCLUDE_PATH_GUIDE_HPP */
@@ -0,0 +1,149 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_PERF_COUNTERS_HPP
+#define INONEWEEKEND_INCLUDE_PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware cache counters of the calling thread and the threads it starts while counting,
+// read through perf_event_open. Counters the kernel or the machine does not provide, e.g.
+// in most virtual machines or with a restrictive perf_event_paranoid, read as empty.
+class PerfCounters
+{
+public:
+    enum class Event
+    {
+        L1DataReadMisses,
+        LastLevelReadMisses,
+        Instructions,
+    };
+
+    static constexpr std::size_t s_numEvents = 3;
+
+    static constexpr std::string_view name(Event event)
+    {
+        switch (event)
+        {
+        case Event::L1DataReadMisses:
+            return "L1D misses";
+        case Event::LastLevelReadMisses:
+            return "LLC misses";
+        default:
+            return "instructions";
+        }
+    }
+
+    PerfCounters()
+    {
+#ifdef __linux__
+        constexpr auto cacheReadMiss = [](std::uint64_t cache)
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        open(Event::L1DataReadMisses, PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_L1D));
+        open(Event::LastLevelReadMisses, PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_LL));
+        open(Event::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (const int fd : m_fds)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool isAvailable(Event event) const { return m_fds[index(event)] >= 0; }
+
+    // Resets and enables all available counters
+    void start()
+    {
+#ifdef __linux__
+        for (const int fd : m_fds)
+        {
+            if (fd >= 0)
+            {
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop()
+    {
+#ifdef __linux__
+        for (const int fd : m_fds)
+        {
+            if (fd >= 0)
+            {
+                ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Count between the last start() and stop(), empty if the event is not available
+    std::optional<std::uint64_t> value(Event event) const
+    {
+#ifdef __linux__
+        const int fd = m_fds[index(event)];
+        std::uint64_t count = 0;
+        if (fd >= 0 && ::read(fd, &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count)))
+        {
+            return count;
+        }
+#else
+        (void)event;
+#endif
+        return std::nullopt;
+    }
+
+private:
+    std::array<int, s_numEvents> m_fds{-1, -1, -1};
+
+    static constexpr std::size_t index(Event event) { return static_cast<std::size_t>(event); }
+
+#ifdef __linux__
+    void open(Event event, std::uint32_t type, std::uint64_t config)
+    {
+        perf_event_attr attributes{};
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.disabled = 1;
+        attributes.inherit = 1; // Include render threads started after opening
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        m_fds[index(event)] = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+#endif
+};
+
+#endif /* INONEWEEKEND_INCLUDE_PERF_COUNTERS_HPP */
@@ -0,0 +1,322 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_RENDER_JOB_HPP
+#define INONEWEEKEND_INCLUDE_RENDER_JOB_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "camera.hpp"
+#include "image_writer.hpp"
+#include "mapped_file.hpp"
+#include "scene_generator.hpp"
+#include "vector3.hpp"
+
+// FNV-1a, for keys derived from file and scene contents
+inline constexpr std::uint64_t contentHash(std::string_view data, std::uint64_t hash = 0xCBF29CE484222325ull)
+{
+    for (const char c : data)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// FNV-1a over the bytes of a file
+inline std::uint64_t fileContentHash(const std::string &path)
+{
+    const MappedFile file(path);
+    return contentHash(file.view());
+}
+
+// Size and modification time of a file, which change whenever it is rewritten
+inline std::string fileStamp(const std::string &path)
+{
+    return std::to_string(std::filesystem::file_size(path)) + ' ' +
+           std::to_string(std::filesystem::last_write_time(path).time_since_epoch().count());
+}
+
+// A scene and the camera to render it with, as sent to the render server. The text form is one
+// `key value...` line per setting, e.g. `objects 10000` or `look-from 0 2 10`; keys not given
+// keep their defaults.
+template <std::floating_point T = double>
+struct RenderJob
+{
+    using Layout = typename SceneGenerator<T>::Layout;
+    using SizeDistribution = typename SceneGenerator<T>::SizeDistribution;
+    using Format = typename ImageWriter<T>::Format;
+
+    // Scene: generated spheres, or a mesh if objPath is set
+    std::size_t objectCount{1000};
+    Layout layout{Layout::Field};
+    SizeDistribution sizes{SizeDistribution::Uniform};
+    std::size_t paletteSize{0};
+    std::uint64_t sceneSeed{1};
+    std::string objPath{};
+    std::vector<std::string> texturePaths{}; // Texture files for the albedo of generated spheres
+    std::size_t textureCacheMiB{64};         // Texture tiles kept in memory, when the scene is built
+    std::string environmentPath{};           // Color PFM lat-long image lighting the scene, sky gradient if empty
+
+    // Camera, looking at the scene from above and in front unless placed explicitly
+    int imageWidth{320};
+    T aspectRatio{16.0 / 9.0};
+    int numSamplesPerPixel{4};
+    int maxReflection{8};
+    T verticalFOV_deg{40};
+    std::optional<Point3<T>> lookFrom{};
+    std::optional<Point3<T>> lookAt{};
+    Vector3<T> vUp{0, 1, 0};
+    T defocusAngle_deg{0};
+    std::optional<T> focusDist{};
+    std::uint64_t seed{0};
+    Format format{Format::BinaryPPM};
+    T irradianceCacheError{0}; // Error bound of the irradiance cache, 0 path traces every bounce
+    int pathGuidingPasses{0};  // Training passes of the path guide, 0 samples the BSDF alone
+
+    // Applies one line of the text form, throws on unknown keys and malformed values
+    void set(const std::string &line)
+    {
+        std::istringstream in(line);
+        std::string key;
+        in >> key;
+
+        const auto invalid = [&]
+        {
+            return std::runtime_error("RenderJob: invalid line '" + line + "'");
+        };
+        const auto read = [&]<typename Value>(Value &value)
+        {
+            if (!(in >> value))
+            {
+                throw invalid();
+            }
+        };
+        const auto readPoint = [&]
+        {
+            T x, y, z;
+            read(x);
+            read(y);
+            read(z);
+            return Point3<T>(x, y, z);
+        };
+        const auto choose = [&]<typename Choice>(std::initializer_list<std::pair<const char *, Choice>> choices)
+        {
+            std::string word;
+            read(word);
+            for (const auto &[name, choice] : choices)
+            {
+                if (word == name)
+                {
+                    return choice;
+                }
+            }
+            throw invalid();
+        };
+
+        if (key == "objects")
+        {
+            read(objectCount);
+        }
+        else if (key == "layout")
+        {
+            layout = choose({std::pair{"field", Layout::Field}, {"volume", Layout::Volume}});
+        }
+        else if (key == "sizes")
+        {
+            sizes = choose({std::pair{"uniform", SizeDistribution::Uniform},
+                            {"lognormal", SizeDistribution::LogNormal},
+                            {"powerlaw", SizeDistribution::PowerLaw}});
+        }
+        else if (key == "palette")
+        {
+            read(paletteSize);
+        }
+        else if (key == "scene-seed")
+        {
+            read(sceneSeed);
+        }
+        else if (key == "obj")
+        {
+            read(objPath);
+        }
+        else if (key == "texture")
+        {
+            // Every line adds a texture
+            read(texturePaths.emplace_back());
+        }
+        else if (key == "texture-cache")
+        {
+            read(textureCacheMiB);
+        }
+        else if (key == "environment")
+        {
+            read(environmentPath);
+        }
+        else if (key == "width")
+        {
+            read(imageWidth);
+        }
+        else if (key == "aspect")
+        {
+            read(aspectRatio);
+        }
+        else if (key == "spp")
+        {
+            read(numSamplesPerPixel);
+        }
+        else if (key == "depth")
+        {
+            read(maxReflection);
+        }
+        else if (key == "vfov")
+        {
+            read(verticalFOV_deg);
+        }
+        else if (key == "look-from")
+        {
+            lookFrom = readPoint();
+        }
+        else if (key == "look-at")
+        {
+            lookAt = readPoint();
+        }
+        else if (key == "up")
+        {
+            vUp = readPoint();
+        }
+        else if (key == "defocus")
+        {
+            read(defocusAngle_deg);
+        }
+        else if (key == "focus-dist")
+        {
+            T distance;
+            read(distance);
+            focusDist = distance;
+        }
+        else if (key == "seed")
+        {
+            read(seed);
+        }
+        else if (key == "irradiance-cache")
+        {
+            read(irradianceCacheError);
+        }
+        else if (key == "path-guiding")
+        {
+            read(pathGuidingPasses);
+        }
+        else if (key == "format")
+        {
+            format = choose({std::pair{"plain", Format::PlainPPM}, {"binary", Format::BinaryPPM}});
+        }
+        else
+        {
+            throw invalid();
+        }
+
+        std::string rest;
+        if (in >> rest)
+        {
+            throw invalid();
+        }
+    }
+
+    // A camera with these settings for a scene around sceneCenter of size sceneExtent
+    Camera<T> camera(const Point3<T> &sceneCenter, T sceneExtent) const
+    {
+        const Point3<T> at = lookAt.value_or(sceneCenter);
+        const Point3<T> from = lookFrom.value_or(sceneCenter + Vector3<T>(0, sceneExtent / 4, sceneExtent / 2));
+
+        Camera<T> camera;
+        camera.setAspectRatio(aspectRatio);
+        camera.setImageWidth(imageWidth);
+        camera.setNumSamplesPerPixel(numSamplesPerPixel);
+        camera.setMaxReflection(maxReflection);
+        camera.setVerticalFOV_deg(verticalFOV_deg);
+        camera.setLookFrom(from);
+        camera.setLookAt(at);
+        camera.setVUp(vUp);
+        camera.setDefocusAngle_deg(defocusAngle_deg);
+        camera.setFocusDist(focusDist.value_or((from - at).length()));
+        camera.setSeed(seed);
+        if (irradianceCacheError > 0)
+        {
+            typename IrradianceCache<T>::Settings settings;
+            settings.errorBound = irradianceCacheError;
+            camera.setIrradianceCache(settings);
+        }
+        if (pathGuidingPasses > 0)
+        {
+            typename PathGuide<T>::Settings settings;
+            settings.numTrainingPasses = pathGuidingPasses;
+            camera.setPathGuiding(settings);
+        }
+        return camera;
+    }
+
+    // Canonical text of the scene settings, the same for every job that renders the same scene
+    std::string sceneDescription() const
+    {
+        std::ostringstream out;
+        if (!environmentPath.empty())
+        {
+            out << "environment " << environmentPath << ' ';
+        }
+        if (!objPath.empty())
+        {
+            out << "obj " << objPath;
+            return out.str();
+        }
+
+        out << "objects " << objectCount
+            << " layout " << static_cast<int>(layout)
+            << " sizes " << static_cast<int>(sizes)
+            << " palette " << paletteSize
+            << " scene-seed " << sceneSeed;
+        for (const auto &path : texturePaths)
+        {
+            out << " texture " << path;
+        }
+        return out.str();
+    }
+
+    // Key of the built scene. A mesh and an environment map are keyed by the contents of their
+    // files, so that an edited file is not served from the cache; fileHash gives those, and may
+    // remember them for files that did not change (see SceneCache). Texture files are only read
+    // a tile at a time, which hashing them whole would undo, so they are keyed by size and
+    // modification time.
+    std::uint64_t sceneKey(const std::function<std::uint64_t(const std::string &)> &fileHash = fileContentHash) const
+    {
+        std::uint64_t key = contentHash(sceneDescription());
+        for (const auto *path : {&objPath, &environmentPath})
+        {
+            if (!path->empty())
+            {
+                key = contentHash(std::to_string(fileHash(*path)), key);
+            }
+        }
+        for (const auto &path : texturePaths)
+        {
+            key = contentHash(fileStamp(path), key);
+        }
+        return key;
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_RENDER_JOB_HPP */
@@ -0,0 +1,177 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_RENDER_SERVER_HPP
+#define INONEWEEKEND_INCLUDE_RENDER_SERVER_HPP
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <unistd.h>
+
+#include "image_writer.hpp"
+#include "light_list.hpp"
+#include "render_job.hpp"
+#include "scene_cache.hpp"
+#include "thread_pool.hpp"
+#include "unix_socket.hpp"
+
+// Long-running render process behind a Unix domain socket. Scenes and their acceleration
+// structures stay built between jobs and the render threads stay alive, so a job for a scene
+// seen before only pays for tracing.
+//
+// Requests are text lines. Job lines (see RenderJob) accumulate until `render`, which renders
+// them and answers
+//     ok <bytes> scene <built|mapped|cached> <seconds> render <seconds>
+// followed by the image as a PPM file of that many bytes, or `error <message>`. The next job
+// starts from the defaults again. `shutdown` stops the server. A connection can send any
+// number of jobs; connections are served one after another. With a BVH directory, built trees
+// are saved there and `mapped` scenes reuse one saved by this or an earlier server.
+template <std::floating_point T = double>
+class RenderServer
+{
+public:
+    explicit RenderServer(std::string socketPath, std::size_t cacheCapacity = 4, int numThreads = 0,
+                          const std::string &bvhDirectory = {})
+        : m_socketPath(std::move(socketPath)), m_cache(cacheCapacity, bvhDirectory), m_threadPool(std::make_shared<ThreadPool>(numThreads))
+    {
+        m_cache.setThreadPool(m_threadPool);
+    }
+
+    RenderServer(const RenderServer &) = delete;
+    RenderServer &operator=(const RenderServer &) = delete;
+
+    // Serves until a client sends `shutdown`
+    void run()
+    {
+        const auto listener = UnixSocket::listen(m_socketPath);
+        std::clog << "Serving on " << m_socketPath << " with " << m_threadPool->numThreads() << " render threads\n";
+
+        bool running = true;
+        while (running)
+        {
+            auto connection = listener.accept();
+            try
+            {
+                running = serve(connection);
+            }
+            catch (const std::exception &e)
+            {
+                // A client that went away takes only its own connection down
+                std::clog << "Connection dropped: " << e.what() << '\n';
+            }
+        }
+
+        ::unlink(m_socketPath.c_str());
+    }
+
+private:
+    std::string m_socketPath;
+    SceneCache<T> m_cache;
+    std::shared_ptr<ThreadPool> m_threadPool;
+
+    // Handles the requests of one connection, false once asked to shut down
+    bool serve(UnixSocket &connection)
+    {
+        // Both belong to this connection, so a client that leaves mid-job leaves nothing behind
+        RenderJob<T> job;
+        std::string pendingError; // First invalid line of the job being received
+        std::string line;
+        while (connection.readLine(line))
+        {
+            if (line == "shutdown")
+            {
+                connection.sendAll("ok 0\n");
+                return false;
+            }
+
+            if (line != "render")
+            {
+                try
+                {
+                    job.set(line);
+                }
+                catch (const std::exception &e)
+                {
+                    // Reported when the job is rendered, so that replies match renders
+                    pendingError = pendingError.empty() ? e.what() : pendingError;
+                }
+                continue;
+            }
+
+            std::string reply;
+            try
+            {
+                if (!pendingError.empty())
+                {
+                    throw std::runtime_error(pendingError);
+                }
+                reply = render(job);
+            }
+            catch (const std::exception &e)
+            {
+                reply = std::string("error ") + e.what() + '\n';
+            }
+            pendingError.clear();
+            job = RenderJob<T>();
+            connection.sendAll(reply);
+        }
+        return true;
+    }
+
+    // Renders a job into the reply: the status line followed by the encoded image
+    std::string render(const RenderJob<T> &job)
+    {
+        if (job.imageWidth < 1 || job.numSamplesPerPixel < 1)
+        {
+            throw std::runtime_error("RenderJob: width and spp must be positive");
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        auto origin = SceneCache<T>::Origin::Cached;
+        const auto scene = m_cache.get(job, origin);
+        const auto sceneEnd = std::chrono::steady_clock::now();
+
+        auto camera = job.camera(scene->center, scene->extent);
+        camera.setThreadPool(m_threadPool);
+
+        auto pixels = camera.renderImage(scene->bvh, scene->lights);
+        const int height = static_cast<int>(pixels.size()) / job.imageWidth;
+        const std::string image = ImageWriter<T>::encode(
+            typename ImageWriter<T>::Frame{{}, job.imageWidth, height, std::move(pixels), job.format, camera.toneMapper()}, m_threadPool.get());
+        const auto end = std::chrono::steady_clock::now();
+
+        std::ostringstream status;
+        status << "ok " << image.size()
+               << " scene " << originName(origin) << ' ' << std::chrono::duration<double>(sceneEnd - start).count()
+               << " render " << std::chrono::duration<double>(end - sceneEnd).count() << '\n';
+        return status.str() + image;
+    }
+
+    static const char *originName(typename SceneCache<T>::Origin origin)
+    {
+        switch (origin)
+        {
+        case SceneCache<T>::Origin::Cached:
+            return "cached";
+        case SceneCache<T>::Origin::Mapped:
+            return "mapped";
+        default:
+            return "built";
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_RENDER_SERVER_HPP */
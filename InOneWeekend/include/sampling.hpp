@@ -0,0 +1,394 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_SAMPLING_HPP
+#define INONEWEEKEND_INCLUDE_SAMPLING_HPP
+
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+
+// Batched sample generation. Instead of rejection loops that draw one value at a time, whole
+// blocks of uniform numbers are produced by a multi-lane generator and mapped to directions
+// and disk points with branchless analytic transforms. All kernels are plain loops over
+// structure-of-arrays buffers with a fixed lane count, which the compiler vectorizes.
+//
+// Random numbers are counter based: value number n of a stream is a hash of the stream key
+// and n, with no state carried between values. The camera keys one stream per (pixel, sample)
+// and the number of values drawn so far is the dimension, so an image only depends on the
+// seed and not on the number of threads or the order in which tiles are rendered.
+namespace Sampling
+{
+    inline constexpr std::size_t s_lanes = 8;
+
+    // Key used by streams that were never restarted, e.g. while building scenes
+    inline constexpr std::uint64_t s_defaultSeed = 0x853C49E6748FEA9Bull;
+
+    // splitmix64 output function, a bijective 64-bit mix
+    inline constexpr std::uint64_t mix64(std::uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Value number `counter` of the stream with the given key. For a fixed key this is the
+    // splitmix64 sequence, for different keys the sequences are decorrelated by the mix.
+    inline constexpr std::uint64_t counterHash(std::uint64_t key, std::uint64_t counter)
+    {
+        return mix64(key + (counter + 1) * 0x9E3779B97F4A7C15ull);
+    }
+
+    // Key of the stream for sample number `sample` of pixel number `pixel`
+    inline constexpr std::uint64_t sampleKey(std::uint64_t seed, std::uint64_t pixel, std::uint64_t sample)
+    {
+        return mix64(mix64(seed ^ mix64(pixel + 0x632BE59BD9B4E019ull)) + sample);
+    }
+
+    // Uniform real in [0, 1) from 64 random bits. The top mantissa bits are placed under the
+    // exponent of 1.0 to get a value in [1, 2), which avoids an integer to float conversion.
+    template <std::floating_point T>
+    inline T toUnit(std::uint64_t bits)
+    {
+        if constexpr (sizeof(T) == sizeof(std::uint64_t))
+        {
+            return std::bit_cast<T>((bits >> 12) | 0x3FF0000000000000ull) - 1;
+        }
+        else
+        {
+            return std::bit_cast<T>(static_cast<std::uint32_t>(bits >> 41) | 0x3F800000u) - 1;
+        }
+    }
+
+    // Fills out[i] with dimension `dimension` of the stream keys[i], for i in [0, count)
+    template <std::floating_point T>
+    inline void fillKeyed(const std::uint64_t *keys, std::uint64_t dimension, T *out, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = toUnit<T>(counterHash(keys[i], dimension));
+        }
+    }
+
+    // Sequential reader of one counter-based stream. Each value only costs a multiply-add and
+    // the mix, and consecutive values are independent, so the lanes of a block are generated
+    // side by side in vector registers.
+    class BlockRandom
+    {
+    public:
+        explicit BlockRandom(std::uint64_t key)
+        {
+            restart(key, 0);
+        }
+
+        // Continues reading the stream `key` at value number `counter`
+        void restart(std::uint64_t key, std::uint64_t counter)
+        {
+            m_key = key;
+            m_counter = counter;
+        }
+
+        std::uint64_t key() const { return m_key; }
+        std::uint64_t counter() const { return m_counter; }
+
+        // Fills out[0, count) with uniform reals in [0, 1)
+        template <std::floating_point T>
+        void fill(T *out, std::size_t count)
+        {
+            const std::uint64_t key = m_key;
+            const std::uint64_t counter = m_counter;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = toUnit<T>(counterHash(key, counter + i));
+            }
+            m_counter += count;
+        }
+
+    private:
+        std::uint64_t m_key{0};
+        std::uint64_t m_counter{0};
+    };
+
+    // Rounds to the nearest integer by pushing the fraction out of the mantissa. Unlike
+    // std::floor or std::round this is plain arithmetic, so loops using it vectorize without
+    // relaxing floating point semantics. Valid for |x| < 2^51 (2^22 for float).
+    template <std::floating_point T>
+    inline T roundNearest(T x)
+    {
+        constexpr T magic = static_cast<T>(sizeof(T) == 8 ? 6755399441055744.0 : 12582912.0);
+        return (x + magic) - magic;
+    }
+
+    // max(x, 0) as a select, which vectorizes where std::fmax does not
+    template <std::floating_point T>
+    inline T nonNegative(T x)
+    {
+        return (x > 0) ? x : 0;
+    }
+
+    // sin(2 pi u) and cos(2 pi u) for u in [0, 1] without calls into libm. The angle is reduced
+    // to [-pi/4, pi/4] around the nearest quadrant and evaluated with Taylor polynomials, whose
+    // truncation error there is below 1e-11.
+    template <std::floating_point T>
+    inline void sinCos2Pi(T u, T &sine, T &cosine)
+    {
+        const T quadrant = roundNearest(4 * u);
+        const T x = 2 * std::numbers::pi_v<T> * (u - quadrant / 4);
+        const T x2 = x * x;
+
+        const T s = x * (1 + x2 * (static_cast<T>(-1.0 / 6) + x2 * (static_cast<T>(1.0 / 120) + x2 * (static_cast<T>(-1.0 / 5040) + x2 * (static_cast<T>(1.0 / 362880) + x2 * static_cast<T>(-1.0 / 39916800))))));
+        const T c = 1 + x2 * (static_cast<T>(-1.0 / 2) + x2 * (static_cast<T>(1.0 / 24) + x2 * (static_cast<T>(-1.0 / 720) + x2 * (static_cast<T>(1.0 / 40320) + x2 * (static_cast<T>(-1.0 / 3628800) + x2 * static_cast<T>(1.0 / 479001600))))));
+
+        // Rotate by the quadrant (0 to 4): odd quadrants swap sine and cosine, and the signs
+        // follow the half of the circle. The selects compile to blends rather than branches,
+        // since the quadrant is random and branches on it would mispredict half the time.
+        const bool odd = (quadrant == 1) | (quadrant == 3);
+        const T rotatedSine = odd ? c : s;
+        const T rotatedCosine = odd ? s : c;
+        sine = ((quadrant == 2) | (quadrant == 3)) ? -rotatedSine : rotatedSine;
+        cosine = ((quadrant == 1) | (quadrant == 2)) ? -rotatedCosine : rotatedCosine;
+    }
+
+    // Uniform directions on the unit sphere from pairs of uniform numbers (Archimedes' mapping)
+    template <std::floating_point T>
+    inline void toUnitSphere(const T *u, const T *v, T *x, T *y, T *z, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const T cosTheta = 1 - 2 * u[i];
+            const T sinTheta = std::sqrt(nonNegative(1 - cosTheta * cosTheta));
+            T sinPhi, cosPhi;
+            sinCos2Pi(v[i], sinPhi, cosPhi);
+            x[i] = sinTheta * cosPhi;
+            y[i] = sinTheta * sinPhi;
+            z[i] = cosTheta;
+        }
+    }
+
+    // Cosine-weighted directions on the +z hemisphere (Malley's method)
+    template <std::floating_point T>
+    inline void toCosineHemisphere(const T *u, const T *v, T *x, T *y, T *z, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const T r = std::sqrt(u[i]);
+            T sinPhi, cosPhi;
+            sinCos2Pi(v[i], sinPhi, cosPhi);
+            x[i] = r * cosPhi;
+            y[i] = r * sinPhi;
+            z[i] = std::sqrt(nonNegative(1 - u[i]));
+        }
+    }
+
+    // Uniform points in the unit disk
+    template <std::floating_point T>
+    inline void toUnitDisk(const T *u, const T *v, T *x, T *y, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const T r = std::sqrt(u[i]);
+            T sinPhi, cosPhi;
+            sinCos2Pi(v[i], sinPhi, cosPhi);
+            x[i] = r * cosPhi;
+            y[i] = r * sinPhi;
+        }
+    }
+
+    // Structure-of-arrays buffer of pre-generated samples with a read cursor
+    template <std::floating_point T>
+    class SampleBlock
+    {
+    public:
+        SampleBlock() = default;
+
+        std::size_t size() const { return m_x.size(); }
+        std::size_t remaining() const { return m_x.size() - m_cursor; }
+
+        void resize(std::size_t count)
+        {
+            m_x.resize(count);
+            m_y.resize(count);
+            m_z.resize(count);
+            m_cursor = count; // Nothing is valid until the block is filled
+        }
+
+        T *x() { return m_x.data(); }
+        T *y() { return m_y.data(); }
+        T *z() { return m_z.data(); }
+
+        void rewind() { m_cursor = 0; }
+
+        void next(T &x, T &y)
+        {
+            x = m_x[m_cursor];
+            y = m_y[m_cursor];
+            ++m_cursor;
+        }
+
+        void next(T &x, T &y, T &z)
+        {
+            x = m_x[m_cursor];
+            y = m_y[m_cursor];
+            z = m_z[m_cursor];
+            ++m_cursor;
+        }
+
+    private:
+        std::vector<T> m_x{};
+        std::vector<T> m_y{};
+        std::vector<T> m_z{};
+        std::size_t m_cursor{0};
+    };
+
+    // Block fills from one stream per key, e.g. the camera samples of a whole tile. Dimensions
+    // `dimension` and `dimension + 1` of each stream become one 2D sample.
+
+    template <std::floating_point T>
+    inline void fillUniform2D(const std::uint64_t *keys, std::uint64_t dimension, SampleBlock<T> &block, std::size_t count)
+    {
+        block.resize(count);
+        fillKeyed(keys, dimension, block.x(), count);
+        fillKeyed(keys, dimension + 1, block.y(), count);
+        block.rewind();
+    }
+
+    template <std::floating_point T>
+    inline void fillUnitDisk(const std::uint64_t *keys, std::uint64_t dimension, SampleBlock<T> &block, std::size_t count)
+    {
+        fillUniform2D(keys, dimension, block, count);
+        toUnitDisk(block.x(), block.y(), block.x(), block.y(), count);
+    }
+
+    // Per-thread source of batched samples. Consumers take one sample at a time, and a batch
+    // of one vector width is regenerated only when the current one runs out. The batches are
+    // short because the stream is restarted with a new key for every camera sample, which
+    // discards whatever is left.
+    template <std::floating_point T>
+    class SampleStream
+    {
+    public:
+        explicit SampleStream(std::uint64_t key)
+            : m_random(key), m_u(s_lanes), m_v(s_lanes)
+        {
+            discardBatches();
+        }
+
+        // Continues with value number `dimension` of the stream `key`
+        void restart(std::uint64_t key, std::uint64_t dimension)
+        {
+            m_random.restart(key, dimension);
+            discardBatches();
+        }
+
+        T uniform()
+        {
+            if (m_uniform.remaining() == 0)
+            {
+                m_random.fill(m_uniform.x(), s_lanes);
+                m_uniform.rewind();
+            }
+            T u, unused;
+            m_uniform.next(u, unused);
+            return u;
+        }
+
+        void unitSphere(T &x, T &y, T &z)
+        {
+            if (m_sphere.remaining() == 0)
+            {
+                fillUnitSphere(m_sphere, s_lanes);
+            }
+            m_sphere.next(x, y, z);
+        }
+
+        void cosineHemisphere(T &x, T &y, T &z)
+        {
+            if (m_hemisphere.remaining() == 0)
+            {
+                fillCosineHemisphere(m_hemisphere, s_lanes);
+            }
+            m_hemisphere.next(x, y, z);
+        }
+
+        void unitDisk(T &x, T &y)
+        {
+            if (m_disk.remaining() == 0)
+            {
+                fillUnitDisk(m_disk, s_lanes);
+            }
+            m_disk.next(x, y);
+        }
+
+        // Block fills, each resizes the block to count samples and rewinds it
+
+        void fillUnitSphere(SampleBlock<T> &block, std::size_t count)
+        {
+            block.resize(count);
+            fillUV(count);
+            toUnitSphere(m_u.data(), m_v.data(), block.x(), block.y(), block.z(), count);
+            block.rewind();
+        }
+
+        void fillCosineHemisphere(SampleBlock<T> &block, std::size_t count)
+        {
+            block.resize(count);
+            fillUV(count);
+            toCosineHemisphere(m_u.data(), m_v.data(), block.x(), block.y(), block.z(), count);
+            block.rewind();
+        }
+
+        void fillUnitDisk(SampleBlock<T> &block, std::size_t count)
+        {
+            block.resize(count);
+            fillUV(count);
+            toUnitDisk(m_u.data(), m_v.data(), block.x(), block.y(), count);
+            block.rewind();
+        }
+
+    private:
+        BlockRandom m_random;
+        std::vector<T> m_u;
+        std::vector<T> m_v;
+        SampleBlock<T> m_uniform{};
+        SampleBlock<T> m_sphere{};
+        SampleBlock<T> m_hemisphere{};
+        SampleBlock<T> m_disk{};
+
+        void discardBatches()
+        {
+            m_uniform.resize(s_lanes);
+            m_sphere.resize(s_lanes);
+            m_hemisphere.resize(s_lanes);
+            m_disk.resize(s_lanes);
+        }
+
+        void fillUV(std::size_t count)
+        {
+            if (m_u.size() < count)
+            {
+                m_u.resize(count);
+                m_v.resize(count);
+            }
+            m_random.fill(m_u.data(), count);
+            m_random.fill(m_v.data(), count);
+        }
+    };
+
+    // The calling thread's stream. Starts out on the default seed, so that code running outside
+    // of a render, such as scene setup, is reproducible as well.
+    template <std::floating_point T>
+    inline SampleStream<T> &threadStream()
+    {
+        thread_local SampleStream<T> stream(s_defaultSeed);
+        return stream;
+    }
+} // namespace Sampling
+
+#endif /* INONEWEEKEND_INCLUDE_SAMPLING_HPP */
@@ -0,0 +1,200 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_SCENE_CACHE_HPP
+#define INONEWEEKEND_INCLUDE_SCENE_CACHE_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bvh.hpp"
+#include "bvh_cache.hpp"
+#include "environment_map.hpp"
+#include "hittable_list.hpp"
+#include "light_list.hpp"
+#include "material.hpp"
+#include "obj_loader.hpp"
+#include "render_job.hpp"
+#include "scene_generator.hpp"
+#include "texture.hpp"
+#include "texture_cache.hpp"
+#include "texture_file.hpp"
+#include "thread_pool.hpp"
+#include "triangle_mesh.hpp"
+
+// Scenes built for earlier render jobs, with their acceleration structures, keyed by the
+// content hash of the scene input. When full, the least recently used scene is dropped.
+// Given a BVH directory, the trees also outlive the process: a scene that is not cached here
+// maps the tree saved by an earlier run instead of building it.
+template <std::floating_point T = double>
+class SceneCache
+{
+public:
+    struct Scene
+    {
+        Scene(HittableList<T> sceneWorld, const Point3<T> &sceneCenter, T sceneExtent, ThreadPool *threadPool = nullptr)
+            : world(std::move(sceneWorld)), bvh(world, BVHTree<T>::Builder::SAH, threadPool), center(sceneCenter), extent(sceneExtent)
+        {
+        }
+
+        Scene(HittableList<T> sceneWorld, BVHTree<T> tree, const Point3<T> &sceneCenter, T sceneExtent)
+            : world(std::move(sceneWorld)), bvh(world, std::move(tree)), center(sceneCenter), extent(sceneExtent)
+        {
+        }
+
+        HittableList<T> world;
+        BVH<T> bvh;
+        Point3<T> center; // Where the default camera looks
+        T extent;         // Size of the interesting part, the default camera backs off by it
+        LightList<T> lights{};
+    };
+
+    explicit SceneCache(std::size_t capacity = 4, const std::string &bvhDirectory = {})
+        : m_capacity(std::max<std::size_t>(capacity, 1)),
+          m_bvhCache(bvhDirectory.empty() ? std::nullopt : std::optional<BVHCache<T>>(bvhDirectory))
+    {
+    }
+
+    // Where get() found a scene: this cache, a saved tree for newly generated objects, or nowhere
+    enum class Origin
+    {
+        Cached,
+        Mapped,
+        Built
+    };
+
+    std::size_t capacity() const { return m_capacity; }
+
+    // Threads that build the trees of new scenes, none builds them on the calling thread
+    void setThreadPool(std::shared_ptr<ThreadPool> threadPool) { m_threadPool = std::move(threadPool); }
+    std::size_t size() const { return m_entries.size(); }
+
+    // The scene of a job, built if it is not cached; `origin` tells which
+    std::shared_ptr<const Scene> get(const RenderJob<T> &job, Origin &origin)
+    {
+        const std::uint64_t key = job.sceneKey([this](const std::string &path)
+                                               { return fileHash(path); });
+        const auto found = std::find_if(m_entries.begin(), m_entries.end(), [&](const auto &entry)
+                                        { return entry.first == key; });
+        if (found != m_entries.end())
+        {
+            m_entries.splice(m_entries.begin(), m_entries, found);
+            origin = Origin::Cached;
+            return m_entries.front().second;
+        }
+
+        bool mapped = false;
+        auto scene = build(job, key, mapped);
+        if (m_entries.size() == m_capacity)
+        {
+            m_entries.pop_back();
+        }
+        m_entries.emplace_front(key, scene);
+        origin = mapped ? Origin::Mapped : Origin::Built;
+        return scene;
+    }
+
+private:
+    std::size_t m_capacity;
+    std::list<std::pair<std::uint64_t, std::shared_ptr<const Scene>>> m_entries{}; // Most recent first
+    std::optional<BVHCache<T>> m_bvhCache;
+    std::shared_ptr<ThreadPool> m_threadPool{};
+
+    // Content hashes of scene files with the stamp they were taken at, so that a job for a
+    // file seen before does not read it whole again
+    std::unordered_map<std::string, std::pair<std::string, std::uint64_t>> m_fileHashes{};
+
+    std::uint64_t fileHash(const std::string &path)
+    {
+        auto stamp = fileStamp(path);
+        auto &[hashedStamp, hash] = m_fileHashes[path];
+        if (hashedStamp != stamp)
+        {
+            hash = fileContentHash(path);
+            hashedStamp = std::move(stamp);
+        }
+        return hash;
+    }
+
+    std::shared_ptr<const Scene> build(const RenderJob<T> &job, std::uint64_t key, bool &mapped) const
+    {
+        auto scene = buildObjects(job, key, mapped);
+        if (!job.environmentPath.empty())
+        {
+            scene->lights.setEnvironment(std::make_shared<const EnvironmentMap<T>>(EnvironmentMap<T>::loadPFM(job.environmentPath)));
+        }
+        return scene;
+    }
+
+    std::shared_ptr<Scene> buildObjects(const RenderJob<T> &job, std::uint64_t key, bool &mapped) const
+    {
+        if (!job.objPath.empty())
+        {
+            // The mesh holds the tree worth keeping, the one above it has a single object
+            const std::shared_ptr<const MeshData<T>> mesh = ObjLoader::load<T>(job.objPath);
+            const auto material = std::make_shared<Lambertial<T>>(Color<T>(0.7, 0.7, 0.7));
+            HittableList<T> world;
+            if (m_bvhCache)
+            {
+                auto tree = m_bvhCache->getOrBuild(
+                    key, mesh->triangles.size(), [&]
+                    { return buildTree(TriangleMesh<T>::triangleBounds(*mesh)); }, mapped);
+                world.add(std::make_shared<TriangleMesh<T>>(mesh, material, tree));
+            }
+            else
+            {
+                world.add(std::make_shared<TriangleMesh<T>>(mesh, material, buildTree(TriangleMesh<T>::triangleBounds(*mesh))));
+            }
+            const auto bounds = world.boundingBox();
+            const T extent = std::max({bounds.x().size(), bounds.y().size(), bounds.z().size()});
+            return std::make_shared<Scene>(std::move(world), bounds.centroid(), extent);
+        }
+
+        SceneGenerator<T> generator;
+        generator.setObjectCount(job.objectCount);
+        generator.setLayout(job.layout);
+        generator.setSizeDistribution(job.sizes);
+        generator.setMaterialPaletteSize(job.paletteSize);
+        generator.setSeed(job.sceneSeed);
+        if (!job.texturePaths.empty())
+        {
+            // The textures of a scene share one cache, which their materials keep alive
+            const auto textureCache = std::make_shared<TextureCache>(job.textureCacheMiB << 20);
+            std::vector<std::shared_ptr<const Texture<T>>> textures;
+            for (const auto &path : job.texturePaths)
+            {
+                textures.push_back(std::make_shared<ImageTexture<T>>(textureCache, std::make_shared<const TextureFile>(path)));
+            }
+            generator.setAlbedoTextures(std::move(textures));
+        }
+        auto world = generator.generate();
+        if (m_bvhCache)
+        {
+            auto tree = m_bvhCache->getOrBuild(
+                key, world.objects().size(), [&]
+                { return buildTree(BVH<T>::objectBounds(world, m_threadPool.get())); }, mapped);
+            return std::make_shared<Scene>(std::move(world), std::move(tree), Point3<T>(0, 0, 0), generator.extent());
+        }
+        return std::make_shared<Scene>(std::move(world), Point3<T>(0, 0, 0), generator.extent(), m_threadPool.get());
+    }
+
+    BVHTree<T> buildTree(const std::vector<AABB<T>> &bounds) const
+    {
+        return BVHTree<T>(bounds, BVHTree<T>::Builder::SAH, m_threadPool.get());
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_SCENE_CACHE_HPP */
@@ -0,0 +1,56 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_SCENE_EDITOR_HPP
+#define INONEWEEKEND_INCLUDE_SCENE_EDITOR_HPP
+
+#include <concepts>
+#include <memory>
+#include <utility>
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "material.hpp"
+#include "sphere.hpp"
+#include "vector3.hpp"
+
+// Edits to a scene between the frames of an incremental render (Camera::setIncremental). Each
+// edit changes the scene and tells the camera which tiles it touches, so that the next frame
+// only traces those. Edits must not overlap a render.
+template <std::floating_point T = double>
+class SceneEditor
+{
+public:
+    SceneEditor(BVH<T> &bvh, Camera<T> &camera)
+        : m_bvh(bvh), m_camera(camera)
+    {
+    }
+
+    // Swaps the material of a sphere or mesh: only what it showed in changes
+    template <typename Primitive>
+    void setMaterial(Primitive &primitive, std::shared_ptr<Material<T>> material)
+    {
+        primitive.setMaterial(std::move(material));
+        m_camera.invalidate(&primitive);
+    }
+
+    // Moves a sphere: what it showed in changes, and so do the pixels where it was or now is
+    void move(Sphere<T> &sphere, const Point3<T> &center)
+    {
+        const auto before = sphere.boundingBox();
+        sphere.setCenter(center);
+        m_bvh.refit();
+        m_camera.invalidate(&sphere, AABB<T>(before, sphere.boundingBox()));
+    }
+
+private:
+    BVH<T> &m_bvh;
+    Camera<T> &m_camera;
+};
+
+#endif /* INONEWEEKEND_INCLUDE_SCENE_EDITOR_HPP */
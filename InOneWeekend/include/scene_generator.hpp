@@ -0,0 +1,227 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_SCENE_GENERATOR_HPP
+#define INONEWEEKEND_INCLUDE_SCENE_GENERATOR_HPP
+
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "color.hpp"
+#include "hittable_list.hpp"
+#include "material.hpp"
+#include "texture.hpp"
+#include "sphere.hpp"
+#include "util.hpp"
+#include "vector3.hpp"
+
+// Deterministic procedural sphere scenes for stress testing. The same parameters always
+// produce the same scene, independent of the global random state used while rendering.
+template <std::floating_point T = double>
+class SceneGenerator
+{
+public:
+    enum class Layout
+    {
+        Field,  // Spheres resting on a ground sphere, like the book's final scene
+        Volume, // Spheres scattered through a cube
+    };
+
+    enum class SizeDistribution
+    {
+        Uniform,   // Radii uniform in [minRadius, maxRadius]
+        LogNormal, // Mostly small radii with a long tail, clamped to [minRadius, maxRadius]
+        PowerLaw,  // Many tiny and few huge spheres, p(r) ~ r^-3 on [minRadius, maxRadius]
+    };
+
+    SceneGenerator() = default;
+
+    std::size_t objectCount() const { return m_objectCount; }
+    Layout layout() const { return m_layout; }
+    SizeDistribution sizeDistribution() const { return m_sizeDistribution; }
+    T minRadius() const { return m_minRadius; }
+    T maxRadius() const { return m_maxRadius; }
+    std::uint64_t seed() const { return m_seed; }
+
+    void setObjectCount(std::size_t objectCount) { m_objectCount = objectCount; }
+    void setLayout(Layout layout) { m_layout = layout; }
+    void setSizeDistribution(SizeDistribution sizeDistribution) { m_sizeDistribution = sizeDistribution; }
+    void setRadiusRange(T minRadius, T maxRadius)
+    {
+        m_minRadius = minRadius;
+        m_maxRadius = maxRadius;
+    }
+    void setSeed(std::uint64_t seed) { m_seed = seed; }
+
+    void setMaterialMix(T diffuse, T metal, T glass)
+    {
+        // Relative weights of Lambertial, Metal and Dielectric materials
+        const T total = diffuse + metal + glass;
+        m_diffuseFraction = diffuse / total;
+        m_metalFraction = metal / total;
+    }
+
+    void setMaterialPaletteSize(std::size_t paletteSize)
+    {
+        // Number of distinct materials shared among all spheres
+        // 0 gives every sphere its own material, like the scene in main.cpp
+        m_paletteSize = paletteSize;
+    }
+
+    void setAlbedoTextures(std::vector<std::shared_ptr<const Texture<T>>> textures)
+    {
+        // Diffuse and metal spheres take their albedo from one of these, picked at random
+        // Empty gives them constant colors
+        m_albedoTextures = std::move(textures);
+    }
+
+    // Average distance between neighbouring sphere centers; the region grows with the object
+    // count so that density, and therefore the work per ray, stays comparable across sizes
+    T spacing() const { return 2 * m_maxRadius + m_minRadius; }
+
+    T extent() const
+    {
+        const auto count = static_cast<T>(m_objectCount);
+        const T perSide = (m_layout == Layout::Field) ? std::sqrt(count) : std::cbrt(count);
+        return std::ceil(perSide) * spacing();
+    }
+
+    HittableList<T> generate() const
+    {
+        std::mt19937_64 engine(m_seed);
+
+        std::vector<std::shared_ptr<Material<T>>> palette;
+        palette.reserve(m_paletteSize);
+        for (std::size_t i = 0; i < m_paletteSize; ++i)
+        {
+            palette.push_back(makeMaterial(engine));
+        }
+
+        std::vector<std::shared_ptr<Hittable<T>>> objects;
+        objects.reserve(m_objectCount + 1);
+
+        const T halfExtent = extent() / 2;
+        if (m_layout == Layout::Field)
+        {
+            const T groundRadius = 1000 * (1 + halfExtent);
+            const auto groundMaterial = std::make_shared<Lambertial<T>>(Color<T>(0.5, 0.5, 0.5));
+            objects.push_back(std::make_shared<Sphere<T>>(Point3<T>(0, -groundRadius, 0), groundRadius, groundMaterial));
+        }
+
+        for (std::size_t i = 0; i < m_objectCount; ++i)
+        {
+            const T radius = sampleRadius(engine);
+            const T x = uniform(engine, -halfExtent, halfExtent);
+            const T z = uniform(engine, -halfExtent, halfExtent);
+            const T y = (m_layout == Layout::Field) ? radius : uniform(engine, -halfExtent, halfExtent);
+
+            auto material = palette.empty()
+                                ? makeMaterial(engine)
+                                : palette[static_cast<std::size_t>(engine() % palette.size())];
+            objects.push_back(std::make_shared<Sphere<T>>(Point3<T>(x, y, z), radius, material));
+        }
+
+        return HittableList<T>(objects);
+    }
+
+private:
+    std::size_t m_objectCount{1000};
+    Layout m_layout{Layout::Field};
+    SizeDistribution m_sizeDistribution{SizeDistribution::Uniform};
+    T m_minRadius{0.1};
+    T m_maxRadius{0.3};
+    T m_diffuseFraction{0.8}; // Same mix as the scene in main.cpp
+    T m_metalFraction{0.15};
+    std::size_t m_paletteSize{0};
+    std::uint64_t m_seed{1};
+    std::vector<std::shared_ptr<const Texture<T>>> m_albedoTextures{};
+
+    // Standard distributions are implementation defined, so draw reals from raw engine bits
+    // to get the same scene on every platform
+    static T uniform(std::mt19937_64 &engine)
+    {
+        return static_cast<T>(static_cast<double>(engine() >> 11) * 0x1.0p-53);
+    }
+
+    static T uniform(std::mt19937_64 &engine, T min, T max)
+    {
+        return min + (max - min) * uniform(engine);
+    }
+
+    Color<T> randomColor(std::mt19937_64 &engine, T min, T max) const
+    {
+        const T r = uniform(engine, min, max);
+        const T g = uniform(engine, min, max);
+        const T b = uniform(engine, min, max);
+        return Color<T>(r, g, b);
+    }
+
+    T sampleRadius(std::mt19937_64 &engine) const
+    {
+        const T u = uniform(engine);
+        switch (m_sizeDistribution)
+        {
+        case SizeDistribution::LogNormal:
+        {
+            // Box-Muller transform, median at the geometric mean of the range
+            const T v = uniform(engine);
+            const T normal = std::sqrt(-2 * std::log(1 - u)) * std::cos(2 * pi<T> * v);
+            const T median = std::sqrt(m_minRadius * m_maxRadius);
+            const T sigma = std::log(m_maxRadius / m_minRadius) / 4;
+            const T radius = median * std::exp(sigma * normal);
+            return radius < m_minRadius ? m_minRadius : (radius > m_maxRadius ? m_maxRadius : radius);
+        }
+        case SizeDistribution::PowerLaw:
+        {
+            // Inverse CDF of p(r) ~ r^-3 on [minRadius, maxRadius]
+            const T a = 1 / (m_minRadius * m_minRadius);
+            const T b = 1 / (m_maxRadius * m_maxRadius);
+            return 1 / std::sqrt(a - u * (a - b));
+        }
+        case SizeDistribution::Uniform:
+        default:
+            return m_minRadius + u * (m_maxRadius - m_minRadius);
+        }
+    }
+
+    // Drawn only when there are textures, so that untextured scenes stay as they were
+    std::shared_ptr<const Texture<T>> albedoTexture(std::mt19937_64 &engine) const
+    {
+        return m_albedoTextures[static_cast<std::size_t>(engine() % m_albedoTextures.size())];
+    }
+
+    std::shared_ptr<Material<T>> makeMaterial(std::mt19937_64 &engine) const
+    {
+        const T chooseMaterial = uniform(engine);
+        if (chooseMaterial < m_diffuseFraction)
+        {
+            const auto albedo = randomColor(engine, 0, 1) * randomColor(engine, 0, 1);
+            if (!m_albedoTextures.empty())
+            {
+                return std::make_shared<Lambertial<T>>(albedoTexture(engine));
+            }
+            return std::make_shared<Lambertial<T>>(albedo);
+        }
+        if (chooseMaterial < m_diffuseFraction + m_metalFraction)
+        {
+            const auto albedo = randomColor(engine, 0.5, 1);
+            const T fuzz = uniform(engine, 0, 0.5);
+            if (!m_albedoTextures.empty())
+            {
+                return std::make_shared<Metal<T>>(albedoTexture(engine), fuzz);
+            }
+            return std::make_shared<Metal<T>>(albedo, fuzz);
+        }
+        return std::make_shared<Dielectric<T>>(1.5);
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_SCENE_GENERATOR_HPP */
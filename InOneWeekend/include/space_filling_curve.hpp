@@ -0,0 +1,152 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_SPACE_FILLING_CURVE_HPP
+#define INONEWEEKEND_INCLUDE_SPACE_FILLING_CURVE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Orders in which the cells of a 2D grid, such as render tiles or the pixels of a tile, are
+// visited. Along a space-filling curve consecutive cells are neighbours, so consecutive work
+// items trace rays into the same part of the scene and find its nodes still in cache.
+namespace SpaceFillingCurve
+{
+    enum class Order
+    {
+        RowMajor, // Left to right, then top to bottom
+        Morton,   // Z-order, interleaved coordinate bits
+        Hilbert,  // Hilbert curve, every step moves to an edge neighbour
+    };
+
+    inline constexpr std::string_view name(Order order)
+    {
+        switch (order)
+        {
+        case Order::Morton:
+            return "morton";
+        case Order::Hilbert:
+            return "hilbert";
+        default:
+            return "row-major";
+        }
+    }
+
+    // Keeps the even bits of v, packed into the low half
+    inline constexpr std::uint32_t compactBits(std::uint64_t v)
+    {
+        v &= 0x5555555555555555ull;
+        v = (v | (v >> 1)) & 0x3333333333333333ull;
+        v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v >> 4)) & 0x00FF00FF00FF00FFull;
+        v = (v | (v >> 8)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+        return static_cast<std::uint32_t>(v);
+    }
+
+    // Spreads the low 10 bits of v three bits apart
+    inline constexpr std::uint32_t spreadBits3(std::uint32_t v)
+    {
+        v &= 0x000003FFu;
+        v = (v | (v << 16)) & 0xFF0000FFu;
+        v = (v | (v << 8)) & 0x0300F00Fu;
+        v = (v | (v << 4)) & 0x030C30C3u;
+        v = (v | (v << 2)) & 0x09249249u;
+        return v;
+    }
+
+    // 30-bit Z-order index of a cell of a 1024^3 grid
+    inline constexpr std::uint32_t mortonEncode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+    {
+        return spreadBits3(x) | (spreadBits3(y) << 1) | (spreadBits3(z) << 2);
+    }
+
+    inline constexpr void mortonDecode(std::uint64_t index, std::uint32_t &x, std::uint32_t &y)
+    {
+        x = compactBits(index);
+        y = compactBits(index >> 1);
+    }
+
+    // Cell number `index` along the Hilbert curve through a side x side grid, side a power of two
+    inline constexpr void hilbertDecode(std::uint32_t side, std::uint64_t index, std::uint32_t &x, std::uint32_t &y)
+    {
+        x = 0;
+        y = 0;
+        for (std::uint32_t s = 1; s < side; s *= 2)
+        {
+            const auto rx = static_cast<std::uint32_t>(1 & (index / 2));
+            const auto ry = static_cast<std::uint32_t>(1 & (index ^ rx));
+
+            // Rotate the quadrant so that the sub-curves join up
+            if (ry == 0)
+            {
+                if (rx == 1)
+                {
+                    x = s - 1 - x;
+                    y = s - 1 - y;
+                }
+                const auto t = x;
+                x = y;
+                y = t;
+            }
+
+            x += s * rx;
+            y += s * ry;
+            index /= 4;
+        }
+    }
+
+    // All cells of a width x height grid as {x, y} in the given order. The curves are walked over
+    // the enclosing power of two square and cells outside the grid are skipped.
+    inline std::vector<std::array<std::uint32_t, 2>> traverse(std::uint32_t width, std::uint32_t height, Order order)
+    {
+        std::vector<std::array<std::uint32_t, 2>> cells;
+        cells.reserve(static_cast<std::size_t>(width) * height);
+
+        if (order == Order::RowMajor)
+        {
+            for (std::uint32_t y = 0; y < height; ++y)
+            {
+                for (std::uint32_t x = 0; x < width; ++x)
+                {
+                    cells.push_back({x, y});
+                }
+            }
+            return cells;
+        }
+
+        std::uint32_t side = 1;
+        while (side < width || side < height)
+        {
+            side *= 2;
+        }
+
+        const std::uint64_t numCells = static_cast<std::uint64_t>(side) * side;
+        for (std::uint64_t index = 0; index < numCells; ++index)
+        {
+            std::uint32_t x = 0, y = 0;
+            if (order == Order::Morton)
+            {
+                mortonDecode(index, x, y);
+            }
+            else
+            {
+                hilbertDecode(side, index, x, y);
+            }
+
+            if (x < width && y < height)
+            {
+                cells.push_back({x, y});
+            }
+        }
+        return cells;
+    }
+} // namespace SpaceFillingCurve
+
+#endif /* INONEWEEKEND_INCLUDE_SPACE_FILLING_CURVE_HPP */
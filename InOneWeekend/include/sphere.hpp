@@ -8,30 +8,62 @@
 #ifndef INONEWEEKEND_INCLUDE_SPHERE_HPP
 #define INONEWEEKEND_INCLUDE_SPHERE_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <concepts>
 #include <memory>
+#include <stdexcept>
+#include <utility>
 
+#include "aabb.hpp"
 #include "hittable.hpp"
 #include "vector3.hpp"
 #include "interval.hpp"
 #include "material_forward_decl.hpp"
+#include "onb.hpp"
+#include "util.hpp"
 
 template <std::floating_point T = double>
 class Sphere : public Hittable<T>
 {
 public:
     constexpr Sphere(const Point3<T> &center, T radius, std::shared_ptr<Material<T>> material)
-        : m_center(center), m_radius(radius), m_material(material) {}
+        : m_center(center), m_radius(radius), m_material(material),
+          m_bbox(center - Vector3<T>(radius, radius, radius), center + Vector3<T>(radius, radius, radius))
+    {
+        // The render kernels rely on every hit having a material
+        if (!m_material)
+        {
+            throw std::invalid_argument("Sphere: null material");
+        }
+    }
 
     virtual ~Sphere() override = default;
 
     constexpr const Point3<T> &center() const { return m_center; }
     constexpr T radius() const { return m_radius; }
+    constexpr const std::shared_ptr<Material<T>> &material() const { return m_material; }
 
-    virtual bool hit(
+    // Scene edits between frames, see SceneEditor. A BVH over moved spheres must be refit.
+    void setCenter(const Point3<T> &center)
+    {
+        m_center = center;
+        m_bbox = AABB<T>(center - Vector3<T>(m_radius, m_radius, m_radius), center + Vector3<T>(m_radius, m_radius, m_radius));
+    }
+
+    void setMaterial(std::shared_ptr<Material<T>> material)
+    {
+        if (!material)
+        {
+            throw std::invalid_argument("Sphere: null material");
+        }
+        m_material = std::move(material);
+    }
+
+    virtual bool intersect(
         const Ray<T> &r,
         Interval<T> rayT,
-        HitRecord<T> &record) const override
+        SurfaceHit<T> &surface) const override
     {
         const auto oc = m_center - r.origin();
         const auto a = r.direction().squaredNorm();
@@ -57,19 +89,111 @@ public:
             }
         }
 
-        record.setT(root);
-        record.setPoint(r.at(root));
+        surface = SurfaceHit<T>{root, this, 0};
+        return true;
+    }
+
+    virtual void surfaceAttributes(
+        const Ray<T> &r,
+        const SurfaceHit<T> &surface,
+        HitRecord<T> &record) const override
+    {
+        record.setT(surface.t);
+        record.setPoint(r.at(surface.t));
         const auto outwardNormal = (record.point() - m_center) / m_radius;
         record.setNormal(r, outwardNormal);
-        record.setMaterial(m_material);
+        record.setMaterial(m_material.get());
+        record.setObject(this);
+    }
 
-        return true;
+    virtual TextureCoordinates<T> textureCoordinates(const HitRecord<T> &record) const override
+    {
+        // Longitude and latitude, with v running from the bottom pole to the top
+        const auto p = (record.point() - m_center) / m_radius;
+        const T theta = std::acos(std::clamp(-p.y(), static_cast<T>(-1), static_cast<T>(1)));
+        const T phi = std::atan2(-p.z(), p.x()) + pi<T>;
+        return {phi / (2 * pi<T>), theta / pi<T>, 1 / (pi<T> * m_radius)};
+    }
+
+    virtual bool occluded(
+        const Ray<T> &r,
+        Interval<T> rayT) const override
+    {
+        const auto oc = m_center - r.origin();
+        const auto a = r.direction().squaredNorm();
+        const auto h = dot(r.direction(), oc);
+        const auto c = oc.squaredNorm() - m_radius * m_radius;
+        const auto discriminant = h * h - a * c;
+
+        if (discriminant < 0)
+        {
+            return false;
+        }
+
+        const auto sqrtD = std::sqrt(discriminant);
+        return rayT.surrounds((h - sqrtD) / a) || rayT.surrounds((h + sqrtD) / a);
+    }
+
+    virtual T pdfValue(const Point3<T> &origin, const Vector3<T> &direction) const override
+    {
+        // Directions towards the sphere are sampled uniformly over the cone it subtends
+        SurfaceHit<T> surface;
+        if (!intersect(Ray<T>(origin, direction), Interval<T>(static_cast<T>(0.001), infinity<T>), surface))
+        {
+            return 0;
+        }
+
+        const T distanceSquared = (m_center - origin).squaredNorm();
+        const T radiusSquared = m_radius * m_radius;
+        if (distanceSquared <= radiusSquared)
+        {
+            // Inside the sphere every direction sees it, so fall back to the uniform sphere
+            return 1 / (4 * pi<T>);
+        }
+
+        const T cosThetaMax = std::sqrt(1 - radiusSquared / distanceSquared);
+        const T solidAngle = 2 * pi<T> * (1 - cosThetaMax);
+        return 1 / solidAngle;
+    }
+
+    virtual Vector3<T> sampleDirection(const Point3<T> &origin) const override
+    {
+        const Vector3<T> direction = m_center - origin;
+        const T distanceSquared = direction.squaredNorm();
+        const T radiusSquared = m_radius * m_radius;
+        if (distanceSquared <= radiusSquared)
+        {
+            return randomUnitVector<T>();
+        }
+
+        const ONB<T> basis(direction);
+        return basis.transform(randomToSphere(radiusSquared, distanceSquared));
+    }
+
+    virtual bool onlyDiffuse() const override { return m_material->isDiffuse(); }
+
+    virtual AABB<T> boundingBox() const override
+    {
+        return m_bbox;
     }
 
 private:
+    static Vector3<T> randomToSphere(T radiusSquared, T distanceSquared)
+    {
+        // Uniform direction within the cone of half angle thetaMax around +z
+        const T r1 = Util::random<T>();
+        const T r2 = Util::random<T>();
+        const T cosThetaMax = std::sqrt(1 - radiusSquared / distanceSquared);
+        const T z = 1 + r2 * (cosThetaMax - 1);
+        const T sinTheta = std::sqrt(1 - z * z);
+        const T phi = 2 * pi<T> * r1;
+        return Vector3<T>(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, z);
+    }
+
     Point3<T> m_center;
     T m_radius;
     std::shared_ptr<Material<T>> m_material;
+    AABB<T> m_bbox;
 };
 
 #endif /* INONEWEEKEND_INCLUDE_SPHERE_HPP */
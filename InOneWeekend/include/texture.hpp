@@ -0,0 +1,121 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_TEXTURE_HPP
+#define INONEWEEKEND_INCLUDE_TEXTURE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "color.hpp"
+#include "hittable.hpp"
+#include "texture_cache.hpp"
+#include "texture_file.hpp"
+
+// A color that varies over surfaces, such as the albedo of a material
+template <std::floating_point T = double>
+class Texture
+{
+public:
+    virtual ~Texture() = default;
+
+    virtual Color<T> value(const HitRecord<T> &record) const = 0;
+};
+
+// A texture file read through a TextureCache. Lookups filter bilinearly on the mip level whose
+// texels are about as wide as the ray's footprint (see HitRecord::rayWidth), so rays that see
+// the texture small, or from behind a rough bounce, read the few tiles of a coarse level instead
+// of scattering over the full resolution one.
+template <std::floating_point T = double>
+class ImageTexture : public Texture<T>
+{
+public:
+    ImageTexture(std::shared_ptr<TextureCache> cache, std::shared_ptr<const TextureFile> file)
+        : m_cache(std::move(cache)), m_file(std::move(file))
+    {
+        if (!m_cache || !m_file)
+        {
+            throw std::invalid_argument("ImageTexture: null cache or file");
+        }
+    }
+
+    virtual ~ImageTexture() override = default;
+
+    const std::shared_ptr<const TextureFile> &file() const { return m_file; }
+
+    virtual Color<T> value(const HitRecord<T> &record) const override
+    {
+        const auto coordinates = (record.object() != nullptr) ? record.object()->textureCoordinates(record) : TextureCoordinates<T>{};
+
+        const T footprint = record.rayWidth() * coordinates.scale * static_cast<T>(std::max(m_file->width(0), m_file->height(0)));
+        const auto coarsest = static_cast<int>(m_file->numLevels()) - 1;
+        const auto level = static_cast<std::uint32_t>((footprint > 1) ? std::min(static_cast<int>(std::log2(footprint)), coarsest) : 0);
+
+        // Texel centers sit at half-integer positions; v runs up while rows run down
+        const auto width = static_cast<T>(m_file->width(level));
+        const auto height = static_cast<T>(m_file->height(level));
+        const T x = std::clamp(coordinates.u, static_cast<T>(0), static_cast<T>(1)) * width - static_cast<T>(0.5);
+        const T y = (1 - std::clamp(coordinates.v, static_cast<T>(0), static_cast<T>(1))) * height - static_cast<T>(0.5);
+        const T x0 = std::floor(x);
+        const T y0 = std::floor(y);
+        const T fx = x - x0;
+        const T fy = y - y0;
+
+        TileReference tile;
+        const auto texel = [&](T tx, T ty)
+        {
+            return fetch(level, std::clamp(tx, static_cast<T>(0), width - 1), std::clamp(ty, static_cast<T>(0), height - 1), tile);
+        };
+        return Color<T>((1 - fy) * ((1 - fx) * texel(x0, y0) + fx * texel(x0 + 1, y0)) +
+                        fy * ((1 - fx) * texel(x0, y0 + 1) + fx * texel(x0 + 1, y0 + 1)));
+    }
+
+private:
+    // The tile of the last texel fetched, as the texels of one lookup mostly share a tile
+    struct TileReference
+    {
+        std::uint32_t index{0};
+        std::shared_ptr<const TextureCache::Tile> texels{};
+    };
+
+    std::shared_ptr<TextureCache> m_cache;
+    std::shared_ptr<const TextureFile> m_file;
+
+    static inline const std::array<T, 256> s_decoded = []
+    {
+        std::array<T, 256> decoded{};
+        for (std::uint32_t byte = 0; byte < decoded.size(); ++byte)
+        {
+            decoded[byte] = TextureFile::decode<T>(byte);
+        }
+        return decoded;
+    }();
+
+    Color<T> fetch(std::uint32_t level, T x, T y, TileReference &tile) const
+    {
+        const auto texelX = static_cast<std::uint32_t>(x);
+        const auto texelY = static_cast<std::uint32_t>(y);
+        const auto index = m_file->tileIndex(level, texelX, texelY);
+        if (!tile.texels || tile.index != index)
+        {
+            tile.index = index;
+            tile.texels = m_cache->tile(*m_file, index);
+        }
+
+        const std::uint32_t tileSize = m_file->tileSize();
+        const auto *bytes = tile.texels->data() + 3 * (static_cast<std::size_t>(texelY % tileSize) * tileSize + texelX % tileSize);
+        return Color<T>(s_decoded[bytes[0]], s_decoded[bytes[1]], s_decoded[bytes[2]]);
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_TEXTURE_HPP */
@@ -0,0 +1,131 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_TEXTURE_CACHE_HPP
+#define INONEWEEKEND_INCLUDE_TEXTURE_CACHE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "texture_file.hpp"
+
+// Tiles of texture files in memory, at most capacity bytes of them, evicting the least recently
+// used tile when a new one does not fit. However large the textures of a scene are, a render
+// only holds the tiles it looked at lately, plus the few its threads are filtering right now.
+//
+// Lookups are thread-safe. Tiles are spread over shards by their key, each with its own lock and
+// LRU list, so that threads rarely wait on each other; a missing tile is read with no lock held.
+// Two threads missing the same tile may both read it, and the second keeps the first's copy.
+class TextureCache
+{
+public:
+    using Tile = std::vector<std::uint8_t>;
+
+    struct Statistics
+    {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};    // Tiles read from their file
+        std::uint64_t evictions{0};
+        std::size_t residentBytes{0};
+        std::size_t peakBytes{0};   // Most resident at once, summed over the shards
+
+        double hitRate() const { return (hits + misses > 0) ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 1.0; }
+    };
+
+    explicit TextureCache(std::size_t capacityBytes)
+        : m_capacity(capacityBytes)
+    {
+    }
+
+    TextureCache(const TextureCache &) = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+
+    std::size_t capacity() const { return m_capacity; }
+
+    // Tile index of file, read from the file if it is not in memory
+    std::shared_ptr<const Tile> tile(const TextureFile &file, std::uint32_t index)
+    {
+        const std::uint64_t key = (static_cast<std::uint64_t>(file.id()) << 32) | index;
+        auto &shard = m_shards[static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) % s_numShards];
+        {
+            const std::scoped_lock lock(shard.mutex);
+            if (const auto found = shard.entries.find(key); found != shard.entries.end())
+            {
+                shard.order.splice(shard.order.begin(), shard.order, found->second);
+                ++shard.statistics.hits;
+                return found->second->second;
+            }
+        }
+
+        auto loaded = std::make_shared<Tile>();
+        file.readTile(index, *loaded);
+
+        const std::scoped_lock lock(shard.mutex);
+        ++shard.statistics.misses;
+        if (const auto found = shard.entries.find(key); found != shard.entries.end())
+        {
+            shard.order.splice(shard.order.begin(), shard.order, found->second);
+            return found->second->second;
+        }
+
+        shard.order.emplace_front(key, loaded);
+        shard.entries.emplace(key, shard.order.begin());
+        shard.statistics.residentBytes += loaded->size();
+
+        // The new tile stays even if it alone exceeds the shard's share
+        const std::size_t shardCapacity = m_capacity / s_numShards;
+        while (shard.statistics.residentBytes > shardCapacity && shard.order.size() > 1)
+        {
+            const auto &[oldKey, oldTile] = shard.order.back();
+            shard.statistics.residentBytes -= oldTile->size();
+            ++shard.statistics.evictions;
+            shard.entries.erase(oldKey);
+            shard.order.pop_back();
+        }
+        shard.statistics.peakBytes = std::max(shard.statistics.peakBytes, shard.statistics.residentBytes);
+        return loaded;
+    }
+
+    Statistics statistics() const
+    {
+        Statistics total;
+        for (const auto &shard : m_shards)
+        {
+            const std::scoped_lock lock(shard.mutex);
+            total.hits += shard.statistics.hits;
+            total.misses += shard.statistics.misses;
+            total.evictions += shard.statistics.evictions;
+            total.residentBytes += shard.statistics.residentBytes;
+            total.peakBytes += shard.statistics.peakBytes;
+        }
+        return total;
+    }
+
+private:
+    static constexpr std::size_t s_numShards = 16;
+
+    struct Shard
+    {
+        mutable std::mutex mutex{};
+        std::list<std::pair<std::uint64_t, std::shared_ptr<const Tile>>> order{}; // Most recently used first
+        std::unordered_map<std::uint64_t, decltype(order)::iterator> entries{};
+        Statistics statistics{};
+    };
+
+    std::size_t m_capacity;
+    std::array<Shard, s_numShards> m_shards{};
+};
+
+#endif /* INONEWEEKEND_INCLUDE_TEXTURE_CACHE_HPP */
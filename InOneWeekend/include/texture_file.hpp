@@ -0,0 +1,322 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_TEXTURE_FILE_HPP
+#define INONEWEEKEND_INCLUDE_TEXTURE_FILE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "color.hpp"
+
+// Fixed-size start of a texture file. The tiles follow at tileOffset, level by level from the
+// full resolution down to 1x1, each level's tiles row by row.
+struct TextureFileHeader
+{
+    std::array<char, 8> magic{};
+    std::uint32_t version{0};
+    std::uint32_t byteOrder{0}; // s_byteOrder as written
+    std::uint32_t width{0};     // Of the full resolution level
+    std::uint32_t height{0};
+    std::uint32_t tileSize{0};  // Texels along each side of a tile
+    std::uint32_t numLevels{0};
+    std::uint64_t tileOffset{0};
+};
+
+// An image texture on disk as a mip-map pyramid cut into square tiles, so that a render reads
+// only the tiles of the levels it looks at, through a TextureCache, instead of the whole image.
+// Texels are three bytes, gamma encoded like the images the renderer writes. Tiles at the right
+// and bottom edges are padded with the edge texels, so every tile has the same size and is
+// found by its index alone.
+//
+// Opening a file only reads its header. Tiles are read with pread(), so any number of threads
+// can read from one open file.
+class TextureFile
+{
+public:
+    static constexpr std::array<char, 8> s_magic{'R', 'T', 'T', 'E', 'X', '\0', '\0', '\0'};
+    static constexpr std::uint32_t s_version = 1;
+    static constexpr std::uint32_t s_byteOrder = 0x01020304;
+    static constexpr std::uint32_t s_defaultTileSize = 64;
+
+    explicit TextureFile(const std::string &path)
+        : m_path(path), m_id(s_nextId.fetch_add(1))
+    {
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("TextureFile: cannot open " + path);
+        }
+
+        const auto size = ::lseek(m_fd, 0, SEEK_END);
+        if (size < 0 || ::pread(m_fd, &m_header, sizeof(m_header), 0) != static_cast<ssize_t>(sizeof(m_header)) ||
+            m_header.magic != s_magic || m_header.version != s_version || m_header.byteOrder != s_byteOrder ||
+            m_header.width == 0 || m_header.height == 0 || m_header.tileSize == 0 ||
+            m_header.numLevels != levelCount(m_header.width, m_header.height))
+        {
+            ::close(m_fd);
+            throw std::runtime_error("TextureFile: " + path + " is not a texture file of this version");
+        }
+
+        std::uint64_t numTiles = 0;
+        for (std::uint32_t level = 0; level < m_header.numLevels; ++level)
+        {
+            m_firstTiles.push_back(static_cast<std::uint32_t>(numTiles));
+            numTiles += static_cast<std::uint64_t>(tilesX(level)) * tilesY(level);
+        }
+        if (numTiles > (static_cast<std::uint64_t>(size) - std::min<std::uint64_t>(m_header.tileOffset, static_cast<std::uint64_t>(size))) / tileBytes())
+        {
+            ::close(m_fd);
+            throw std::runtime_error("TextureFile: " + path + " is truncated");
+        }
+    }
+
+    TextureFile(const TextureFile &) = delete;
+    TextureFile &operator=(const TextureFile &) = delete;
+
+    ~TextureFile()
+    {
+        ::close(m_fd);
+    }
+
+    const std::string &path() const { return m_path; }
+    std::uint32_t id() const { return m_id; } // Unique among the files opened by this process
+    std::uint32_t numLevels() const { return m_header.numLevels; }
+    std::uint32_t tileSize() const { return m_header.tileSize; }
+    std::size_t tileBytes() const { return 3 * static_cast<std::size_t>(m_header.tileSize) * m_header.tileSize; }
+
+    std::uint32_t width(std::uint32_t level) const { return std::max(m_header.width >> level, 1u); }
+    std::uint32_t height(std::uint32_t level) const { return std::max(m_header.height >> level, 1u); }
+    std::uint32_t tilesX(std::uint32_t level) const { return (width(level) + m_header.tileSize - 1) / m_header.tileSize; }
+    std::uint32_t tilesY(std::uint32_t level) const { return (height(level) + m_header.tileSize - 1) / m_header.tileSize; }
+
+    // Index of the tile holding texel (x, y) of a level, among all tiles of the file
+    std::uint32_t tileIndex(std::uint32_t level, std::uint32_t x, std::uint32_t y) const
+    {
+        return m_firstTiles[level] + (y / m_header.tileSize) * tilesX(level) + x / m_header.tileSize;
+    }
+
+    // Reads a tile's texels, row by row, into tile
+    void readTile(std::uint32_t index, std::vector<std::uint8_t> &tile) const
+    {
+        tile.resize(tileBytes());
+        const auto offset = static_cast<off_t>(m_header.tileOffset + static_cast<std::uint64_t>(index) * tileBytes());
+        std::size_t done = 0;
+        while (done < tile.size())
+        {
+            const auto count = ::pread(m_fd, tile.data() + done, tile.size() - done, offset + static_cast<off_t>(done));
+            if (count <= 0)
+            {
+                throw std::runtime_error("TextureFile: cannot read a tile of " + m_path);
+            }
+            done += static_cast<std::size_t>(count);
+        }
+    }
+
+    // Levels from width x height halving down to 1x1
+    static std::uint32_t levelCount(std::uint32_t width, std::uint32_t height)
+    {
+        std::uint32_t levels = 1;
+        while ((width >> (levels - 1)) > 1 || (height >> (levels - 1)) > 1)
+        {
+            ++levels;
+        }
+        return levels;
+    }
+
+    // Writes linear colors, row by row, as a texture file. Each level is the box filtered level
+    // above it, filtered in linear color. The file is written next to its final name and renamed,
+    // so a texture being opened is never half written.
+    template <std::floating_point T>
+    static void write(const std::string &path, std::uint32_t width, std::uint32_t height, std::vector<Color<T>> texels,
+                      std::uint32_t tileSize = s_defaultTileSize)
+    {
+        if (width == 0 || height == 0 || tileSize == 0 || texels.size() != static_cast<std::size_t>(width) * height)
+        {
+            throw std::invalid_argument("TextureFile: texels do not match the size " + std::to_string(width) + "x" + std::to_string(height));
+        }
+
+        TextureFileHeader header;
+        header.magic = s_magic;
+        header.version = s_version;
+        header.byteOrder = s_byteOrder;
+        header.width = width;
+        header.height = height;
+        header.tileSize = tileSize;
+        header.numLevels = levelCount(width, height);
+        header.tileOffset = s_tileAlignment;
+
+        const std::string temporaryPath = path + ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            const std::array<char, s_tileAlignment - sizeof(header)> padding{};
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(padding.data(), padding.size());
+
+            std::vector<char> tile(3 * static_cast<std::size_t>(tileSize) * tileSize);
+            for (std::uint32_t level = 0; level < header.numLevels; ++level)
+            {
+                const std::uint32_t levelWidth = std::max(width >> level, 1u);
+                const std::uint32_t levelHeight = std::max(height >> level, 1u);
+                if (level > 0)
+                {
+                    texels = downsample(texels, std::max(width >> (level - 1), 1u), std::max(height >> (level - 1), 1u));
+                }
+
+                for (std::uint32_t tileY = 0; tileY < levelHeight; tileY += tileSize)
+                {
+                    for (std::uint32_t tileX = 0; tileX < levelWidth; tileX += tileSize)
+                    {
+                        for (std::uint32_t y = 0; y < tileSize; ++y)
+                        {
+                            const std::uint32_t sourceY = std::min(tileY + y, levelHeight - 1);
+                            for (std::uint32_t x = 0; x < tileSize; ++x)
+                            {
+                                const std::uint32_t sourceX = std::min(tileX + x, levelWidth - 1);
+                                const auto bytes = toBytes(texels[static_cast<std::size_t>(sourceY) * levelWidth + sourceX]);
+                                std::memcpy(tile.data() + 3 * (static_cast<std::size_t>(y) * tileSize + x), bytes.data(), 3);
+                            }
+                        }
+                        file.write(tile.data(), static_cast<std::streamsize>(tile.size()));
+                    }
+                }
+            }
+
+            if (!file.flush())
+            {
+                std::filesystem::remove(temporaryPath);
+                throw std::runtime_error("TextureFile: cannot write " + temporaryPath);
+            }
+        }
+        std::filesystem::rename(temporaryPath, path);
+    }
+
+    // Converts a PPM image, P3 or P6 with 8-bit channels, into a texture file
+    template <std::floating_point T = double>
+    static void convertPPM(const std::string &ppmPath, const std::string &path, std::uint32_t tileSize = s_defaultTileSize)
+    {
+        std::ifstream in(ppmPath, std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("TextureFile: cannot open " + ppmPath);
+        }
+
+        const auto readNumber = [&]
+        {
+            // Header fields are separated by whitespace and comments
+            in >> std::ws;
+            while (in.peek() == '#')
+            {
+                std::string comment;
+                std::getline(in, comment);
+                in >> std::ws;
+            }
+            std::uint32_t value = 0;
+            if (!(in >> value))
+            {
+                throw std::runtime_error("TextureFile: " + ppmPath + " has a malformed header");
+            }
+            return value;
+        };
+
+        std::string magic;
+        in >> magic;
+        if (magic != "P3" && magic != "P6")
+        {
+            throw std::runtime_error("TextureFile: " + ppmPath + " is not a PPM image");
+        }
+        const std::uint32_t width = readNumber();
+        const std::uint32_t height = readNumber();
+        if (readNumber() != 255)
+        {
+            throw std::runtime_error("TextureFile: " + ppmPath + " does not have 8-bit channels");
+        }
+        in.get(); // The single whitespace before binary data
+
+        std::vector<Color<T>> texels(static_cast<std::size_t>(width) * height);
+        for (auto &texel : texels)
+        {
+            std::array<std::uint32_t, 3> bytes{};
+            for (auto &byte : bytes)
+            {
+                byte = (magic == "P6") ? static_cast<std::uint32_t>(in.get()) : readNumber();
+            }
+            if (!in)
+            {
+                throw std::runtime_error("TextureFile: " + ppmPath + " is truncated");
+            }
+            texel = Color<T>(decode<T>(bytes[0]), decode<T>(bytes[1]), decode<T>(bytes[2]));
+        }
+        write(path, width, height, std::move(texels), tileSize);
+    }
+
+    // Linear value of a texel byte, the inverse of toBytes()
+    template <std::floating_point T>
+    static T decode(std::uint32_t byte)
+    {
+        return gammaToLinear((static_cast<T>(byte) + static_cast<T>(0.5)) / 256, static_cast<T>(2.2));
+    }
+
+private:
+    // Offset of the first tile
+    static constexpr std::size_t s_tileAlignment = 64;
+
+    static_assert(sizeof(TextureFileHeader) <= s_tileAlignment);
+
+    static inline std::atomic<std::uint32_t> s_nextId{0};
+
+    // Next level of a pyramid: every texel averages the 2x2 texels it covers, or the texels that
+    // exist where a side is already 1
+    template <std::floating_point T>
+    static std::vector<Color<T>> downsample(const std::vector<Color<T>> &texels, std::uint32_t width, std::uint32_t height)
+    {
+        const std::uint32_t nextWidth = std::max(width / 2, 1u);
+        const std::uint32_t nextHeight = std::max(height / 2, 1u);
+        std::vector<Color<T>> next(static_cast<std::size_t>(nextWidth) * nextHeight);
+        for (std::uint32_t y = 0; y < nextHeight; ++y)
+        {
+            for (std::uint32_t x = 0; x < nextWidth; ++x)
+            {
+                Color<T> sum(0, 0, 0);
+                int count = 0;
+                for (std::uint32_t sourceY = 2 * y; sourceY < std::min(2 * y + 2, height); ++sourceY)
+                {
+                    for (std::uint32_t sourceX = 2 * x; sourceX < std::min(2 * x + 2, width); ++sourceX)
+                    {
+                        sum += texels[static_cast<std::size_t>(sourceY) * width + sourceX];
+                        ++count;
+                    }
+                }
+                next[static_cast<std::size_t>(y) * nextWidth + x] = sum / static_cast<T>(count);
+            }
+        }
+        return next;
+    }
+
+    TextureFileHeader m_header{};
+    std::string m_path;
+    std::uint32_t m_id;
+    int m_fd{-1};
+    std::vector<std::uint32_t> m_firstTiles{}; // Index of the first tile of each level
+};
+
+#endif /* INONEWEEKEND_INCLUDE_TEXTURE_FILE_HPP */
@@ -0,0 +1,151 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_THREAD_POOL_HPP
+#define INONEWEEKEND_INCLUDE_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Render threads that outlive a single render. A long-running process such as the render
+// server hands every frame to the same workers, which saves starting threads and keeps their
+// thread-local buffers allocated and paged in from one frame to the next.
+class ThreadPool
+{
+public:
+    // numThreads counts the calling thread, 0 uses one per hardware thread
+    explicit ThreadPool(int numThreads = 0)
+    {
+        const int total = (numThreads > 0) ? numThreads
+                                           : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        m_workers.reserve(static_cast<std::size_t>(total - 1));
+        for (int i = 1; i < total; ++i)
+        {
+            m_workers.emplace_back([this]
+                                   { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int numThreads() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    // Runs work(false) on every worker and work(true) on the calling thread and returns once
+    // all of them are done, rethrowing the first exception. One run at a time.
+    void run(const std::function<void(bool)> &work)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_work = &work;
+            m_busy = static_cast<int>(m_workers.size());
+            m_error = nullptr;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        std::exception_ptr error;
+        try
+        {
+            work(true);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [this]
+                    { return m_busy == 0; });
+        m_work = nullptr;
+        error = error ? error : m_error;
+        lock.unlock();
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Calls body(i) for every i in [0, count) on all threads and returns once every call is
+    // done. Items are handed out one at a time, so they may differ in cost.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &body)
+    {
+        std::atomic<std::size_t> next{0};
+        run([&](bool)
+            {
+                for (std::size_t i = next++; i < count; i = next++)
+                {
+                    body(i);
+                }
+            });
+    }
+
+private:
+    std::mutex m_mutex{};
+    std::condition_variable m_wake{};
+    std::condition_variable m_done{};
+    const std::function<void(bool)> *m_work{nullptr};
+    std::uint64_t m_generation{0}; // Number of runs started, workers wait for it to change
+    int m_busy{0};
+    bool m_stopping{false};
+    std::exception_ptr m_error{};
+    std::vector<std::jthread> m_workers{}; // Last, so that they are joined before the rest goes
+
+    void workerLoop()
+    {
+        std::uint64_t seen = 0;
+        std::unique_lock lock(m_mutex);
+        for (;;)
+        {
+            m_wake.wait(lock, [&]
+                        { return m_stopping || m_generation != seen; });
+            if (m_stopping)
+            {
+                return;
+            }
+            seen = m_generation;
+            const auto *work = m_work;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try
+            {
+                (*work)(false);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            m_error = m_error ? m_error : error;
+            if (--m_busy == 0)
+            {
+                m_done.notify_all();
+            }
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_THREAD_POOL_HPP */
@@ -0,0 +1,162 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_TONE_MAPPER_HPP
+#define INONEWEEKEND_INCLUDE_TONE_MAPPER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "color.hpp"
+#include "thread_pool.hpp"
+
+// Conversion of linear radiance to 8-bit display values, a row at a time: exposure, a tone
+// mapping operator, the display transfer function and ordered dithering. The channels of a row
+// are processed as one flat float array with straight-line code, so each step runs on full
+// vector registers. The transfer function replaces std::pow with log2 and exp2 polynomials on
+// the float bit pattern; a lookup table would need gathers, which do not vectorize well.
+class ToneMapper
+{
+public:
+    enum class Operator
+    {
+        Clamp,    // Values above one saturate
+        Reinhard, // x / (1 + x)
+        ACES,     // Narkowicz' fit of the ACES filmic curve
+    };
+
+    enum class Transfer
+    {
+        Gamma22, // x^(1 / 2.2), what writeColor applies
+        SRGB,    // Piecewise sRGB curve with a linear toe
+    };
+
+    ToneMapper() = default;
+
+    float exposure() const { return m_exposure; }
+    Operator toneOperator() const { return m_operator; }
+    Transfer transfer() const { return m_transfer; }
+    bool dithering() const { return m_dithering; }
+
+    void setExposure(float stops)
+    {
+        // Scales radiance by 2^stops before tone mapping
+        m_exposure = stops;
+        m_scale = std::exp2(stops);
+    }
+
+    void setOperator(Operator toneOperator)
+    {
+        m_operator = toneOperator;
+    }
+
+    void setTransfer(Transfer transfer)
+    {
+        m_transfer = transfer;
+    }
+
+    void setDithering(bool dithering)
+    {
+        // Adds a 4x4 Bayer pattern below one 8-bit step, which breaks up banding in gradients
+        m_dithering = dithering;
+    }
+
+    // Maps row y of an image to interleaved RGB bytes, out must hold 3 * width bytes
+    template <std::floating_point T>
+    void mapRow(const Color<T> *pixels, std::size_t width, std::size_t y, std::uint8_t *out) const
+    {
+        thread_local std::vector<float> values;
+        values.resize(3 * width);
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            values[3 * i] = static_cast<float>(pixels[i].r());
+            values[3 * i + 1] = static_cast<float>(pixels[i].g());
+            values[3 * i + 2] = static_cast<float>(pixels[i].b());
+        }
+
+        mapValues(values.data(), values.size(), y, out);
+    }
+
+    // Maps numRows row-major rows, the first of them row firstRow of the image, to
+    // 3 * width * numRows bytes. Rows are independent, so bands of them are spread over the
+    // threads of threadPool if there is one.
+    template <std::floating_point T>
+    void mapRows(
+        const Color<T> *pixels,
+        std::size_t width,
+        std::size_t firstRow,
+        std::size_t numRows,
+        std::uint8_t *out,
+        ThreadPool *threadPool = nullptr) const
+    {
+        const auto mapBand = [&](std::size_t band)
+        {
+            const std::size_t end = std::min((band + 1) * s_bandRows, numRows);
+            for (std::size_t y = band * s_bandRows; y < end; ++y)
+            {
+                mapRow(pixels + y * width, width, firstRow + y, out + 3 * y * width);
+            }
+        };
+
+        const std::size_t numBands = (numRows + s_bandRows - 1) / s_bandRows;
+        if (threadPool != nullptr && numBands > 1)
+        {
+            threadPool->parallelFor(numBands, mapBand);
+            return;
+        }
+        for (std::size_t band = 0; band < numBands; ++band)
+        {
+            mapBand(band);
+        }
+    }
+
+    // Whole row-major image, 3 * width * height bytes
+    template <std::floating_point T>
+    std::vector<std::uint8_t> map(const std::vector<Color<T>> &pixels, std::size_t width, ThreadPool *threadPool = nullptr) const
+    {
+        std::vector<std::uint8_t> bytes(3 * pixels.size());
+        if (width > 0)
+        {
+            mapRows(pixels.data(), width, 0, pixels.size() / width, bytes.data(), threadPool);
+        }
+        return bytes;
+    }
+
+    // Display value of a linear value in [0, 1] computed with libm, for checking the polynomials
+    float referenceTransfer(float value) const
+    {
+        if (m_transfer == Transfer::SRGB)
+        {
+            return (value <= 0.0031308f) ? 12.92f * value : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        }
+        return (value > 0) ? std::pow(value, 1.0f / 2.2f) : 0.0f;
+    }
+
+    // Display value of a linear value in [0, 1] as used for the images
+    float fastTransfer(float value) const;
+
+private:
+    float m_exposure{0};
+    float m_scale{1};
+    Operator m_operator{Operator::Clamp};
+    Transfer m_transfer{Transfer::Gamma22};
+    bool m_dithering{false};
+
+    // Rows handed to a thread at a time, enough to hide the cost of handing them out
+    static constexpr std::size_t s_bandRows = 16;
+
+    // Defined in tone_mapper.cpp. The kernels only vectorize once their helpers are inlined,
+    // which a translation unit of their own guarantees regardless of the size of the caller.
+    void mapValues(float *values, std::size_t count, std::size_t y, std::uint8_t *out) const;
+};
+
+#endif /* INONEWEEKEND_INCLUDE_TONE_MAPPER_HPP */
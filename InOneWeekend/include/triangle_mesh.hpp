@@ -0,0 +1,258 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_TRIANGLE_MESH_HPP
+#define INONEWEEKEND_INCLUDE_TRIANGLE_MESH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "aabb.hpp"
+#include "bvh_tree.hpp"
+#include "hittable.hpp"
+#include "interval.hpp"
+#include "material_forward_decl.hpp"
+#include "ray.hpp"
+#include "vector3.hpp"
+#include "wide_bvh.hpp"
+
+// Shared vertex and index buffers of a mesh. A triangle costs three 32-bit vertex indices,
+// and several TriangleMesh instances can reference the same buffers.
+template <std::floating_point T = double>
+struct MeshData
+{
+    using Triangle = std::array<std::uint32_t, 3>;
+
+    std::vector<Point3<T>> vertices{};
+    std::vector<Triangle> triangles{};
+};
+
+template <std::floating_point T = double>
+class TriangleMesh : public Hittable<T>
+{
+public:
+    TriangleMesh(std::shared_ptr<const MeshData<T>> data, std::shared_ptr<Material<T>> material)
+        : m_data(std::move(data)), m_material(material), m_bvh()
+    {
+        if (!m_material)
+        {
+            throw std::invalid_argument("TriangleMesh: null material");
+        }
+        m_bvh.build(BVHTree<T>(triangleBounds(*m_data)));
+    }
+
+    // Over a tree built earlier for the same triangles, e.g. one loaded by BVHCache
+    TriangleMesh(std::shared_ptr<const MeshData<T>> data, std::shared_ptr<Material<T>> material, const BVHTree<T> &bvh)
+        : m_data(std::move(data)), m_material(material), m_bvh()
+    {
+        if (!m_material)
+        {
+            throw std::invalid_argument("TriangleMesh: null material");
+        }
+        if (bvh.primitiveIndices().size() != m_data->triangles.size())
+        {
+            throw std::invalid_argument("TriangleMesh: tree does not match the triangles");
+        }
+        m_bvh.build(bvh);
+    }
+
+    // What the tree over the triangles of a mesh is built from
+    static std::vector<AABB<T>> triangleBounds(const MeshData<T> &data)
+    {
+        std::vector<AABB<T>> bounds;
+        bounds.reserve(data.triangles.size());
+        for (const auto &triangle : data.triangles)
+        {
+            const auto &v0 = data.vertices[triangle[0]];
+            const auto &v1 = data.vertices[triangle[1]];
+            const auto &v2 = data.vertices[triangle[2]];
+            bounds.emplace_back(AABB<T>(v0, v1), AABB<T>(v2, v2));
+        }
+        return bounds;
+    }
+
+    virtual ~TriangleMesh() override = default;
+
+    const MeshData<T> &data() const { return *m_data; }
+    std::size_t numTriangles() const { return m_data->triangles.size(); }
+    const std::shared_ptr<Material<T>> &material() const { return m_material; }
+
+    // Scene edit between frames, see SceneEditor
+    void setMaterial(std::shared_ptr<Material<T>> material)
+    {
+        if (!material)
+        {
+            throw std::invalid_argument("TriangleMesh: null material");
+        }
+        m_material = std::move(material);
+    }
+
+    virtual bool intersect(
+        const Ray<T> &r,
+        Interval<T> rayT,
+        SurfaceHit<T> &surface) const override
+    {
+        const RayShear shear(r);
+
+        return m_bvh.traverse(
+            r, rayT,
+            [&](std::uint32_t triangle, Interval<T> &currentT)
+            {
+                T t;
+                if (!intersectTriangle(r, shear, triangle, currentT, t))
+                {
+                    return false;
+                }
+                surface = SurfaceHit<T>{t, this, triangle};
+                currentT = Interval<T>(currentT.min(), t);
+                return true;
+            });
+    }
+
+    // The normal is only evaluated for the closest triangle
+    virtual void surfaceAttributes(
+        const Ray<T> &r,
+        const SurfaceHit<T> &surface,
+        HitRecord<T> &record) const override
+    {
+        const auto &indices = m_data->triangles[surface.primitive];
+        const auto &v0 = m_data->vertices[indices[0]];
+        const auto &v1 = m_data->vertices[indices[1]];
+        const auto &v2 = m_data->vertices[indices[2]];
+
+        record.setT(surface.t);
+        record.setPoint(r.at(surface.t));
+        record.setNormal(r, unitVector(cross(v1 - v0, v2 - v0)));
+        record.setMaterial(m_material.get());
+        record.setObject(this);
+    }
+
+    virtual bool occluded(
+        const Ray<T> &r,
+        Interval<T> rayT) const override
+    {
+        const RayShear shear(r);
+        return m_bvh.traverseAny(
+            r, rayT,
+            [&](std::uint32_t triangle, const Interval<T> &currentT)
+            {
+                T t;
+                return intersectTriangle(r, shear, triangle, currentT, t);
+            });
+    }
+
+    virtual bool onlyDiffuse() const override { return m_material->isDiffuse(); }
+
+    virtual AABB<T> boundingBox() const override
+    {
+        return m_bvh.bounds();
+    }
+
+private:
+    std::shared_ptr<const MeshData<T>> m_data;
+    std::shared_ptr<Material<T>> m_material;
+    WideBVHTree<T> m_bvh; // Collapsed from the binary tree, which is not kept
+
+    // Per-ray constants of the watertight ray-triangle test (Woop, Benthin and Wald, 2013).
+    // The ray is transformed so that it starts at the origin and points along +z, which makes
+    // the edge tests exact for shared edges and leaves no cracks between adjacent triangles.
+    struct RayShear
+    {
+        explicit RayShear(const Ray<T> &r)
+            : kx(0), ky(0), kz(0), sx(0), sy(0), sz(0)
+        {
+            const auto &d = r.direction();
+
+            // The dimension where the ray direction is maximal becomes the z axis
+            const T ax = std::fabs(d.x());
+            const T ay = std::fabs(d.y());
+            const T az = std::fabs(d.z());
+            kz = (ax > ay) ? (ax > az ? 0 : 2) : (ay > az ? 1 : 2);
+            kx = (kz + 1) % 3;
+            ky = (kx + 1) % 3;
+
+            // Swap kx and ky to preserve the winding direction of triangles
+            if (d[kz] < 0)
+            {
+                std::swap(kx, ky);
+            }
+
+            sx = d[kx] / d[kz];
+            sy = d[ky] / d[kz];
+            sz = static_cast<T>(1.0) / d[kz];
+        }
+
+        int kx, ky, kz;
+        T sx, sy, sz;
+    };
+
+    bool intersectTriangle(
+        const Ray<T> &r,
+        const RayShear &shear,
+        std::uint32_t triangle,
+        const Interval<T> &rayT,
+        T &t) const
+    {
+        const auto &indices = m_data->triangles[triangle];
+        const auto a = m_data->vertices[indices[0]] - r.origin();
+        const auto b = m_data->vertices[indices[1]] - r.origin();
+        const auto c = m_data->vertices[indices[2]] - r.origin();
+
+        // Shear and scale the vertices into ray space
+        const T ax = a[shear.kx] - shear.sx * a[shear.kz];
+        const T ay = a[shear.ky] - shear.sy * a[shear.kz];
+        const T bx = b[shear.kx] - shear.sx * b[shear.kz];
+        const T by = b[shear.ky] - shear.sy * b[shear.kz];
+        const T cx = c[shear.kx] - shear.sx * c[shear.kz];
+        const T cy = c[shear.ky] - shear.sy * c[shear.kz];
+
+        // Scaled barycentric coordinates
+        T u = cx * by - cy * bx;
+        T v = ax * cy - ay * cx;
+        T w = bx * ay - by * ax;
+
+        // Fall back to double precision for edge hits when rendering in single precision
+        if constexpr (sizeof(T) < sizeof(double))
+        {
+            if (u == 0 || v == 0 || w == 0)
+            {
+                u = static_cast<T>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+                v = static_cast<T>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+                w = static_cast<T>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+            }
+        }
+
+        if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0))
+        {
+            return false;
+        }
+
+        const T det = u + v + w;
+        if (det == 0)
+        {
+            return false;
+        }
+
+        // Scaled hit distance, divided by the determinant only once the hit is known
+        const T az = shear.sz * a[shear.kz];
+        const T bz = shear.sz * b[shear.kz];
+        const T cz = shear.sz * c[shear.kz];
+        const T scaledT = u * az + v * bz + w * cz;
+
+        t = scaledT / det;
+        return rayT.surrounds(t);
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_TRIANGLE_MESH_HPP */
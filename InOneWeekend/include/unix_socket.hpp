@@ -0,0 +1,219 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_UNIX_SOCKET_HPP
+#define INONEWEEKEND_INCLUDE_UNIX_SOCKET_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Stream socket in the local (Unix domain) namespace, with the line and fixed-size reads the
+// render server protocol is made of. Errors other than the peer closing the connection throw.
+class UnixSocket
+{
+public:
+    UnixSocket() = default;
+
+    explicit UnixSocket(int fd) : m_fd(fd) {}
+
+    ~UnixSocket()
+    {
+        close();
+    }
+
+    UnixSocket(const UnixSocket &) = delete;
+    UnixSocket &operator=(const UnixSocket &) = delete;
+
+    UnixSocket(UnixSocket &&other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1)), m_buffer(std::move(other.m_buffer))
+    {
+    }
+
+    UnixSocket &operator=(UnixSocket &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_fd = std::exchange(other.m_fd, -1);
+            m_buffer = std::move(other.m_buffer);
+        }
+        return *this;
+    }
+
+    bool isOpen() const { return m_fd >= 0; }
+
+    // Listens at path, replacing a socket file left behind by an earlier server. Any other
+    // file at path is left alone and fails the call.
+    static UnixSocket listen(const std::string &path)
+    {
+        const sockaddr_un address = makeAddress(path);
+        UnixSocket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (!socket.isOpen())
+        {
+            throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+        }
+
+        // Only a socket is replaced, never a file that happens to have the name
+        struct stat status{};
+        if (::lstat(path.c_str(), &status) == 0)
+        {
+            if (!S_ISSOCK(status.st_mode))
+            {
+                throw std::runtime_error("Cannot listen on " + path + ": path exists and is not a socket");
+            }
+            ::unlink(path.c_str());
+        }
+        if (::bind(socket.m_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(socket.m_fd, 16) != 0)
+        {
+            throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(errno));
+        }
+        return socket;
+    }
+
+    static UnixSocket connect(const std::string &path)
+    {
+        const sockaddr_un address = makeAddress(path);
+        UnixSocket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (!socket.isOpen() ||
+            ::connect(socket.m_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            throw std::runtime_error("Cannot connect to " + path + ": " + std::strerror(errno));
+        }
+        return socket;
+    }
+
+    // Waits for the next connection
+    UnixSocket accept() const
+    {
+        for (;;)
+        {
+            const int fd = ::accept(m_fd, nullptr, nullptr);
+            if (fd >= 0)
+            {
+                return UnixSocket(fd);
+            }
+            if (errno != EINTR)
+            {
+                throw std::runtime_error("Cannot accept connection: " + std::string(std::strerror(errno)));
+            }
+        }
+    }
+
+    void sendAll(std::string_view data)
+    {
+        while (!data.empty())
+        {
+            // No SIGPIPE if the peer went away, the error is reported instead
+            const ssize_t sent = ::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::runtime_error("Cannot send: " + std::string(std::strerror(errno)));
+            }
+            data.remove_prefix(static_cast<std::size_t>(sent));
+        }
+    }
+
+    // Next line without its newline, false once the peer has closed the connection
+    bool readLine(std::string &line)
+    {
+        for (std::size_t searched = 0;;)
+        {
+            const auto end = m_buffer.find('\n', searched);
+            if (end != std::string::npos)
+            {
+                line.assign(m_buffer, 0, end);
+                m_buffer.erase(0, end + 1);
+                return true;
+            }
+            searched = m_buffer.size();
+            if (!receive())
+            {
+                return false;
+            }
+        }
+    }
+
+    // Exactly size bytes, false if the connection closes before
+    bool readExact(std::size_t size, std::string &data)
+    {
+        while (m_buffer.size() < size)
+        {
+            if (!receive())
+            {
+                return false;
+            }
+        }
+        data.assign(m_buffer, 0, size);
+        m_buffer.erase(0, size);
+        return true;
+    }
+
+private:
+    int m_fd{-1};
+    std::string m_buffer{}; // Received but not yet consumed
+
+    static sockaddr_un makeAddress(const std::string &path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error("Invalid socket path: " + path);
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return address;
+    }
+
+    bool receive()
+    {
+        char chunk[1 << 16];
+        for (;;)
+        {
+            const ssize_t received = ::recv(m_fd, chunk, sizeof(chunk), 0);
+            if (received > 0)
+            {
+                m_buffer.append(chunk, static_cast<std::size_t>(received));
+                return true;
+            }
+            if (received == 0)
+            {
+                return false;
+            }
+            if (errno != EINTR)
+            {
+                throw std::runtime_error("Cannot receive: " + std::string(std::strerror(errno)));
+            }
+        }
+    }
+
+    void close()
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_UNIX_SOCKET_HPP */
@@ -12,7 +12,7 @@
 #include <limits>
 #include <numbers>
 
-#include "random.hpp"
+#include "sampling.hpp"
 
 namespace Util
 {
@@ -38,19 +38,15 @@ namespace Util
     template <std::floating_point T = double>
     inline T random()
     {
-        using _type = std::uint64_t;
-
-        // Returns a random real in [0, 1) using our global std::mt19937 object
-        constexpr auto low = static_cast<_type>(0);
-        constexpr auto high = std::numeric_limits<_type>::max();
-        const auto r = Random::get(low, high - 1);
-        return static_cast<T>(r) / static_cast<T>(high);
+        // Returns a random real in [0, 1) from the calling thread's counter-based stream,
+        // which the camera keys per pixel sample
+        return Sampling::threadStream<T>().uniform();
     }
 
     template <std::floating_point T = double>
     inline T random(T min, T max)
     {
-        // Returns a random real in [min, max) using our global std::mt19937 object
+        // Returns a random real in [min, max) from the calling thread's stream
         return min + (max - min) * random<T>();
     }
 
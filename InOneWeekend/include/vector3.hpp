@@ -15,6 +15,8 @@
 #include <limits>
 #include <cmath>
 
+#include "fast_math.hpp"
+#include "sampling.hpp"
 #include "util.hpp"
 
 template <std::floating_point T = double>
@@ -30,8 +32,10 @@ public:
 
     Vector3 operator-() const { return Vector3(-m_e[0], -m_e[1], -m_e[2]); }
 
-    constexpr T operator[](int i) const { return m_e[i]; }
-    constexpr T &operator[](int i) { return m_e[i]; }
+    constexpr bool operator==(const Vector3 &) const = default;
+
+    constexpr T operator[](int i) const { return m_e[static_cast<std::size_t>(i)]; }
+    constexpr T &operator[](int i) { return m_e[static_cast<std::size_t>(i)]; }
 
     Vector3 &operator+=(const Vector3 &v)
     {
@@ -175,50 +179,31 @@ inline constexpr Vector3<T> cross(const Vector3<T> &u, const Vector3<T> &v)
 template <std::floating_point T>
 inline constexpr Vector3<T> unitVector(const Vector3<T> &v)
 {
-    return v / v.norm();
+    if constexpr (FastMath::s_enabled)
+    {
+        return FastMath::inverseSqrt(v.squaredNorm()) * v;
+    }
+    else
+    {
+        return v / v.norm();
+    }
 }
 
 template <std::floating_point T>
 inline Vector3<T> randomUnitVector()
 {
-    while (true)
-    {
-        const auto p = Vector3<T>::random(-1.0, 1.0);
-        const T norm = p.squaredNorm();
-
-        // Use constexpr lambda trick to evaluate threshold at compile-time
-        // Threshold depends on the precision of T
-        // Threshold is 1e-160 for double or more precision and 1e-30 for single precision floats
-        constexpr T threshold = []
-        {
-            if constexpr (std::numeric_limits<T>::digits >= std::numeric_limits<double>::digits)
-            {
-                return static_cast<T>(1e-160);
-            }
-            else
-            {
-                return static_cast<T>(1e-30);
-            }
-        }();
-
-        if (threshold < norm && norm <= 1.0)
-        {
-            return p / std::sqrt(norm);
-        }
-    }
+    // Taken from the calling thread's pre-generated block of sphere samples
+    T x, y, z;
+    Sampling::threadStream<T>().unitSphere(x, y, z);
+    return Vector3<T>(x, y, z);
 }
 
 template <std::floating_point T>
 inline Vector3<T> randomInUnitDisk()
 {
-    while (true)
-    {
-        const auto p = Vector3<T>(Util::random<T>(-1, 1), Util::random<T>(-1, 1), 0);
-        if (p.squaredNorm() < 1)
-        {
-            return p;
-        }
-    }
+    T x, y;
+    Sampling::threadStream<T>().unitDisk(x, y);
+    return Vector3<T>(x, y, 0);
 }
 
 template <std::floating_point T>
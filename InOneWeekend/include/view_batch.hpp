@@ -0,0 +1,131 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_VIEW_BATCH_HPP
+#define INONEWEEKEND_INCLUDE_VIEW_BATCH_HPP
+
+#include <concepts>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "camera.hpp"
+#include "image_writer.hpp"
+#include "light_list.hpp"
+#include "render_job.hpp"
+#include "scene_cache.hpp"
+#include "thread_pool.hpp"
+
+// Views of one scene, such as the frames of a turntable or a stereo pair, rendered as one batch:
+// the scene and its acceleration structure are built once and the tiles of all views share the
+// render threads (see Camera::renderViews).
+//
+// The text form is RenderJob lines, with `view <path>` rendering the settings so far into an
+// image at path. Settings carry over to the next view, so a turntable only lists camera
+// positions. Every view must show the same scene. Blank lines and lines starting with `#` are
+// ignored.
+template <std::floating_point T = double>
+class ViewBatch
+{
+public:
+    struct View
+    {
+        RenderJob<T> job;
+        std::string path;
+    };
+
+    // Reads the views of the text form, throws on invalid lines
+    static std::vector<View> parse(std::istream &in)
+    {
+        std::vector<View> views;
+        RenderJob<T> job;
+        std::string line;
+        for (int lineNumber = 1; std::getline(in, line); ++lineNumber)
+        {
+            if (line.empty() || line.front() == '#')
+            {
+                continue;
+            }
+
+            std::istringstream words(line);
+            std::string key;
+            words >> key;
+            if (key == "view")
+            {
+                std::string path;
+                if (!(words >> path))
+                {
+                    throw std::runtime_error("ViewBatch: line " + std::to_string(lineNumber) + " has no output path");
+                }
+                if (!views.empty() && views.front().job.sceneDescription() != job.sceneDescription())
+                {
+                    throw std::runtime_error("ViewBatch: line " + std::to_string(lineNumber) + " changes the scene");
+                }
+                views.push_back(View{job, path});
+                continue;
+            }
+            job.set(line);
+        }
+        return views;
+    }
+
+    static std::vector<View> load(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("ViewBatch: cannot open " + path);
+        }
+        return parse(file);
+    }
+
+    // Builds the scene of the views once and renders all of them on threadPool. The images are
+    // written by the writer's output thread.
+    static void render(const std::vector<View> &views, const std::shared_ptr<ThreadPool> &threadPool)
+    {
+        if (views.empty())
+        {
+            return;
+        }
+
+        SceneCache<T> cache(1);
+        cache.setThreadPool(threadPool);
+        auto origin = SceneCache<T>::Origin::Built;
+        const auto scene = cache.get(views.front().job, origin);
+
+        std::vector<Camera<T>> cameras;
+        cameras.reserve(views.size());
+        for (const auto &view : views)
+        {
+            if (view.job.imageWidth < 1 || view.job.numSamplesPerPixel < 1)
+            {
+                throw std::runtime_error("ViewBatch: width and spp must be positive");
+            }
+            cameras.push_back(view.job.camera(scene->center, scene->extent));
+        }
+
+        auto framebuffers = Camera<T>::renderViews(cameras, scene->bvh, scene->lights, *threadPool);
+
+        ImageWriter<T> writer;
+        for (std::size_t i = 0; i < views.size(); ++i)
+        {
+            const int width = views[i].job.imageWidth;
+            const int height = static_cast<int>(framebuffers[i].size()) / width;
+            writer.submit(typename ImageWriter<T>::Frame{views[i].path, width, height, std::move(framebuffers[i]),
+                                                         views[i].job.format, cameras[i].toneMapper()});
+        }
+        writer.finish();
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_VIEW_BATCH_HPP */
@@ -0,0 +1,530 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#ifndef INONEWEEKEND_INCLUDE_WIDE_BVH_HPP
+#define INONEWEEKEND_INCLUDE_WIDE_BVH_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+#include "aabb.hpp"
+#include "bvh_tree.hpp"
+#include "interval.hpp"
+#include "ray.hpp"
+#include "vector3.hpp"
+
+// A node of a wide hierarchy with the boxes of up to Width children. Each box is stored in
+// 8-bit steps of a grid laid over the node's own box, and the coordinates of all children
+// sit side by side per axis, so that one loop over the lanes tests a ray against every child
+// and compiles to a few vector instructions.
+template <std::size_t Width>
+struct WideBVHNode
+{
+    std::array<float, 3> origin{}; // Grid corner
+    std::array<float, 3> scale{};  // Grid step per axis, a power of two
+    std::array<std::array<std::uint8_t, Width>, 3> lower{};
+    std::array<std::array<std::uint8_t, Width>, 3> upper{};
+    std::array<std::uint32_t, Width> child{}; // Interior: node index. Leaf: first primitive slot
+    std::array<std::uint8_t, Width> count{};  // Primitives of a leaf child, 0 for interior children
+    std::uint8_t numChildren{0};              // Lanes in use, the rest are empty
+};
+
+// Bounding volume hierarchy with Width children per node, made by collapsing a binary SAH
+// tree: each node takes the largest interior descendants of a binary node until it has Width
+// children. Traversal fetches several times fewer nodes, and a node takes 14 bytes per child
+// (Width = 8) instead of the 56 of a binary node.
+//
+// Boxes are quantized outwards and far distances are padded for the rounding of the single
+// precision slab test, so a ray enters a few more boxes than with exact bounds but none less.
+// Primitives are still intersected in the precision of T by the callbacks, so the hits are
+// those of the binary tree (RayTracerBenchmark --wide-bvh compares them).
+template <std::floating_point T = double, std::size_t Width = 8>
+class WideBVHTree
+{
+public:
+    static_assert(Width >= 2 && Width <= 32, "WideBVHTree: child masks are 32 bits");
+
+    using Node = WideBVHNode<Width>;
+
+    WideBVHTree() = default;
+
+    explicit WideBVHTree(const BVHTree<T> &binary)
+    {
+        build(binary);
+    }
+
+    std::span<const Node> nodes() const { return m_nodes; }
+    std::span<const std::uint32_t> primitiveIndices() const { return m_primitiveIndices; }
+
+    std::size_t memoryBytes() const
+    {
+        return m_nodes.capacity() * sizeof(Node) + m_primitiveIndices.capacity() * sizeof(std::uint32_t);
+    }
+
+    AABB<T> bounds() const { return m_bounds; }
+
+    void build(const BVHTree<T> &binary)
+    {
+        const auto binaryNodes = binary.nodes();
+        const auto indices = binary.primitiveIndices();
+
+        m_nodes.clear();
+        m_primitiveIndices.assign(indices.begin(), indices.end());
+        m_bounds = binary.bounds();
+        if (binaryNodes.empty())
+        {
+            return;
+        }
+
+        // A binary tree over n primitives has at most about n / 2 interior nodes, and every
+        // wide node absorbs at least one of them
+        m_nodes.reserve(binaryNodes.size() / (Width - 1) + 1);
+        collapse(binaryNodes, 0);
+        m_nodes.shrink_to_fit();
+    }
+
+    // Same contract as BVHTree::traverse: intersect(primitiveIndex, rayT) for the primitives
+    // of every leaf whose box the ray enters, nearest boxes first, shrinking rayT on a hit
+    template <typename IntersectPrimitive>
+    bool traverse(const Ray<T> &r, Interval<T> rayT, IntersectPrimitive &&intersect,
+                  std::size_t *numNodesVisited = nullptr) const
+    {
+        if (m_nodes.empty())
+        {
+            return false;
+        }
+
+        const RayLanes ray(r);
+        std::array<StackEntry, s_stackSize> stack;
+        std::size_t stackSize = 0;
+        std::uint32_t current = 0;
+
+        const auto tMin = static_cast<float>(rayT.min());
+        float tMax = roundUp(rayT.max());
+        bool hitAnything = false;
+
+        while (true)
+        {
+            if (numNodesVisited != nullptr)
+            {
+                ++*numNodesVisited;
+            }
+
+            const Node &node = m_nodes[current];
+            std::array<float, Width> tNear;
+            std::uint32_t hits = intersectChildren(node, ray, tMin, tMax, tNear);
+
+            // Leaves entered are intersected right away, nearest first. Of the interior children,
+            // the nearest is visited next and the others are pushed, farthest first.
+            std::array<StackEntry, Width> leaves;
+            std::array<StackEntry, Width> entered;
+            std::size_t numLeaves = 0;
+            std::size_t numEntered = 0;
+            while (hits != 0)
+            {
+                const auto lane = static_cast<std::size_t>(std::countr_zero(hits));
+                hits &= hits - 1;
+
+                const StackEntry child{static_cast<std::uint32_t>(lane), tNear[lane]};
+                auto &sorted = node.count[lane] > 0 ? leaves : entered;
+                std::size_t slot = node.count[lane] > 0 ? numLeaves++ : numEntered++;
+                for (; slot > 0 && sorted[slot - 1].tNear < child.tNear; --slot)
+                {
+                    sorted[slot] = sorted[slot - 1];
+                }
+                sorted[slot] = child;
+            }
+
+            for (std::size_t i = numLeaves; i-- > 0 && leaves[i].tNear <= tMax;)
+            {
+                const std::size_t lane = leaves[i].index;
+                for (std::uint32_t k = 0; k < node.count[lane]; ++k)
+                {
+                    if (intersect(m_primitiveIndices[node.child[lane] + k], rayT))
+                    {
+                        hitAnything = true;
+                    }
+                }
+                tMax = roundUp(rayT.max());
+            }
+
+            // Children a hit in a sibling leaf has put out of reach are dropped
+            std::size_t first = 0;
+            while (first < numEntered && entered[first].tNear > tMax)
+            {
+                ++first;
+            }
+
+            if (first < numEntered)
+            {
+                for (std::size_t i = first; i + 1 < numEntered; ++i)
+                {
+                    stack[stackSize++] = StackEntry{node.child[entered[i].index], entered[i].tNear};
+                }
+                current = node.child[entered[numEntered - 1].index];
+                continue;
+            }
+
+            while (stackSize > 0 && stack[stackSize - 1].tNear > tMax)
+            {
+                // Entered behind a hit found since it was pushed
+                --stackSize;
+            }
+            if (stackSize == 0)
+            {
+                break;
+            }
+            current = stack[--stackSize].index;
+        }
+
+        return hitAnything;
+    }
+
+    // Any-hit traversal: returns true as soon as occludes(primitiveIndex, rayT) does
+    template <typename OccludesPrimitive>
+    bool traverseAny(const Ray<T> &r, Interval<T> rayT, OccludesPrimitive &&occludes,
+                     std::size_t *numNodesVisited = nullptr) const
+    {
+        if (m_nodes.empty())
+        {
+            return false;
+        }
+
+        const RayLanes ray(r);
+        std::array<std::uint32_t, s_stackSize> stack;
+        std::size_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        const auto tMin = static_cast<float>(rayT.min());
+        const float tMax = roundUp(rayT.max());
+
+        while (stackSize > 0)
+        {
+            if (numNodesVisited != nullptr)
+            {
+                ++*numNodesVisited;
+            }
+
+            const Node &node = m_nodes[stack[--stackSize]];
+            std::array<float, Width> tNear;
+            std::uint32_t hits = intersectChildren(node, ray, tMin, tMax, tNear);
+            while (hits != 0)
+            {
+                const auto lane = static_cast<std::size_t>(std::countr_zero(hits));
+                hits &= hits - 1;
+
+                if (node.count[lane] == 0)
+                {
+                    stack[stackSize++] = node.child[lane];
+                    continue;
+                }
+                for (std::uint32_t i = 0; i < node.count[lane]; ++i)
+                {
+                    if (occludes(m_primitiveIndices[node.child[lane] + i], rayT))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+private:
+    // Collapsing never makes a path longer, so the depth of the binary trees that BVHTree can
+    // traverse bounds the depth here; each node on the path leaves at most Width - 1 siblings
+    static constexpr std::size_t s_maxDepth = 64;
+    static constexpr std::size_t s_stackSize = s_maxDepth * (Width - 1) + 1;
+
+    static constexpr int s_gridSteps = 255;
+
+    // A child is only opened if it spans at least this fraction of the node's longest axis
+    static constexpr T s_minOpenedFraction = 32;
+
+    // Covers the relative rounding error of a far distance computed in single precision
+    static constexpr float s_farPadding = 1 + 4 * std::numeric_limits<float>::epsilon();
+
+    // No member initializers, so that the traversal stack is not cleared for every ray
+    struct StackEntry
+    {
+        std::uint32_t index; // Node index
+        float tNear;         // Where the ray enters the box
+    };
+
+    // The ray in the precision of the grid. Directions parallel to an axis get a huge but finite
+    // reciprocal, which keeps the slab distances free of infinities and NaNs.
+    struct RayLanes
+    {
+        explicit RayLanes(const Ray<T> &r)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const T direction = r.direction()[axis];
+                const T reciprocal = std::abs(direction) > static_cast<T>(1e-18)
+                                         ? static_cast<T>(1.0) / direction
+                                         : std::copysign(static_cast<T>(1e18), direction);
+                const auto a = static_cast<std::size_t>(axis);
+                origin[a] = static_cast<float>(r.origin()[axis]);
+                invDirection[a] = static_cast<float>(reciprocal);
+                negative[a] = reciprocal < 0;
+            }
+        }
+
+        std::array<float, 3> origin{};
+        std::array<float, 3> invDirection{};
+        std::array<bool, 3> negative{};
+    };
+
+    std::vector<Node> m_nodes{};
+    std::vector<std::uint32_t> m_primitiveIndices{};
+    AABB<T> m_bounds{};
+
+    static float roundUp(T value)
+    {
+        const auto rounded = static_cast<float>(value);
+        return static_cast<T>(rounded) < value ? std::nextafter(rounded, std::numeric_limits<float>::infinity())
+                                               : rounded;
+    }
+
+    // Bit i is set if the ray enters the box of child i within [tMin, tMax]; tNear receives the
+    // entry distances. The slab distance of grid step q is q * a + b per axis. Compilers do not
+    // vectorize the conversion of the 8-bit steps well, so the common widths use intrinsics
+    // when the target has them.
+    static std::uint32_t intersectChildren(const Node &node, const RayLanes &ray, float tMin, float tMax,
+                                           std::array<float, Width> &tNear)
+    {
+        const std::uint32_t lanes = 0xFFFFFFFFu >> (32 - node.numChildren);
+
+#if defined(__AVX2__) && defined(__FMA__)
+        if constexpr (Width == 8)
+        {
+            __m256 near = _mm256_set1_ps(tMin);
+            __m256 far = _mm256_set1_ps(tMax);
+            for (std::size_t axis = 0; axis < 3; ++axis)
+            {
+                const __m256 a = _mm256_set1_ps(node.scale[axis] * ray.invDirection[axis]);
+                const __m256 b = _mm256_set1_ps((node.origin[axis] - ray.origin[axis]) * ray.invDirection[axis]);
+                const __m256 lower = loadSteps(node.lower[axis]);
+                const __m256 upper = loadSteps(node.upper[axis]);
+                const __m256 t0 = _mm256_fmadd_ps(ray.negative[axis] ? upper : lower, a, b);
+                const __m256 t1 = _mm256_mul_ps(_mm256_fmadd_ps(ray.negative[axis] ? lower : upper, a, b),
+                                                _mm256_set1_ps(s_farPadding));
+                near = _mm256_max_ps(near, t0);
+                far = _mm256_min_ps(far, t1);
+            }
+            _mm256_storeu_ps(tNear.data(), near);
+            const auto mask = static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(near, far, _CMP_LE_OQ)));
+            return mask & lanes;
+        }
+#endif
+#if defined(__SSE4_1__)
+        if constexpr (Width == 4)
+        {
+            __m128 near = _mm_set1_ps(tMin);
+            __m128 far = _mm_set1_ps(tMax);
+            for (std::size_t axis = 0; axis < 3; ++axis)
+            {
+                const __m128 a = _mm_set1_ps(node.scale[axis] * ray.invDirection[axis]);
+                const __m128 b = _mm_set1_ps((node.origin[axis] - ray.origin[axis]) * ray.invDirection[axis]);
+                const __m128 lower = loadSteps(node.lower[axis]);
+                const __m128 upper = loadSteps(node.upper[axis]);
+                const __m128 t0 = _mm_add_ps(_mm_mul_ps(ray.negative[axis] ? upper : lower, a), b);
+                const __m128 t1 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ray.negative[axis] ? lower : upper, a), b),
+                                             _mm_set1_ps(s_farPadding));
+                near = _mm_max_ps(near, t0);
+                far = _mm_min_ps(far, t1);
+            }
+            _mm_storeu_ps(tNear.data(), near);
+            const auto mask = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_cmple_ps(near, far)));
+            return mask & lanes;
+        }
+#endif
+
+        std::array<float, Width> tFar;
+        tNear.fill(tMin);
+        tFar.fill(tMax);
+        for (std::size_t axis = 0; axis < 3; ++axis)
+        {
+            const float a = node.scale[axis] * ray.invDirection[axis];
+            const float b = (node.origin[axis] - ray.origin[axis]) * ray.invDirection[axis];
+            const auto &nearPlane = ray.negative[axis] ? node.upper[axis] : node.lower[axis];
+            const auto &farPlane = ray.negative[axis] ? node.lower[axis] : node.upper[axis];
+            for (std::size_t i = 0; i < Width; ++i)
+            {
+                const float t0 = static_cast<float>(nearPlane[i]) * a + b;
+                const float t1 = (static_cast<float>(farPlane[i]) * a + b) * s_farPadding;
+                tNear[i] = t0 > tNear[i] ? t0 : tNear[i];
+                tFar[i] = t1 < tFar[i] ? t1 : tFar[i];
+            }
+        }
+
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < Width; ++i)
+        {
+            mask |= static_cast<std::uint32_t>(tNear[i] <= tFar[i]) << i;
+        }
+        return mask & lanes;
+    }
+
+#if defined(__AVX2__) && defined(__FMA__)
+    static __m256 loadSteps(const std::array<std::uint8_t, 8> &steps)
+    {
+        std::int64_t bytes;
+        std::memcpy(&bytes, steps.data(), sizeof(bytes));
+        return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128(bytes)));
+    }
+#endif
+#if defined(__SSE4_1__)
+    static __m128 loadSteps(const std::array<std::uint8_t, 4> &steps)
+    {
+        std::int32_t bytes;
+        std::memcpy(&bytes, steps.data(), sizeof(bytes));
+        return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+    }
+#endif
+
+    // Emits the wide node for the binary subtree at root and returns its index. Children are
+    // stored after their parent, as in the binary tree.
+    std::uint32_t collapse(std::span<const BVHNode<T>> binary, std::uint32_t root)
+    {
+        const auto index = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+
+        // Open the interior child with the largest surface area, the one most rays enter,
+        // until the node is full. Only a tree that is a single leaf keeps root itself.
+        // Children far smaller than the node stay closed: their own children would get only
+        // a few steps of the node's grid, as the field next to the ground sphere would, and
+        // are better off with a grid of their own one level down.
+        const auto longestExtent = [](const AABB<T> &box)
+        {
+            return box.axisInterval(box.longestAxis()).size();
+        };
+        const T minOpenedExtent = longestExtent(binary[root].bounds) / s_minOpenedFraction;
+
+        std::array<std::uint32_t, Width> children{root};
+        std::size_t numChildren = 1;
+        while (numChildren < Width)
+        {
+            std::size_t best = Width;
+            T bestArea = -1;
+            for (std::size_t c = 0; c < numChildren; ++c)
+            {
+                const auto &candidate = binary[children[c]];
+                if (candidate.count == 0 && candidate.bounds.surfaceArea() > bestArea &&
+                    (children[c] == root || longestExtent(candidate.bounds) >= minOpenedExtent))
+                {
+                    best = c;
+                    bestArea = candidate.bounds.surfaceArea();
+                }
+            }
+            if (best == Width)
+            {
+                break;
+            }
+
+            const auto opened = children[best];
+            children[best] = opened + 1;
+            children[numChildren++] = binary[opened].offset;
+        }
+
+        Node node = quantize(binary, binary[root].bounds, std::span<const std::uint32_t>(children.data(), numChildren));
+        for (std::size_t c = 0; c < numChildren; ++c)
+        {
+            const auto &child = binary[children[c]];
+            if (child.count > 0)
+            {
+                node.child[c] = child.offset;
+                node.count[c] = static_cast<std::uint8_t>(child.count);
+            }
+            else
+            {
+                node.child[c] = collapse(binary, children[c]);
+            }
+        }
+
+        m_nodes[index] = node;
+        return index;
+    }
+
+    // Grid over bounds and the child boxes on it, rounded outwards. The planes are checked in
+    // single precision, so no box ends up smaller than the one it stands for.
+    static Node quantize(std::span<const BVHNode<T>> binary, const AABB<T> &bounds,
+                         std::span<const std::uint32_t> children)
+    {
+        Node node;
+        node.numChildren = static_cast<std::uint8_t>(children.size());
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const auto a = static_cast<std::size_t>(axis);
+            const Interval<T> &extent = bounds.axisInterval(axis);
+
+            // Smallest power of two step that spans the box in s_gridSteps steps
+            int exponent = 0;
+            std::frexp(std::max(extent.size(), std::numeric_limits<T>::min()) / static_cast<T>(s_gridSteps), &exponent);
+            exponent = std::max(exponent, std::numeric_limits<float>::min_exponent);
+
+            while (true)
+            {
+                const float scale = std::ldexp(1.0f, exponent);
+                float origin = static_cast<float>(extent.min());
+                if (static_cast<T>(origin) > extent.min())
+                {
+                    origin = std::nextafter(origin, -std::numeric_limits<float>::infinity());
+                }
+                const auto plane = [&](int q)
+                {
+                    return static_cast<T>(origin + static_cast<float>(q) * scale);
+                };
+
+                if (plane(s_gridSteps) < extent.max())
+                {
+                    // Rounding the origin down lost the last plane, a coarser grid fits
+                    ++exponent;
+                    continue;
+                }
+
+                node.origin[a] = origin;
+                node.scale[a] = scale;
+                for (std::size_t c = 0; c < children.size(); ++c)
+                {
+                    const Interval<T> &box = binary[children[c]].bounds.axisInterval(axis);
+                    int lower = std::clamp(static_cast<int>(std::floor((box.min() - origin) / scale)), 0, s_gridSteps);
+                    int upper = std::clamp(static_cast<int>(std::ceil((box.max() - origin) / scale)), 0, s_gridSteps);
+                    while (lower > 0 && plane(lower) > box.min())
+                    {
+                        --lower;
+                    }
+                    while (upper < s_gridSteps && plane(upper) < box.max())
+                    {
+                        ++upper;
+                    }
+                    node.lower[a][c] = static_cast<std::uint8_t>(lower);
+                    node.upper[a][c] = static_cast<std::uint8_t>(upper);
+                }
+                break;
+            }
+        }
+        return node;
+    }
+};
+
+#endif /* INONEWEEKEND_INCLUDE_WIDE_BVH_HPP */
@@ -7,7 +7,12 @@
 
 #include <iostream>
 #include <concepts>
+#include <cstdlib>
+#include <exception>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 #include "color.hpp"
 #include "vector3.hpp"
@@ -19,11 +24,84 @@
 #include "interval.hpp"
 #include "camera.hpp"
 #include "material.hpp"
+#include "render_server.hpp"
+#include "texture_file.hpp"
+#include "thread_pool.hpp"
+#include "view_batch.hpp"
 
-int main()
+int main(int argc, char *argv[])
 {
     using T = double;
 
+    // Server mode: render jobs sent by RayTracerClient, keeping scenes built between them.
+    // Options: --cache <scenes kept in memory>, --bvh-cache <directory of saved trees>
+    if (argc >= 3 && std::string_view(argv[1]) == "--serve")
+    {
+        try
+        {
+            std::size_t cacheCapacity = 4;
+            std::string bvhDirectory;
+            for (int i = 3; i < argc; i += 2)
+            {
+                const std::string_view option = argv[i];
+                if (i + 1 < argc && option == "--cache")
+                {
+                    cacheCapacity = std::stoull(argv[i + 1]);
+                }
+                else if (i + 1 < argc && option == "--bvh-cache")
+                {
+                    bvhDirectory = argv[i + 1];
+                }
+                else
+                {
+                    // Unknown, or the last argument and missing its value
+                    std::cerr << "Usage: " << argv[0] << " --serve <socket> [--cache <scenes>] [--bvh-cache <directory>]\n";
+                    return EXIT_FAILURE;
+                }
+            }
+            RenderServer<T> server(argv[2], cacheCapacity, 0, bvhDirectory);
+            server.run();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Batch mode: renders the views listed in a file (see ViewBatch) from one build of their
+    // scene, with the tiles of all views sharing the render threads
+    if (argc == 3 && std::string_view(argv[1]) == "--views")
+    {
+        try
+        {
+            ViewBatch<T>::render(ViewBatch<T>::load(argv[2]), std::make_shared<ThreadPool>());
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Converts a PPM image into a tiled, mip-mapped texture file, for `texture <path>` lines of
+    // render jobs (see TextureFile)
+    if (argc == 4 && std::string_view(argv[1]) == "--make-texture")
+    {
+        try
+        {
+            TextureFile::convertPPM<T>(argv[2], argv[3]);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     // World Setup
     HittableList<T> world;
 
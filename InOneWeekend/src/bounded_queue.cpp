@@ -0,0 +1,8 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#include "bounded_queue.hpp"
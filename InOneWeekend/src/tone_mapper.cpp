@@ -0,0 +1,130 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Sparsh Jain
+ *
+ */
+
+#include "tone_mapper.hpp"
+
+#include "fast_math.hpp"
+
+namespace
+{
+    inline float fastPow(float x, float exponent)
+    {
+        // Both sides are evaluated and then selected, so the loops around stay branch free.
+        // Zero and denormals map to zero, which also keeps log2(x) above -100 and the
+        // argument of approxExp2 in range for exponents up to one.
+        const bool positive = (x > 1e-30f);
+        const float power = FastMath::approxExp2(exponent * FastMath::approxLog2(positive ? x : 1));
+        return positive ? power : 0;
+    }
+
+    inline float gamma22(float x)
+    {
+        return fastPow(x, 1 / 2.2f);
+    }
+
+    inline float srgb(float x)
+    {
+        const float curve = 1.055f * fastPow(x, 1 / 2.4f) - 0.055f;
+        return (x <= 0.0031308f) ? 12.92f * x : curve;
+    }
+
+    // Offset in [-0.5, 0.5) of 8-bit steps for pixel x of row y
+    inline float ditherOffset(std::size_t x, std::size_t y)
+    {
+        static constexpr std::array<std::uint8_t, 16> bayer{0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5};
+        return (static_cast<float>(bayer[(y % 4) * 4 + x % 4]) + 0.5f) / 16 - 0.5f;
+    }
+
+    template <ToneMapper::Operator op>
+    void mapChannels(float *values, std::size_t count, std::size_t y, std::uint8_t *out, float scale, bool srgbTransfer, bool dithering)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float x = values[i] * scale;
+            x = (x > 0) ? x : 0;
+            if constexpr (op == ToneMapper::Operator::Reinhard)
+            {
+                x = x / (1 + x);
+            }
+            else if constexpr (op == ToneMapper::Operator::ACES)
+            {
+                x = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+            }
+            values[i] = (x < 1) ? x : 1;
+        }
+
+        // Separate loops per curve keep the selects out of the hot loop
+        if (srgbTransfer)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                values[i] = srgb(values[i]);
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                values[i] = gamma22(values[i]);
+            }
+        }
+
+        if (dithering)
+        {
+            // The pattern repeats every four pixels, one offset per pixel for all channels
+            std::array<float, 12> offsets{};
+            for (std::size_t k = 0; k < offsets.size(); ++k)
+            {
+                offsets[k] = ditherOffset(k / 3, y) / 256;
+            }
+
+            std::size_t i = 0;
+            for (; i + offsets.size() <= count; i += offsets.size())
+            {
+                for (std::size_t k = 0; k < offsets.size(); ++k)
+                {
+                    values[i + k] += offsets[k];
+                }
+            }
+            for (std::size_t k = 0; i + k < count; ++k)
+            {
+                values[i + k] += offsets[k];
+            }
+        }
+
+        // Quantized the same way as writeColor: scaled by 256 and clamped just below 256
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float d = values[i];
+            d = (d > 0) ? d : 0;
+            d = (d < 0.999f) ? d : 0.999f;
+            out[i] = static_cast<std::uint8_t>(static_cast<std::int32_t>(256 * d));
+        }
+    }
+} // namespace
+
+float ToneMapper::fastTransfer(float value) const
+{
+    return (m_transfer == Transfer::SRGB) ? srgb(value) : gamma22(value);
+}
+
+void ToneMapper::mapValues(float *values, std::size_t count, std::size_t y, std::uint8_t *out) const
+{
+    const bool srgbTransfer = (m_transfer == Transfer::SRGB);
+    switch (m_operator)
+    {
+    case Operator::Reinhard:
+        mapChannels<Operator::Reinhard>(values, count, y, out, m_scale, srgbTransfer, m_dithering);
+        break;
+    case Operator::ACES:
+        mapChannels<Operator::ACES>(values, count, y, out, m_scale, srgbTransfer, m_dithering);
+        break;
+    default:
+        mapChannels<Operator::Clamp>(values, count, y, out, m_scale, srgbTransfer, m_dithering);
+        break;
+    }
+}